@@ -0,0 +1,109 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+#ifndef QPAR_ECO_HH
+#define QPAR_ECO_HH
+
+/*!
+ * \file qpar_eco.hh
+ * \author Juexiao Su
+ * \date 21 Feb 2018
+ * \brief incremental placement and routing from a previous result
+ */
+
+#include <string>
+#include <vector>
+
+namespace SYN {
+  class Pin;
+}
+
+class ParNetlist;
+class ParTarget;
+class ParWireTarget;
+class RoutingGraph;
+class RoutingNode;
+class RoutingEdge;
+class RoutePath;
+
+
+/*! \brief engineering change order on a placed and routed netlist
+ *
+ * The netlist is matched against a previous result by name. Elements found in
+ * the previous placement are fixed on their grids so that only new elements are
+ * placed. A previous route is restored if the wire still connects the same pins
+ * and every node of the route still exists in the routing graph of the current
+ * placement, other targets are left for the router.
+ */
+class ParEco {
+
+public:
+  /*! \brief default constructor
+   *  \param ParNetlist* netlist to place and route
+   *  \param ParTarget* hardware target
+   */
+  ParEco(ParNetlist* netlist, ParTarget* target) :
+    _netlist(netlist),
+    _target(target) {}
+
+  /*! \brief fix elements on their grids in a previous placement
+   *  \param std::string placement file written by QPlace::dumpCurrentPlacement
+   *  \return unsigned number of fixed elements
+   */
+  unsigned fixPlacement(const std::string& filename);
+
+  /*! \brief restore the routes of a previous routing result
+   *  \param std::string route file written by QRoute::printAllRoute
+   *  \param RoutingGraph* routing graph of the current placement
+   *  \return unsigned number of restored targets
+   */
+  unsigned restoreRoutes(const std::string& filename, RoutingGraph* graph);
+
+private:
+  /*! \brief name of a pin in the route file
+   */
+  static std::string getPinName(SYN::Pin* pin);
+
+  /*! \brief split a route line into the wire name and the nodes of the route
+   *  \return bool false if the line is not a route
+   */
+  static bool parseRoute(const std::string& line, std::string& wire_name,
+      std::vector<std::string>& tokens);
+
+  /*! \brief find the nodes of a previous route in the current routing graph
+   *  \return RoutePath* NULL if the route is not valid anymore
+   */
+  RoutePath* buildRoutePath(ParWireTarget* target, const std::vector<std::string>& tokens,
+      RoutingGraph* graph) const;
+
+  /*! \brief find the edge between two nodes
+   */
+  static RoutingEdge* findEdge(RoutingNode* node1, RoutingNode* node2);
+
+  /*! \brief find the interaction between two qubits
+   */
+  static RoutingNode* findInteraction(RoutingNode* qubit1, RoutingNode* qubit2);
+
+  ParNetlist* _netlist; //!< netlist to place and route
+  ParTarget* _target; //!< hardware target
+
+};
+
+
+#endif
@@ -0,0 +1,193 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+#ifndef QPAR_GLOBAL_PLACE_HH
+#define QPAR_GLOBAL_PLACE_HH
+
+/*!
+ * \file qpar_global_place.hh
+ * \author Juexiao Su
+ * \date 16 Feb 2018
+ * \brief quadratic global placement and legalization onto grids
+ */
+
+#include "hw_target/hw_loc.hh"
+
+#include <vector>
+
+class ParNetlist;
+class ParTarget;
+class ParElement;
+
+
+/*! \brief symmetric sparse matrix in compressed row format
+ *
+ * Entries are accumulated first and compressed once, every row keeps
+ * a diagonal entry so the diagonal can be changed after compression.
+ */
+class ParSparseMatrix {
+
+public:
+  /*! \brief default constructor
+   *  \param unsigned number of rows
+   */
+  ParSparseMatrix(unsigned size = 0) : _size(size) {}
+
+  /*! \brief add value to an entry, only valid before compress
+   */
+  void addEntry(unsigned row, unsigned col, double val);
+
+  /*! \brief merge the added entries into compressed rows
+   */
+  void compress();
+
+  /*! \brief get number of rows
+   */
+  unsigned size() const { return _size; }
+
+  /*! \brief get the diagonal entry of a row
+   */
+  double& diagonal(unsigned row) { return _values[_diag_index[row]]; }
+  double diagonal(unsigned row) const { return _values[_diag_index[row]]; }
+
+  /*! \brief y = A * x
+   */
+  void multiply(const std::vector<double>& x, std::vector<double>& y) const;
+
+  /*! \brief solve A * x = b with jacobi preconditioned conjugate gradient
+   *  \param std::vector<double>& right hand side
+   *  \param std::vector<double>& initial guess and the solution
+   *  \param double stop when the residual is reduced by this factor
+   *  \param unsigned max number of iterations
+   *  \return unsigned number of iterations
+   */
+  unsigned solve(const std::vector<double>& b, std::vector<double>& x,
+      double tolerance, unsigned max_iter) const;
+
+private:
+  /*! \brief an entry before compression
+   */
+  struct Entry {
+    unsigned row;
+    unsigned col;
+    double val;
+
+    bool operator<(const Entry& rhs) const {
+      return row < rhs.row || (row == rhs.row && col < rhs.col);
+    }
+  };
+
+  unsigned _size; //!< number of rows
+  std::vector<Entry> _entries; //!< added entries
+  std::vector<unsigned> _row_begin; //!< first entry of each row, size + 1
+  std::vector<unsigned> _cols; //!< column of each entry
+  std::vector<double> _values; //!< value of each entry
+  std::vector<unsigned> _diag_index; //!< diagonal entry of each row
+
+};
+
+
+/*! \brief quadratic global placement
+ *
+ * Each wire is a clique of its elements with weight 1/(k-1), so minimizing
+ * the squared wire length is a sparse linear system on x and y. The solution
+ * is spread over a region of the target by recursive bisection, which keeps
+ * the order of elements and makes the density uniform, and every element is
+ * then anchored to its spread location with a growing weight and solved again.
+ * The spread placement with the least half perimeter wire length is written
+ * back to the grids.
+ */
+class ParGlobalPlace {
+
+public:
+  /*! \brief default constructor
+   *  \param ParNetlist* netlist to place, its current placement is the first anchor
+   *  \param ParTarget* hardware target
+   */
+  ParGlobalPlace(ParNetlist* netlist, ParTarget* target);
+
+  /*! \brief default destructor
+   */
+  ~ParGlobalPlace() {}
+
+  /*! \brief replace the current placement with the global placement
+   */
+  void run();
+
+private:
+  ParGlobalPlace(const ParGlobalPlace&); //!< non-copyable
+
+  /*! \brief build the clique laplacian of the netlist
+   */
+  void buildMatrix();
+
+  /*! \brief solve x and y with every element anchored to its spread location
+   *  \param double weight of the anchors
+   */
+  void solve(double anchor_weight);
+
+  /*! \brief spread the solution over the placement region
+   */
+  void spread();
+
+  /*! \brief assign elements [begin, end) of _order to the grids inside a region
+   */
+  void spreadRegion(size_t begin, size_t end, COORD xl, COORD xr, COORD yt, COORD yb);
+
+  /*! \brief get number of placeable grids inside a region, bounds are inclusive
+   */
+  unsigned getCapacity(COORD xl, COORD xr, COORD yt, COORD yb) const;
+
+  /*! \brief half perimeter wire length of the spread placement
+   */
+  double computeWireLength() const;
+
+  /*! \brief move elements to the best spread placement
+   */
+  void commitPlacement();
+
+  ParNetlist* _netlist; //!< netlist to place
+  ParTarget* _target; //!< hardware target
+  COORD _x_limit; //!< number of grids on x direction
+  COORD _y_limit; //!< number of grids on y direction
+
+  std::vector<ParElement*> _elements; //!< elements by index
+  std::vector<std::vector<unsigned> > _wire_elements; //!< element indices of each wire
+  std::vector<unsigned> _capacity; //!< prefix sum of placeable grids, (x_limit+1)*(y_limit+1)
+
+  ParSparseMatrix _matrix; //!< laplacian plus anchors
+  std::vector<double> _laplacian_diag; //!< diagonal of the laplacian without anchors
+
+  std::vector<double> _x; //!< solved x of each element
+  std::vector<double> _y; //!< solved y of each element
+  std::vector<COORD> _spread_x; //!< spread x of each element
+  std::vector<COORD> _spread_y; //!< spread y of each element
+  std::vector<COORD> _best_x; //!< best spread x
+  std::vector<COORD> _best_y; //!< best spread y
+  std::vector<unsigned> _order; //!< element indices sorted during bisection
+
+  COORD _region_xl; //!< placement region
+  COORD _region_xr; //!< placement region
+  COORD _region_yt; //!< placement region
+  COORD _region_yb; //!< placement region
+
+};
+
+
+#endif
@@ -0,0 +1,190 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+#ifndef QPAR_MOVE_HH
+#define QPAR_MOVE_HH
+
+/*!
+ * \file qpar_move.hh
+ * \author Juexiao Su
+ * \date 23 Feb 2018
+ * \brief move generators of the placer and the agent choosing between them
+ */
+
+#include "qpar/qpar_utils.hh"
+#include "hw_target/hw_loc.hh"
+
+#include <vector>
+
+class ParPlaceDB;
+
+
+/*! \brief locations an element can move to, bounds are inclusive
+ */
+struct ParMoveRegion {
+  COORD x_min;
+  COORD x_max;
+  COORD y_min;
+  COORD y_max;
+};
+
+
+/*! \brief a move type of the placer
+ *
+ * A generator proposes a location for an element inside the move region, the
+ * placer checks and evaluates the move.
+ */
+class ParMoveGenerator {
+
+public:
+  virtual ~ParMoveGenerator() {}
+
+  /*! \brief propose a location for an element
+   *  \param ParPlaceDB& current placement
+   *  \param unsigned element to move
+   *  \param ParMoveRegion& locations inside the move radius
+   *  \param RandomGenerator& random numbers of the placer
+   *  \param COORD& x of the location
+   *  \param COORD& y of the location
+   *  \return bool false if there is no location other than the current one
+   */
+  virtual bool propose(const ParPlaceDB& place_db, unsigned element, const ParMoveRegion& region,
+      RandomGenerator& random_gen, COORD& x, COORD& y) = 0;
+
+  /*! \brief get name of the move type
+   */
+  virtual const char* getName() const = 0;
+};
+
+
+/*! \brief uniformly random location inside the region
+ */
+class ParUniformMove : public ParMoveGenerator {
+
+public:
+  bool propose(const ParPlaceDB& place_db, unsigned element, const ParMoveRegion& region,
+      RandomGenerator& random_gen, COORD& x, COORD& y);
+
+  const char* getName() const { return "uniform"; }
+};
+
+
+/*! \brief random location inside the median region of the connected wires
+ *
+ * Each wire contributes both sides of its bounding box without the moved
+ * element, the median of these coordinates minimizes the half perimeter.
+ */
+class ParMedianMove : public ParMoveGenerator {
+
+public:
+  bool propose(const ParPlaceDB& place_db, unsigned element, const ParMoveRegion& region,
+      RandomGenerator& random_gen, COORD& x, COORD& y);
+
+  const char* getName() const { return "median"; }
+
+private:
+  std::vector<COORD> _xs; //!< bounding box sides on x
+  std::vector<COORD> _ys; //!< bounding box sides on y
+};
+
+
+/*! \brief centroid of the connected elements, each wire weighted by 1/(k-1)
+ */
+class ParCentroidMove : public ParMoveGenerator {
+
+public:
+  bool propose(const ParPlaceDB& place_db, unsigned element, const ParMoveRegion& region,
+      RandomGenerator& random_gen, COORD& x, COORD& y);
+
+  const char* getName() const { return "centroid"; }
+};
+
+
+/*! \brief next to a random element of the most expensive connected wire
+ *
+ * If the location is used, the move swaps the two elements along the wire.
+ */
+class ParCriticalMove : public ParMoveGenerator {
+
+public:
+  bool propose(const ParPlaceDB& place_db, unsigned element, const ParMoveRegion& region,
+      RandomGenerator& random_gen, COORD& x, COORD& y);
+
+  const char* getName() const { return "critical"; }
+
+private:
+  std::vector<unsigned> _candidates; //!< other elements of the critical wire
+};
+
+
+/*! \brief choose move types by their recent gain
+ *
+ * Epsilon greedy agent, every move type keeps an exponential average of the
+ * cost decrease of its moves, rejected moves count as no decrease. The move
+ * type with the best average is chosen unless the agent explores.
+ */
+class ParMoveAgent {
+
+public:
+  /*! \brief default constructor
+   */
+  ParMoveAgent() {}
+
+  /*! \brief delete the generators
+   */
+  ~ParMoveAgent();
+
+  /*! \brief add a move type, the agent owns it
+   */
+  void addGenerator(ParMoveGenerator* generator);
+
+  /*! \brief get number of move types
+   */
+  unsigned getGeneratorNum() const { return (unsigned)_generators.size(); }
+
+  /*! \brief get a move type
+   */
+  ParMoveGenerator* getGenerator(unsigned type) const { return _generators[type]; }
+
+  /*! \brief choose a move type, no random number is used with a single type
+   */
+  unsigned select(RandomGenerator& random_gen);
+
+  /*! \brief update the gain of a move type with a evaluated move
+   *  \param unsigned move type
+   *  \param bool true if the move is accepted
+   *  \param double cost change of the move
+   */
+  void update(unsigned type, bool accepted, double delta_cost);
+
+  /*! \brief print the statistic of each move type
+   */
+  void printStat() const;
+
+private:
+  ParMoveAgent(const ParMoveAgent&); //!< non-copyable
+
+  std::vector<ParMoveGenerator*> _generators; //!< move types
+  std::vector<double> _gains; //!< average cost decrease of each move type
+  std::vector<unsigned> _proposed; //!< number of evaluated moves of each move type
+  std::vector<unsigned> _accepted; //!< number of accepted moves of each move type
+};
+
+
+#endif
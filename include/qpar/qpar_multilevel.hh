@@ -0,0 +1,178 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+#ifndef QPAR_MULTILEVEL_HH
+#define QPAR_MULTILEVEL_HH
+
+/*!
+ * \file qpar_multilevel.hh
+ * \author Juexiao Su
+ * \date 19 Feb 2018
+ * \brief multilevel placement on clustered netlists
+ */
+
+#include "qpar/qpar_utils.hh"
+#include "hw_target/hw_loc.hh"
+
+#include <vector>
+
+class ParNetlist;
+class ParTarget;
+class ParElement;
+
+
+/*! \brief one level of the cluster hierarchy
+ *
+ * Clusters are placed on square bins, one cluster per bin. The pitch of
+ * the bins is not rounded to grids so that clusters keep the target density.
+ * Level 0 has one element per cluster and the bins are the grids.
+ */
+struct ParClusterLevel {
+  double pitch; //!< number of grids on each side of a bin
+  COORD bin_num_x; //!< number of bins on x direction
+  COORD bin_num_y; //!< number of bins on y direction
+
+  std::vector<unsigned> sizes; //!< number of elements in each cluster
+  std::vector<unsigned> parents; //!< cluster of the next coarser level, for each cluster
+  std::vector<std::vector<unsigned> > nets; //!< clusters of each net, at least two
+  std::vector<std::vector<unsigned> > cluster_nets; //!< nets of each cluster
+  std::vector<double> net_costs; //!< half perimeter of each net in grids
+
+  std::vector<COORD> x; //!< bin x of each cluster
+  std::vector<COORD> y; //!< bin y of each cluster
+  std::vector<int> bins; //!< cluster in each bin, -1 if empty
+
+  /*! \brief get number of clusters
+   */
+  unsigned size() const { return (unsigned)sizes.size(); }
+
+  /*! \brief get the cluster in a bin
+   */
+  int& bin(COORD bx, COORD by) { return bins[(size_t)(by * bin_num_x + bx)]; }
+};
+
+
+/*! \brief multilevel placement
+ *
+ * Elements are clustered by heavy edge matching until the netlist is small.
+ * The coarsest level is annealed from a random placement on its bins, then
+ * every level is projected to the next finer one, legalized to the nearest free
+ * bin and annealed at a low temperature. Each cluster fills its bin at the
+ * target density, so the half perimeter is enough as cost on coarse levels.
+ * Every level runs a number of moves linear in its clusters. The finest level
+ * is written back to the grids without annealing, QPlace refines it.
+ */
+class ParMultilevelPlace {
+
+public:
+  /*! \brief default constructor
+   *  \param ParNetlist* netlist to place
+   *  \param ParTarget* hardware target
+   *  \param int random seed
+   */
+  ParMultilevelPlace(ParNetlist* netlist, ParTarget* target, int seed);
+
+  /*! \brief delete the levels
+   */
+  ~ParMultilevelPlace();
+
+  /*! \brief replace the current placement with the multilevel placement
+   */
+  void run();
+
+private:
+  ParMultilevelPlace(const ParMultilevelPlace&); //!< non-copyable
+
+  /*! \brief build level 0 from the netlist
+   */
+  void buildFinestLevel();
+
+  /*! \brief build a coarser level from the last level
+   *  \return bool false if the last level does not shrink enough
+   */
+  bool coarsen();
+
+  /*! \brief set the bin pitch and clear the bins of a level
+   */
+  void initializeBins(ParClusterLevel& level, double pitch) const;
+
+  /*! \brief check if a bin has placeable grids
+   */
+  bool isUsableBin(const ParClusterLevel& level, COORD bx, COORD by) const;
+
+  /*! \brief find the free usable bin closest to a bin
+   */
+  void findFreeBin(ParClusterLevel& level, COORD x, COORD y, COORD& bx, COORD& by) const;
+
+  /*! \brief put the clusters of the coarsest level on random bins
+   */
+  void placeRandomly(ParClusterLevel& level);
+
+  /*! \brief place the clusters of a level at the location of their parents
+   */
+  void project(unsigned level_index);
+
+  /*! \brief anneal a level
+   *  \param ParClusterLevel& level to anneal
+   *  \param bool start from a high temperature with the full move radius
+   */
+  void anneal(ParClusterLevel& level, bool from_random);
+
+  /*! \brief try to move a cluster
+   *  \return bool true if the move is accepted
+   */
+  bool tryMove(ParClusterLevel& level, Annealer& annealer, double& total_cost);
+
+  /*! \brief half perimeter of a net in grids
+   */
+  double computeNetCost(const ParClusterLevel& level, unsigned net) const;
+
+  /*! \brief recompute the cost of every net
+   */
+  double computeTotalCost(ParClusterLevel& level) const;
+
+  /*! \brief get number of placeable grids inside a region, bounds are inclusive
+   */
+  unsigned getCapacity(COORD xl, COORD xr, COORD yt, COORD yb) const;
+
+  /*! \brief move elements to the bins of level 0
+   */
+  void commitPlacement();
+
+  ParNetlist* _netlist; //!< netlist to place
+  ParTarget* _target; //!< hardware target
+  COORD _x_limit; //!< number of grids on x direction
+  COORD _y_limit; //!< number of grids on y direction
+
+  std::vector<ParElement*> _elements; //!< elements by index
+  std::vector<unsigned> _capacity; //!< prefix sum of placeable grids, (x_limit+1)*(y_limit+1)
+  double _density; //!< target density of the clusters
+  std::vector<ParClusterLevel*> _levels; //!< levels from fine to coarse
+
+  std::vector<unsigned> _net_stamp; //!< stamp of nets visited by the current move
+  unsigned _stamp; //!< stamp of the current move
+  std::vector<unsigned> _moved_nets; //!< nets affected by the current move
+  std::vector<double> _moved_costs; //!< cost of the affected nets before the move
+
+  RandomGenerator _random_gen; //!< random numbers of clustering and moves
+
+};
+
+
+#endif
@@ -0,0 +1,98 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+#ifndef QPAR_MULTISTART_HH
+#define QPAR_MULTISTART_HH
+
+/*!
+ * \file qpar_multistart.hh
+ * \author Juexiao Su
+ * \date 06 Mar 2018
+ * \brief independent placements from different seeds, the best one is kept
+ */
+
+#include "qpar/qpar_place.hh"
+
+#include <vector>
+#include <string>
+
+namespace SYN {
+  class Model;
+}
+
+class HW_Target_Dwave;
+class ParNetlist;
+class ParTarget;
+class ParThreadPool;
+
+
+/*! \brief multi-start placement engine
+ *
+ * Each start is a QPlace over its own ParNetlist and ParTarget with its own
+ * move seed and initial grid order, so the starts follow independent annealing
+ * trajectories. Starts are initialized on the calling thread and annealed on a
+ * thread pool without logging. Start 0 uses the netlist and target of the system
+ * and receives the placement with the lowest final cost.
+ */
+class ParMultiStart {
+
+public:
+  /*! \brief default constructor
+   *  \param SYN::Model* model to build the netlist copies
+   *  \param HW_Target_Dwave* hardware to build the target copies
+   *  \param ParNetlist* netlist of the system
+   *  \param ParTarget* target of the system
+   *  \param PlaceOption placement options
+   */
+  ParMultiStart(SYN::Model* model, HW_Target_Dwave* hw_target,
+      ParNetlist* netlist, ParTarget* target, const PlaceOption& option);
+
+  /*! \brief delete the start copies
+   */
+  ~ParMultiStart();
+
+  /*! \brief execute placement
+   */
+  void run();
+
+  /*! \brief print placement of the system netlist
+   */
+  void dumpCurrentPlacement(std::string filename) const;
+
+private:
+  ParMultiStart(const ParMultiStart&); //!< non-copyable
+
+  /*! \brief anneal the starts assigned to one thread
+   */
+  void optimizeStarts(unsigned thread_id);
+
+  SYN::Model* _model; //!< model from synthesis
+  HW_Target_Dwave* _hw_target; //!< hardware target
+  PlaceOption _option; //!< placement options
+
+  std::vector<ParNetlist*> _netlists; //!< netlist of each start, the first one is not owned
+  std::vector<ParTarget*> _targets; //!< target of each start, the first one is not owned
+  std::vector<QPlace*> _placers; //!< placer of each start
+
+  ParThreadPool* _thread_pool; //!< threads that anneal the starts
+
+};
+
+
+#endif
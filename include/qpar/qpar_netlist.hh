@@ -124,10 +124,12 @@ public:
   /*! \brief get bounding box
    */
   Box& getBoundBox() { return _bound; }
+  const Box& getBoundBox() const { return _bound; }
 
   /*! \brief get edge number box
    */
   Box& getEdgeBox() { return _edge_num; }
+  const Box& getEdgeBox() const { return _edge_num; }
 
   bool operator==(const BoundingBox& rhs) const {
     return (this->_bound == rhs._bound &&
@@ -170,6 +172,10 @@ public:
   WIRE_ITER wire_begin() { return _wires.begin(); }
   WIRE_ITER wire_end() { return _wires.end(); }
 
+  /*! \brief get all wires that connect more than one element
+   */
+  ParWireSet& getWires() { return _wires; }
+
 
   WIRE_ITER model_wire_begin() { return _model_wires.begin(); }
   WIRE_ITER model_wire_end() { return _model_wires.end(); }
@@ -190,10 +196,18 @@ public:
    */
   std::vector<ParWireTarget*>& getTargets() { return _all_targets; }
 
+  /*! \brief rip up and delete the route of every target, call before the routing graph is deleted
+   */
+  void clearRoutes();
+
   /*! \brief get total number element in the netlist
    */
   size_t getElementNumber() const { return _elements.size(); }
 
+  /*! \brief get netlist from synthesis
+   */
+  SYN::Model* getSynNetlist() const { return _syn_netlist; }
+
 
 private:
   /*! \brief build netlist for placement and routing
@@ -351,6 +365,9 @@ public:
     return _elements.size();
   }
 
+  ELE_ITER element_begin() { return _elements.begin(); }
+  ELE_ITER element_end() { return _elements.end(); }
+
   /*! \brief build necessary wire data structure
    *  \function buildParWire()
    *  \return std::vector<ParWireTarget*> return target vector
@@ -369,10 +386,9 @@ public:
 
   std::string getName() const;
 
-  /*! \brief incrementally update bounding box
+  /*! \brief get net from synthesis model
    */
-  void updateBoundingBox(COORD from_x, COORD from_y, COORD to_x, COORD to_y);
-
+  SYN::Net* getSynNet() const { return _net; }
 
   /*! \brief get current cost
    *  \return double cost
@@ -443,6 +459,10 @@ public:
    */
   void unmarkUsedRoutingResource();
 
+  /*! \brief get targets on the wire
+   */
+  std::vector<ParWireTarget*>& getTargets() { return _targets; }
+
   /*! \brief get all used routing nodes
    */
   std::unordered_set<RoutingNode*>& getUsedRoutingNodes() { return _routing_nodes; }
@@ -483,6 +503,10 @@ private:
    */
   void recomputeBoundingBox();
 
+  /*! \brief compute bounding box from all elements
+   */
+  BoundingBox computeBoundingBox() const;
+
 
   SYN::Net* _net; //!< net from synthesis model
   std::vector<ParWireTarget*> _targets; //!< targets on the wire
@@ -533,6 +557,10 @@ public:
    */
   bool isMovable() const { return _movable; }
 
+  /*! \brief fix or release the element, a fixed element keeps its grid in placement
+   */
+  void setMovable(bool movable) { _movable = movable; }
+
   /*! \brief set the grid that will have this element
    */
   void setGrid(ParGrid* grid);
@@ -0,0 +1,157 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+#ifndef QPAR_OCCUPANCY_HH
+#define QPAR_OCCUPANCY_HH
+
+/*!
+ * \file qpar_occupancy.hh
+ * \author Juexiao Su
+ * \date 05 Feb 2018
+ * \brief data structures to count the used grids in a rectangle during placement
+ */
+
+#include "qpar/qpar_matrix.hh"
+#include "hw_target/hw_loc.hh"
+
+#include <string>
+
+class ParTarget;
+
+
+/*! \brief interface of used grid counter
+ *
+ * The placer moves one element at a time and the placement cost asks
+ * for the number of used grids inside the bounding box of each wire.
+ */
+class ParOccupancy {
+
+public:
+  /*! \brief type of occupancy data structure
+   */
+  enum OCCUPANCY_TYPE {OCCUPANCY_PREFIX, OCCUPANCY_FENWICK};
+
+  /*! \brief default constructor
+   *  \param unsigned number of grids on x direction
+   *  \param unsigned number of grids on y direction
+   */
+  ParOccupancy(unsigned x, unsigned y) : _maxX(x), _maxY(y) {}
+
+  virtual ~ParOccupancy() {}
+
+  /*! \brief count used grids of the target from scratch
+   */
+  virtual void build(const ParTarget& target) = 0;
+
+  /*! \brief an element moves from a grid to an empty grid
+   *  \param COORD from x coord
+   *  \param COORD from y coord
+   *  \param COORD to x coord
+   *  \param COORD to y coord
+   */
+  virtual void moveElement(COORD from_x, COORD from_y, COORD to_x, COORD to_y) = 0;
+
+  /*! \brief get number of used grids in a rectangle, bounds are inclusive
+   */
+  virtual unsigned getUsedCell(unsigned xl, unsigned yt, unsigned xr, unsigned yb) const = 0;
+
+  /*! \brief get number of used grids between (0,0) and (x,y)
+   */
+  unsigned getUsedCell(unsigned x, unsigned y) const {
+    return getUsedCell(0, 0, x, y);
+  }
+
+  /*! \brief get the x size
+   */
+  unsigned getSizeX() const { return _maxX; }
+
+  /*! \brief get the y size
+   */
+  unsigned getSizeY() const { return _maxY; }
+
+  /*! \brief create occupancy by type
+   */
+  static ParOccupancy* create(OCCUPANCY_TYPE type, unsigned x, unsigned y);
+
+  /*! \brief convert name to type
+   *  \return bool false if name is unknown
+   */
+  static bool getType(const std::string& name, OCCUPANCY_TYPE& type);
+
+  /*! \brief get name of type
+   */
+  static const char* getTypeName(OCCUPANCY_TYPE type);
+
+protected:
+  unsigned _maxX; //!< number of grids on x direction
+  unsigned _maxY; //!< number of grids on y direction
+
+};
+
+
+/*! \brief 2D prefix sum matrix
+ *
+ * A rectangle query is four lookups, but a move updates every cell
+ * to the right and below the moved element, O(X*Y) in the worst case.
+ */
+class PrefixOccupancy : public ParOccupancy {
+
+public:
+  PrefixOccupancy(unsigned x, unsigned y) : ParOccupancy(x, y),
+    _used_matrix(x, y) {}
+
+  virtual void build(const ParTarget& target);
+  virtual void moveElement(COORD from_x, COORD from_y, COORD to_x, COORD to_y);
+  virtual unsigned getUsedCell(unsigned xl, unsigned yt, unsigned xr, unsigned yb) const;
+
+private:
+  qpr_matrix<unsigned> _used_matrix; //!< a matrix inidicate the number of used cell
+
+};
+
+
+/*! \brief 2D binary indexed tree
+ *
+ * Both a move and a rectangle query cost O(log X * log Y).
+ */
+class FenwickOccupancy : public ParOccupancy {
+
+public:
+  FenwickOccupancy(unsigned x, unsigned y) : ParOccupancy(x, y),
+    _tree(x + 1, y + 1) {}
+
+  virtual void build(const ParTarget& target);
+  virtual void moveElement(COORD from_x, COORD from_y, COORD to_x, COORD to_y);
+  virtual unsigned getUsedCell(unsigned xl, unsigned yt, unsigned xr, unsigned yb) const;
+
+private:
+  /*! \brief add value to a grid
+   */
+  void add(unsigned x, unsigned y, int val);
+
+  /*! \brief sum of grids between (0,0) and (x-1,y-1)
+   */
+  int prefix(unsigned x, unsigned y) const;
+
+  qpr_matrix<int> _tree; //!< one based binary indexed tree
+
+};
+
+
+#endif
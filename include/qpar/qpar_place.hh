@@ -20,13 +20,17 @@
 #ifndef QPAR_PLACE_HH
 #define QPAR_PLACE_HH
 
-#include "qpar/qpar_matrix.hh"
 #include "qpar/qpar_utils.hh"
 #include "qpar/qpar_netlist.hh"
+#include "qpar/qpar_occupancy.hh"
+#include "qpar/qpar_place_cost.hh"
+#include "qpar/qpar_schedule.hh"
 
 #include "hw_target/hw_loc.hh"
 
 #include <vector>
+#include <string>
+#include <unordered_map>
 
 
 /*!
@@ -43,8 +47,88 @@ namespace SYN {
 class Grid;
 class ParNetlist;
 class ParTarget;
-class PlacementCost;
 class ParElement;
+class ParPlaceDB;
+class ParWireIndex;
+class ParPlaceTiming;
+class ParRouteCongestion;
+class ParThreadPool;
+class ParMoveAgent;
+
+
+/*! \brief user options of placement, set by place command
+ */
+struct PlaceOption {
+  /*! \brief how the initial placement is built
+   */
+  enum INIT_TYPE {INIT_RANDOM, INIT_QUADRATIC, INIT_MULTILEVEL};
+
+  /*! \brief how move locations are generated
+   */
+  enum MOVE_TYPE {MOVES_UNIFORM, MOVES_ADAPTIVE};
+
+  ParOccupancy::OCCUPANCY_TYPE occupancy; //!< data structure to count used grids
+  unsigned threads; //!< number of threads to evaluate moves
+  int seed; //!< random seed of move generation and acceptance
+  unsigned replicas; //!< number of parallel tempering replicas, 1 for a single annealing chain
+  unsigned starts; //!< number of independent placements, the best one is kept
+  unsigned shuffle_seed; //!< seed of the grid order of the random initial placement
+  INIT_TYPE init; //!< initial placement, annealing only refines it unless it is random
+  std::string eco_file; //!< previous placement, elements found in it keep their grids
+  float warm_t; //!< anneal the current placement from this temperature, 0 to place from scratch
+  float refine_t; //!< anneal the current placement from this fraction of the cost per wire, 0 to use warm_t
+  MOVE_TYPE moves; //!< uniform moves only, or directed moves chosen by their gain
+  bool scalar_cost; //!< evaluate wire costs one at a time with std::pow, to validate the batched kernels
+  double timing; //!< extra cost weight of the most critical wire, 0 to ignore timing
+  ParSchedule::SCHEDULE_TYPE schedule; //!< cooling, moves per temperature and exit of annealing
+  double budget; //!< seconds of annealing for the budget schedule
+
+  PlaceOption() :
+    occupancy(ParOccupancy::OCCUPANCY_PREFIX),
+    threads(1),
+    seed(2),
+    replicas(1),
+    starts(1),
+    shuffle_seed(0),
+    init(INIT_RANDOM),
+    warm_t(0.0f),
+    refine_t(0.0f),
+    moves(MOVES_UNIFORM),
+    scalar_cost(false),
+    timing(0.0),
+    schedule(ParSchedule::SCHEDULE_DEFAULT),
+    budget(0.0) {}
+};
+
+
+typedef std::unordered_map<std::string, std::pair<COORD, COORD> > PLACE_LOCS;
+
+
+/*! \brief a move evaluated against the placement at the beginning of a batch
+ */
+struct PlaceMove {
+  unsigned element; //!< element to move
+  COORD from_x; //!< current x of the element
+  COORD from_y; //!< current y of the element
+  COORD to_x; //!< target x
+  COORD to_y; //!< target y
+  int tgt_element; //!< element on the target grid, -1 if the grid is empty
+  unsigned move_type; //!< move generator of the move
+
+  std::vector<unsigned> wires; //!< all affected wires
+  std::vector<BoundingBox> boxes; //!< bounding box of each affected wire after the move
+  std::vector<double> costs; //!< cost of each affected wire after the move
+  size_t moved_wire_num; //!< the first moved_wire_num wires connect to the moved elements
+  double delta_cost; //!< total cost change of the move
+
+  PlaceMove() :
+    element(0),
+    from_x(0), from_y(0), to_x(0), to_y(0),
+    tgt_element(-1),
+    move_type(0),
+    moved_wire_num(0),
+    delta_cost(0.0) {}
+};
 
 
 class QPlace {
@@ -54,12 +138,28 @@ public:
   /*! \brief default constructor for Place
    *  \param ParNetlist* netlist used in placement and routing
    *  \param ParTarget* hardware target to describe device
+   *  \param PlaceOption placement options
    */
-  QPlace(ParNetlist* netlist, ParTarget* hw_target) :
+  QPlace(ParNetlist* netlist, ParTarget* hw_target, const PlaceOption& option = PlaceOption()) :
    _netlist(netlist),
    _hw_target(hw_target),
+   _option(option),
+   _occupancy(NULL),
+   _random_gen(option.seed),
    _annealer(NULL),
+   _move_agent(NULL),
    _placement_cost(NULL),
+   _timing(NULL),
+   _route_congestion(NULL),
+   _place_db(NULL),
+   _moved_wire_num(0),
+   _wire_index(NULL),
+   _thread_pool(NULL),
+   _batch_move_num(0),
+   _move_stamp(0),
+   _batch_stamp(0),
+   _stale_move_num(0),
+   _refresh_move_num(0),
    _current_total_cost(0.0) {
   }
 
@@ -76,11 +176,70 @@ public:
    */
   void run();
 
+  /*! \brief build the initial placement and its cost
+   */
+  void initialize();
+
+  /*! \brief anneal the initial placement with the schedule until it exits
+   */
+  void optimize();
+
+  /*! \brief try moves at a fixed temperature, the move radius adapts to the success rate
+   *  \param float temperature
+   *  \param int number of moves
+   *  \return unsigned number of accepted moves
+   */
+  unsigned anneal(float temperature, int num_move);
+
+  /*! \brief write the placement back to the grids, elements and wires
+   */
+  void finish();
+
+  /*! \brief copy the placement of another placer built from the same model
+   */
+  void copyPlacement(const QPlace& placer);
+
+  /*! \brief penalize wires over grids that were congested in routing, call before initialize
+   *  \param ParRouteCongestion* congestion of failed routings, not owned
+   */
+  void setRouteCongestion(const ParRouteCongestion* congestion) { _route_congestion = congestion; }
+
+  /*! \brief get number of moves tried at each temperature
+   */
+  int getMoveLimit() const;
+
+  /*! \brief get current total cost
+   */
+  double getTotalCost() const { return _current_total_cost; }
+
+  /*! \brief get the number of wires in the placed netlist
+   */
+  size_t getWireNum() const { return _netlist->getWireNum(); }
+
+  /*! \brief get move radius
+   */
+  float getRLimit() const { return _annealer->getRLimit(); }
+
+  /*! \brief set move radius
+   */
+  void setRLimit(float r_limit) { _annealer->setRLimit(r_limit); }
+
+  /*! \brief get initial annealing temperature based on random experiments
+   */
+  float getStartingT();
+
   /*! \brief print current placement
    *  \param std::string filename for outfile 
    */
   void dumpCurrentPlacement(std::string filename = "current.place") const;
 
+  /*! \brief read the location of each element from a file written by dumpCurrentPlacement
+   *  \param std::string placement file
+   *  \param PLACE_LOCS& element name to location
+   *  \return bool false if the file cannot be opened
+   */
+  static bool readPlacement(const std::string& filename, PLACE_LOCS& locations);
+
   void dumpUsedMatrix(std::string file = "current.usedmatrix") const;
 
   /*! \brief performe sanity check for bounding box and utilization map
@@ -91,21 +250,17 @@ private:
 
   ParNetlist* _netlist; //<! netlist to specify input problem
   ParTarget* _hw_target; //<! hardware target
+  PlaceOption _option; //!< placement options
 
-  /*! \brief initilize placement by random assign element to each grid
+  /*! \brief check if the current placement is annealed instead of placed from scratch
    */
-  void initializePlacement();
+  bool isWarmStart() const { return _option.warm_t > 0.0f || _option.refine_t > 0.0f; }
 
-  /*! \brief incremental update use matrix
-   *  \param COORD from x coord
-   *  \param COORD from y coord
-   *  \param COORD to x coord
-   *  \param COORD to x coord
-   *  \return void
+  /*! \brief initilize placement by random assign element to each grid
    */
-  void updateUseMatrix(COORD from_x, COORD from_y, COORD to_x, COORD to_y);
+  void initializePlacement();
 
-  qpr_matrix<unsigned>* _used_matrix; //!< a matrix inidicate the number of used cell
+  ParOccupancy* _occupancy; //!< count the number of used cell in a rectangle
 
   /*! \brief check all used matrix
    *  \return void
@@ -117,10 +272,6 @@ private:
    */
   void usedMatrixSanityCheck(unsigned x, unsigned y);
 
-  /*! \brief check if the placer is ready to move
-   */
-  void checkIfReadyToMove();
-
   /*! \brief move a random element to a random place
    */
   bool tryMove();
@@ -135,7 +286,7 @@ private:
 
   /*! \brief restore to previous status
    */
-  void restoreMove(COORD from_x, COORD from_y, COORD to_x, COORD to_y, bool is_swap);
+  void restoreMove(COORD from_x, COORD from_y, COORD to_x, COORD to_y);
 
   /*! \brief compute the cost for a give placement
    *  \param bool set_wire_cost, whether to update each wire's cost
@@ -143,30 +294,114 @@ private:
    */
   double computeTotalCost(bool set_wire_cost);
 
-  /*! \brief get initial annealing temperature based on random experiments
+  /*! \brief add a wire with its current bounding box to _cost_batch
    */
-  float getStartingT();
+  void addCostWire(unsigned wire);
 
-  std::vector<ParElement*> _movable_elements; //!< a vector container to store all movable element
+  /*! \brief get cost weight of a wire from its criticality and the routing congestion
+   *         in its bounding box, 1 without timing and congestion
+   */
+  double getWireWeight(unsigned wire, const Box& bbox) const;
 
-  void generateMove(ParElement* &element, COORD& x, COORD& y);
+  /*! \brief recompute the wire criticalities from the current placement and the total cost
+   */
+  void updateTiming();
+
+  std::vector<unsigned> _movable_elements; //!< a vector container to store all movable element
+
+  /*! \brief pick a random element and a location from the move agent
+   *  \param unsigned& element to move
+   *  \param COORD& x of the location
+   *  \param COORD& y of the location
+   *  \param unsigned& move type that generated the location
+   */
+  void generateMove(unsigned& element, COORD& x, COORD& y, unsigned& move_type);
 
-  /*! \brief given the source element and the destination coordinate collect all affected wires and elements
+  /*! \brief given the source element and the destination coordinate move the elements
+   *         and collect all affected wires
    */
-  void findAffectedElementsAndWires(ParElement* element, COORD x, COORD y);
+  void findAffectedElementsAndWires(unsigned element, COORD x, COORD y);
 
   double getStdDev(unsigned num, double ave, double s_square) const;
 
+  /*! \brief generate a batch of moves, evaluate them in parallel and commit them in order
+   *  \param unsigned number of moves in the batch
+   *  \param double& sum of total cost after each accepted move
+   *  \param double& sum of squared total cost after each accepted move
+   *  \return unsigned number of accepted moves
+   */
+  unsigned tryMoveBatch(unsigned num_move, double& cost_sum, double& cost_square_sum);
+
+  /*! \brief evaluate the moves of the batch assigned to one thread
+   */
+  void evaluateBatch(unsigned thread_id);
+
+  /*! \brief compute the affected wires, their new bounding boxes and costs of a move
+   *
+   * The placement is not changed, so different moves can be evaluated in parallel.
+   */
+  void evaluateMove(PlaceMove& move) const;
+
+  /*! \brief predict the bounding box of a wire connected to the moved elements
+   */
+  BoundingBox predictBoundingBox(const PlaceMove& move, unsigned wire) const;
+
+  /*! \brief compute the cost of an affected wire after the move
+   *  \param PlaceMove& move
+   *  \param size_t index of the wire in the move
+   */
+  double computeMoveCost(const PlaceMove& move, size_t index) const;
+
+  /*! \brief bring a move up to date with the moves accepted earlier in the batch
+   *
+   * Affected wires whose bounding box or utilization changed get their cost recomputed,
+   * wires that grew over one of the grids are added. If the element or the target grid
+   * changed, the move is not refreshed.
+   *  \return bool false if the move has to be evaluated again
+   */
+  bool refreshMove(PlaceMove& move);
+
+  /*! \brief commit an evaluated move to the placement
+   */
+  void applyMove(const PlaceMove& move);
+
+  /*! \brief get index of a grid in _grid_stamp
+   */
+  size_t gridIndex(COORD x, COORD y) const;
+
   RandomGenerator _random_gen; //!< a random nubmer generator
 
   Annealer* _annealer; //!< a annealer manager
 
-  PlacementCost* _placement_cost; //!< placement cost 
-
-  std::vector<ParElement*> _affected_elements; //!< a container to store the affected elemnts
-  ParWireSet _affected_wires; //!< a container to store the affected wires
+  ParMoveAgent* _move_agent; //!< move types used by generateMove
 
-  std::vector<ParGrid*> _affected_grids; //!< a container to store the affected grids
+  PlacementCost* _placement_cost; //!< placement cost 
+  PlaceCostBatch _cost_batch; //!< wires whose costs are computed together
+  ParPlaceTiming* _timing; //!< wire criticalities, NULL if timing is ignored
+  const ParRouteCongestion* _route_congestion; //!< congestion of failed routings, NULL if not routed
+
+  ParPlaceDB* _place_db; //!< element locations, wire bounding boxes and costs during placement
+
+  std::vector<unsigned> _affected_wires; //!< a container to store the affected wires
+  std::vector<BoundingBox> _saved_boxes; //!< bounding box before the move of the first _moved_wire_num wires
+  std::vector<double> _saved_costs; //!< cost before the move of each affected wire
+  size_t _moved_wire_num; //!< the first _moved_wire_num affected wires connect to the moved elements
+  unsigned _move_stamp; //!< stamp of the current move on the affected wires
+
+  ParWireIndex* _wire_index; //!< find the wires whose bounding box covers a cell
+
+  ParThreadPool* _thread_pool; //!< threads to evaluate moves, NULL if single threaded
+  std::vector<PlaceMove> _batch_moves; //!< moves of the current batch
+  unsigned _batch_move_num; //!< number of valid moves in _batch_moves
+  unsigned _batch_stamp; //!< id of the current batch
+  std::vector<unsigned> _element_stamp; //!< last batch that moved the element
+  std::vector<unsigned> _wire_box_stamp; //!< last batch that changed the wire bounding box
+  std::vector<unsigned> _wire_cost_stamp; //!< last batch that changed the wire cost
+  std::vector<unsigned> _grid_stamp; //!< last batch that changed the grid, by gridIndex
+  std::vector<unsigned> _batch_moved_wires; //!< wires whose bounding box changed in the current batch
+  std::vector<std::pair<COORD, COORD> > _batch_moved_grids; //!< grids emptied or filled in the current batch
+  unsigned _stale_move_num; //!< number of moves re-evaluated after a conflict
+  unsigned _refresh_move_num; //!< number of moves whose wire costs were refreshed
 
   double _current_total_cost; //!< to record the total cost
 
@@ -27,29 +27,107 @@
  *  \brief placement cost function
  */
 
-#include "qpar/qpar_matrix.hh"
+#include <vector>
+#include <cstddef>
 
-class ParWire;
+class ParPlaceDB;
+class ParOccupancy;
+class Box;
+
+
+/*! \brief wires whose costs are computed together
+ *
+ * The inputs of the cost function are kept in flat arrays so that a whole
+ * batch can be evaluated by the vector kernels of CongestionAwareCost.
+ */
+class PlaceCostBatch {
+public:
+  /*! \brief remove all wires, the arrays keep their capacity
+   */
+  void clear();
+
+  /*! \brief add a wire, the parameters are the ones of PlacementCost::computeCost
+   */
+  void addWire(unsigned pin_num, const Box& bbox, unsigned used_cell);
+
+  /*! \brief get number of wires in the batch
+   */
+  size_t size() const { return _perimeters.size(); }
+
+  /*! \brief get cost of the i-th wire after the batch is computed
+   */
+  double getCost(size_t i) const { return _costs[i]; }
+
+private:
+  friend class CongestionAwareCost;
+
+  std::vector<double> _perimeters; //!< width plus height of each bounding box, 0 for a wire of one pin
+  std::vector<double> _cells; //!< number of grids in each bounding box
+  std::vector<double> _used_cells; //!< number of used grids in each bounding box
+  std::vector<double> _crossings; //!< crossing count factor of each wire
+  std::vector<double> _costs; //!< cost of each wire, filled by computeCost
+};
 
 
 class PlacementCost {
 public:
   static const float cross_count[50];
-  virtual double computeCost(ParWire* wire, const qpr_matrix<unsigned>& used_matrix) = 0;
+
+  /*! \brief compute cost of a wire in the placement database with its current bounding box
+   */
+  virtual double computeCost(const ParPlaceDB& place_db, unsigned wire, const ParOccupancy& occupancy) const = 0;
+
+  /*! \brief compute cost of a wire for a given bounding box and number of used grids in it,
+   *         it must not change any state so moves can be evaluated in parallel
+   *  \param unsigned number of elements on the wire
+   *  \param Box& bounding box
+   *  \param unsigned number of used grids in the bounding box
+   */
+  virtual double computeCost(unsigned pin_num, const Box& bbox, unsigned used_cell) const = 0;
+
+  /*! \brief compute the costs of all wires in a batch, the result of each wire
+   *         is the same as the one of computeCost
+   */
+  virtual void computeCost(PlaceCostBatch& batch) const = 0;
   virtual ~PlacementCost() {}
 };
 
 class BoundingBoxCost : public PlacementCost {
 public:
-  virtual double computeCost(ParWire* wire, const qpr_matrix<unsigned>& used_matrix);
+  virtual double computeCost(const ParPlaceDB& place_db, unsigned wire, const ParOccupancy& occupancy) const;
+  virtual double computeCost(unsigned pin_num, const Box& bbox, unsigned used_cell) const;
+  virtual void computeCost(PlaceCostBatch& batch) const;
 };
 
+/*! \brief half perimeter scaled by the congestion in the bounding box
+ *
+ * fill^1.3 is computed with a polynomial approximation of log2 and exp2
+ * (relative error below 1e-8), on AVX2 or SSE2 when the cpu has it.
+ * The scalar approximation gives bit identical results, so costs from the
+ * batched and the single wire calls can be mixed. The scalar mode uses
+ * std::pow and evaluates one wire at a time, it is kept to validate the
+ * approximation.
+ */
 class CongestionAwareCost : public PlacementCost {
 public:
-  virtual double computeCost(ParWire* wire, const qpr_matrix<unsigned>& used_matrix);
+  /*! \brief choose the kernel for the batched cost
+   *  \param bool scalar, use std::pow and no vector kernel
+   */
+  explicit CongestionAwareCost(bool scalar = false);
+
+  virtual double computeCost(const ParPlaceDB& place_db, unsigned wire, const ParOccupancy& occupancy) const;
+  virtual double computeCost(unsigned pin_num, const Box& bbox, unsigned used_cell) const;
+  virtual void computeCost(PlaceCostBatch& batch) const;
   double computeCostTest();
 
   virtual ~CongestionAwareCost() {}
+
+private:
+  typedef void (*COST_KERNEL)(size_t num, const double* perimeters, const double* cells,
+      const double* used_cells, const double* crossings, double* costs);
+
+  bool _scalar; //!< evaluate with std::pow one wire at a time
+  COST_KERNEL _kernel; //!< kernel of the batched cost
 };
 
 
@@ -0,0 +1,254 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+#ifndef QPAR_PLACE_DB_HH
+#define QPAR_PLACE_DB_HH
+
+/*!
+ * \file qpar_place_db.hh
+ * \author Juexiao Su
+ * \date 26 Feb 2018
+ * \brief compact placement state indexed by element and wire
+ */
+
+#include "qpar/qpar_netlist.hh"
+#include "hw_target/hw_loc.hh"
+
+#include <vector>
+
+class ParNetlist;
+class ParTarget;
+class ParElement;
+class ParWire;
+
+
+/*! \brief placement database used by the annealer
+ *
+ * Elements and wires get dense indices in netlist order. Element locations,
+ * wire bounding boxes and costs are kept in flat arrays, the pins of each wire
+ * and the wires of each element are stored as compressed rows. The database
+ * owns the placement while QPlace runs, the grids and wires of the netlist are
+ * only written back by storePlacement.
+ */
+class ParPlaceDB {
+
+public:
+  /*! \brief index the netlist and load the current placement from the grids
+   *  \param ParNetlist* netlist, every element must be placed
+   *  \param ParTarget* hardware target
+   */
+  ParPlaceDB(ParNetlist* netlist, ParTarget* target);
+
+  /*! \brief get number of elements
+   */
+  unsigned getElementNum() const { return (unsigned)_elements.size(); }
+
+  /*! \brief get number of wires that connect more than one element
+   */
+  unsigned getWireNum() const { return (unsigned)_wires.size(); }
+
+  /*! \brief get element of an index
+   */
+  ParElement* getElement(unsigned element) const { return _elements[element]; }
+
+  /*! \brief get wire of an index
+   */
+  ParWire* getWire(unsigned wire) const { return _wires[wire]; }
+
+  /*! \brief get index of an element
+   */
+  unsigned getElementIndex(const ParElement* element) const;
+
+  /*! \brief check if an element can be moved
+   */
+  bool isMovable(unsigned element) const { return _movable[element]; }
+
+  /*! \brief get x of an element
+   */
+  COORD getX(unsigned element) const { return (COORD)_x[element]; }
+
+  /*! \brief get y of an element
+   */
+  COORD getY(unsigned element) const { return (COORD)_y[element]; }
+
+  /*! \brief get element on a grid
+   *  \return int element index, -1 if the grid is empty
+   */
+  int getGridElement(COORD x, COORD y) const { return _grid_element[gridIndex(x, y)]; }
+
+  /*! \brief put an element on a grid, its previous grid is not cleared
+   */
+  void placeElement(unsigned element, COORD x, COORD y) {
+    _x[element] = (int)x;
+    _y[element] = (int)y;
+    _grid_element[gridIndex(x, y)] = (int)element;
+  }
+
+  /*! \brief clear a grid
+   */
+  void clearGrid(COORD x, COORD y) { _grid_element[gridIndex(x, y)] = -1; }
+
+  /*! \brief first wire of an element, each wire shows up once
+   */
+  const unsigned* wire_begin(unsigned element) const {
+    return _element_wires.data() + _element_wire_start[element];
+  }
+  const unsigned* wire_end(unsigned element) const {
+    return _element_wires.data() + _element_wire_start[element + 1];
+  }
+
+  /*! \brief check if an element connects to a wire
+   */
+  bool hasWire(unsigned element, unsigned wire) const;
+
+  /*! \brief first pin of a wire, pins are element indices
+   */
+  const unsigned* pin_begin(unsigned wire) const {
+    return _wire_pins.data() + _wire_pin_start[wire];
+  }
+  const unsigned* pin_end(unsigned wire) const {
+    return _wire_pins.data() + _wire_pin_start[wire + 1];
+  }
+
+  /*! \brief get number of elements on a wire
+   */
+  unsigned getPinNum(unsigned wire) const {
+    return _wire_pin_start[wire + 1] - _wire_pin_start[wire];
+  }
+
+  /*! \brief get bounding box of a wire with the number of elements on each edge
+   */
+  const BoundingBox& getBoundingBox(unsigned wire) const { return _boxes[wire]; }
+
+  /*! \brief get bounding box of a wire
+   */
+  const Box& getBox(unsigned wire) const { return _boxes[wire].getBoundBox(); }
+
+  /*! \brief set bounding box of a wire
+   */
+  void setBoundingBox(unsigned wire, const BoundingBox& box) { _boxes[wire] = box; }
+
+  /*! \brief check if the bounding box of a wire covers a grid
+   */
+  bool isInBox(unsigned wire, COORD x, COORD y) const {
+    const Box& box = _boxes[wire].getBoundBox();
+    return (int)x >= box.xl() && (int)x <= box.xr() && (int)y >= box.yt() && (int)y <= box.yb();
+  }
+
+  /*! \brief recompute the bounding box of a wire from its elements
+   */
+  void initializeBoundingBox(unsigned wire) { _boxes[wire] = computeBoundingBox(wire, -1, 0, 0, -1, 0, 0); }
+
+  /*! \brief incrementally update the bounding box of a wire after one of its elements moved,
+   *         the element has to be at its new location
+   */
+  void updateBoundingBox(unsigned wire, COORD from_x, COORD from_y, COORD to_x, COORD to_y);
+
+  /*! \brief compute the bounding box after a move without changing the wire
+   *  \param unsigned wire
+   *  \param COORD from x of the moved element
+   *  \param COORD from y of the moved element
+   *  \param COORD to x of the moved element
+   *  \param COORD to y of the moved element
+   *  \param unsigned the moved element on this wire
+   *  \param int element swapped from (to_x, to_y) to (from_x, from_y), -1 if none
+   *  \return BoundingBox bounding box after the move
+   */
+  BoundingBox predictBoundingBox(unsigned wire, COORD from_x, COORD from_y, COORD to_x, COORD to_y,
+      unsigned element, int swapped) const;
+
+  /*! \brief get cost of a wire
+   */
+  double getCost(unsigned wire) const { return _costs[wire]; }
+
+  /*! \brief set cost of a wire
+   */
+  void setCost(unsigned wire, double cost) { _costs[wire] = cost; }
+
+  /*! \brief stamp a wire as affected by a move
+   *  \param unsigned wire
+   *  \param unsigned stamp of the move, never 0
+   *  \return bool false if the wire already has the stamp
+   */
+  bool markMove(unsigned wire, unsigned stamp) {
+    if (_move_stamps[wire] == stamp)
+      return false;
+    _move_stamps[wire] = stamp;
+    return true;
+  }
+
+  /*! \brief clear the move stamps when the stamps wrap around
+   */
+  void clearMoveStamps() { _move_stamps.assign(_move_stamps.size(), 0); }
+
+  /*! \brief copy the element locations of a database built from the same model
+   */
+  void copyPlacement(const ParPlaceDB& db);
+
+  /*! \brief write the element locations to the grids and the bounding boxes and costs to the wires
+   */
+  void storePlacement();
+
+  /*! \brief check bounding boxes and grids against the element locations
+   */
+  bool sanityCheck() const;
+
+private:
+  ParPlaceDB(const ParPlaceDB&); //!< non-copyable
+
+  /*! \brief get index of a grid in _grid_element
+   */
+  size_t gridIndex(COORD x, COORD y) const { return (size_t)(y * _x_limit + x); }
+
+  /*! \brief compute bounding box from all elements, two elements can be put at given coordinates
+   */
+  BoundingBox computeBoundingBox(unsigned wire, int ele1, COORD x1, COORD y1,
+      int ele2, COORD x2, COORD y2) const;
+
+  /*! \brief incrementally update a bounding box for one element move
+   *  \return bool true if the box has to be re-computed from all elements
+   */
+  static bool incrementBoundingBox(BoundingBox& box, COORD from_x, COORD from_y, COORD to_x, COORD to_y);
+
+  ParTarget* _target; //!< hardware target
+  COORD _x_limit; //!< number of grids on x direction
+  COORD _y_limit; //!< number of grids on y direction
+
+  std::vector<ParElement*> _elements; //!< elements by index
+  std::vector<ParWire*> _wires; //!< wires by index
+  std::vector<unsigned> _element_index; //!< element index by element uniq id
+
+  std::vector<int> _x; //!< x of each element
+  std::vector<int> _y; //!< y of each element
+  std::vector<bool> _movable; //!< if each element can be moved
+  std::vector<int> _grid_element; //!< element on each grid, -1 if empty
+
+  std::vector<unsigned> _element_wire_start; //!< first wire of each element in _element_wires
+  std::vector<unsigned> _element_wires; //!< wires of all elements
+  std::vector<unsigned> _wire_pin_start; //!< first pin of each wire in _wire_pins
+  std::vector<unsigned> _wire_pins; //!< elements of all wires
+
+  std::vector<BoundingBox> _boxes; //!< bounding box of each wire
+  std::vector<double> _costs; //!< cost of each wire
+  std::vector<unsigned> _move_stamps; //!< stamp of the last move that affected each wire
+
+};
+
+
+#endif
@@ -0,0 +1,100 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+#ifndef QPAR_PLACE_TIMING_HH
+#define QPAR_PLACE_TIMING_HH
+
+/*!
+ * \file qpar_place_timing.hh
+ * \author Juexiao Su
+ * \date 02 Mar 2018
+ * \brief wire criticality from estimated chain lengths for timing driven placement
+ */
+
+#include <vector>
+
+namespace SYN {
+  class Model;
+}
+
+class ParPlaceDB;
+
+
+/*! \brief static timing on the wires of the placement database
+ *
+ * The delay of a wire is the chain length estimated from its bounding box,
+ * width + height - 1 cells, so a wire inside one cell still counts as one
+ * logic level. Wires are visited in the topological order of the synthesis
+ * model, a wire follows the wires on the inputs of its driving gate.
+ * update() computes arrival and required times from the current bounding
+ * boxes, the criticality of a wire is 1 - slack / critical path and its
+ * cost weight is 1 + weight * criticality^CRIT_EXP.
+ */
+class ParPlaceTiming {
+
+public:
+  /*! \brief build the timing graph of the database wires
+   *  \param ParPlaceDB* placement database with the bounding boxes
+   *  \param SYN::Model* synthesis model the netlist is built from
+   *  \param double weight of the most critical wire on top of 1
+   */
+  ParPlaceTiming(const ParPlaceDB* place_db, SYN::Model* model, double weight);
+
+  /*! \brief recompute arrival, required times and weights from the current bounding boxes
+   */
+  void update();
+
+  /*! \brief get cost weight of a wire
+   */
+  double getWeight(unsigned wire) const { return _weights[wire]; }
+
+  /*! \brief get criticality of a wire, between 0 and 1
+   */
+  double getCriticality(unsigned wire) const { return _criticalities[wire]; }
+
+  /*! \brief get longest estimated chain path of the last update
+   */
+  double getCriticalPath() const { return _critical_path; }
+
+  /*! \brief get number of logic levels
+   */
+  unsigned getMaxDepth() const { return _max_depth; }
+
+private:
+  /*! \brief estimated chain length of a wire
+   */
+  double getDelay(unsigned wire) const;
+
+  const ParPlaceDB* _place_db; //!< placement database
+  double _weight; //!< weight of the most critical wire on top of 1
+
+  std::vector<unsigned> _order; //!< database wires in topological order
+  std::vector<unsigned> _fanin_start; //!< first fanin of each wire in _fanins
+  std::vector<unsigned> _fanins; //!< wires on the inputs of the driving gate of each wire
+  unsigned _max_depth; //!< number of logic levels
+
+  std::vector<double> _arrivals; //!< arrival time at the driver of each wire
+  std::vector<double> _requireds; //!< required time at the sinks of each wire
+  std::vector<double> _criticalities; //!< criticality of each wire
+  std::vector<double> _weights; //!< cost weight of each wire
+  double _critical_path; //!< longest estimated chain path
+};
+
+
+#endif
@@ -28,7 +28,12 @@
  */
 
 #include "qpar_graph.hh"
+#include "qpar_utils.hh"
+#include "qpar_routing_graph.hh"
 #include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 class RoutingNode;
 class RoutingEdge;
@@ -41,6 +46,9 @@ class ParWireTarget;
 
 class ParRouter;
 class RoutingCost;
+class ParWire;
+class ParThreadPool;
+class ParRouteOverflow;
 
 
 class FastRoutingGraph : public qpr_graph<RoutingNode*, RoutingEdge*> {
@@ -50,6 +58,55 @@ public:
   FastRoutingGraph(RoutingGraph* graph);
   friend class RoutingTester;
 
+  /*! \brief get x of the cell where a vertex is located
+   */
+  int get_x(qvertex vertex) const { return _vertex_x[vertex]; }
+
+  /*! \brief get y of the cell where a vertex is located
+   */
+  int get_y(qvertex vertex) const { return _vertex_y[vertex]; }
+
+  /*! \brief get state of a vertex
+   */
+  const RoutingNodeState& get_state(qvertex vertex) const { return _states[vertex]; }
+
+  /*! \brief get first neighbor slot of a vertex, neighbors of v are the
+   *         slots in [adj_begin(v), adj_end(v))
+   */
+  unsigned adj_begin(qvertex vertex) const { return _adj_start[vertex]; }
+
+  /*! \brief get slot after the last neighbor of a vertex
+   */
+  unsigned adj_end(qvertex vertex) const { return _adj_start[vertex + 1]; }
+
+  /*! \brief get neighbor vertex in a slot
+   */
+  qvertex get_adj_vertex(unsigned slot) const { return _adj_vertex[slot]; }
+
+  /*! \brief get edge to the neighbor in a slot
+   */
+  qedge get_adj_edge(unsigned slot) const { return _adj_edge[slot]; }
+
+  /*! \brief get the largest x of all vertices
+   */
+  int get_max_x() const { return _max_x; }
+
+  /*! \brief get the largest y of all vertices
+   */
+  int get_max_y() const { return _max_y; }
+
+private:
+  RoutingNodeState* _states; //!< state of each vertex, owned by the routing graph
+
+  std::vector<unsigned> _adj_start; //!< first neighbor slot of each vertex
+  std::vector<qvertex> _adj_vertex; //!< neighbor vertex of each slot
+  std::vector<qedge> _adj_edge; //!< edge to the neighbor of each slot
+
+  std::vector<int> _vertex_x; //!< x of each vertex
+  std::vector<int> _vertex_y; //!< y of each vertex
+  int _max_x; //!< largest x of all vertices
+  int _max_y; //!< largest y of all vertices
+
 };
 
 /*! \brief this class records the route path
@@ -72,6 +129,27 @@ private:
 };
 
 
+/*! \brief options of routing
+ */
+struct RouteOption {
+  std::string eco_file; //!< previous routing result, unchanged targets keep their routes
+  unsigned feedback; //!< times a failed routing is fed back to placement before routing fails
+  unsigned threads; //!< number of threads, wires in disjoint regions are routed together
+  double astar_fac; //!< weight of the remaining distance in the router, 0 for dijkstra, above 1 trades quality for speed
+  int window; //!< cells around the source and target a route can use at first, negative for the whole graph
+  bool bidir; //!< search from both the source and the target of a route
+  bool steiner; //!< route the targets of a wire as one tree grown from its source
+
+  RouteOption() :
+    feedback(0),
+    threads(1),
+    astar_fac(0.0),
+    window(-1),
+    bidir(false),
+    steiner(false) {}
+};
+
+
 struct TargetSlackCmp {
 
   bool operator()(const ParWireTarget* tgt1, const ParWireTarget* tgt2) const;
@@ -87,10 +165,19 @@ public:
    */
 
   QRoute(ParNetlist* netlist,
-      RoutingGraph* rr_graph, FastRoutingGraph* f_graph) :
+      RoutingGraph* rr_graph, FastRoutingGraph* f_graph,
+      const RouteOption& option = RouteOption()) :
     _netlist(netlist),
     _rr_graph(rr_graph),
-    _f_graph(f_graph)
+    _f_graph(f_graph),
+    _option(option),
+    _cost(NULL),
+    _cost_simple(NULL),
+    _router(NULL),
+    _first_router(NULL),
+    _thread_pool(NULL),
+    _overflow(NULL),
+    _batch_first_iter(false)
   {
   }
 
@@ -100,8 +187,9 @@ public:
 
 
   /*! \brief execute routing
+   *  \return bool false if the negotiation did not remove all overflow
    */
-  void run();
+  bool run();
 
   /*! \brief get routing graph
    */ 
@@ -118,6 +206,7 @@ private:
 
   RoutingGraph* _rr_graph; //!< routing graph
   FastRoutingGraph* _f_graph; //!< fast routing graph
+  RouteOption _option; //!< routing options
 
   RoutingCost* _cost;
   RoutingCost* _cost_simple;
@@ -126,6 +215,18 @@ private:
   ParRouter* _router; //!< router used in rest routing iterations
   ParRouter* _first_router; //!< router used in routing first iteration
 
+  ParThreadPool* _thread_pool; //!< threads for parallel routing, NULL if serial
+  std::vector<ParRouter*> _thread_routers; //!< router of each thread in rest routing iterations
+  std::vector<ParRouter*> _thread_first_routers; //!< router of each thread in routing first iteration
+
+  ParRouteOverflow* _overflow; //!< overused nodes and the targets that use them
+
+  std::vector<ParWire*> _batch_wires; //!< wires routed together in the current batch
+  std::vector<std::vector<ParWireTarget*> > _batch_targets; //!< targets to reroute of each batch wire
+  std::vector<Box> _batch_regions; //!< region of each batch wire
+  std::vector<std::vector<ParWireTarget*> > _batch_failed; //!< targets of each batch wire not routed inside its region
+  bool _batch_first_iter; //!< current batch is in the first routing iteration
+
   double _longest_wire_length; //!< longest wire length
 
   /*! \brief initialize necessary datastructure for routing
@@ -153,6 +254,29 @@ private:
    */
   void routeAllTarget(std::vector<ParWireTarget*>& targets, unsigned iter);
 
+  /*! \brief route wires in batches, the regions of wires in a batch do not overlap
+   *         so each batch is routed by all threads at the same time
+   */
+  void routeAllTargetParallel(std::vector<ParWireTarget*>& targets, unsigned iter);
+
+  /*! \brief group the targets to reroute by wire, wires are in the order of their first target.
+   *         With steiner trees every target of a wire is rerouted if one of them is
+   */
+  void groupTargetsByWire(std::vector<ParWireTarget*>& targets, unsigned iter,
+      std::vector<ParWire*>& wires, std::unordered_map<ParWire*, std::vector<ParWireTarget*> >& wire_targets);
+
+  /*! \brief route the wires of current batch assigned to a thread
+   */
+  void routeBatch(unsigned thread_id);
+
+  /*! \brief get region of a wire, covers all pins and current routes
+   */
+  Box getWireRegion(ParWire* wire) const;
+
+  /*! \brief get window of a target, covers its source and target with a margin
+   */
+  Box getTargetWindow(ParWireTarget* target, int margin) const;
+
 
   /*! \brief update history cost in the nbr algorithm
    */
@@ -162,13 +286,30 @@ private:
    */
   void routeTarget(ParWireTarget* target, ParRouter* router);
 
+  /*! \brief route single target, a target without route is left ripped up
+   *  \return bool false if the router cannot find a route
+   */
+  bool tryRouteTarget(ParWireTarget* target, ParRouter* router);
+
+  /*! \brief route all targets of a wire as one tree
+   */
+  void routeWire(std::vector<ParWireTarget*>& targets, ParRouter* router);
+
+  /*! \brief rip up all targets of a wire and grow a tree from its source to
+   *         the nearest sink until all sinks are reached
+   *  \return bool false if the router cannot reach a sink, the other sinks are left ripped up
+   */
+  bool tryRouteWire(std::vector<ParWireTarget*>& targets, ParRouter* router);
+
   /*! \brief build routing path and update the routing graph accordingly
    */
   void updateRoute(ParWireTarget* target, double &slack, ParRouter* router);
 
-  /*! \brief check if the current routing is a valid solution
+  /*! \brief check if the current routing is a valid solution, the history
+   *         cost of every overused node grows
+   *  \param unsigned& number of overused nodes
    */
-  bool isRoutingValid(std::vector<ParWireTarget*>& targets, unsigned& overflow);
+  bool isRoutingValid(unsigned& overflow);
 
 
   /*! \brief check if a given target is overflow
@@ -0,0 +1,101 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+#ifndef QPAR_ROUTE_CONGESTION_HH
+#define QPAR_ROUTE_CONGESTION_HH
+
+/*!
+ * \file qpar_route_congestion.hh
+ * \author Juexiao Su
+ * \date 07 Mar 2018
+ * \brief routing congestion of each grid, fed back to placement
+ */
+
+#include "hw_target/hw_loc.hh"
+
+#include <vector>
+
+class RoutingGraph;
+class Box;
+
+
+/*! \brief congestion left by a failed routing on each grid
+ *
+ * The congestion of a routing node is its NBR history cost plus its overflow, it
+ * is added to the grid of the cell that owns the node. Congestion of several
+ * routing attempts accumulates, since the routing graph is rebuilt after every
+ * placement. The history cost grows with the number of negotiation iterations,
+ * so wire weights only use congestion relative to the most congested grid.
+ * Bounding box sums use a prefix sum table, so the placer can query them in
+ * constant time for every move.
+ */
+class ParRouteCongestion {
+
+public:
+  /*! \brief default constructor, no congestion
+   *  \param COORD number of grids on x direction
+   *  \param COORD number of grids on y direction
+   */
+  ParRouteCongestion(COORD x_limit, COORD y_limit);
+
+  /*! \brief add congestion of the current routing
+   *  \param RoutingGraph& routing graph after the last negotiation iteration
+   */
+  void addRouting(RoutingGraph& graph);
+
+  /*! \brief get congestion of a grid
+   */
+  double getCongestion(COORD x, COORD y) const { return _congestion[gridIndex(x, y)]; }
+
+  /*! \brief get congestion of all grids
+   */
+  double getTotalCongestion() const { return getSum(0, 0, _x_limit - 1, _y_limit - 1); }
+
+  /*! \brief get cost weight of a wire, grows with the average congestion in its bounding box
+   *         relative to the most congested grid
+   */
+  double getWeight(const Box& box) const;
+
+private:
+  /*! \brief get index of a grid in _congestion
+   */
+  size_t gridIndex(COORD x, COORD y) const { return (size_t)(y * _x_limit + x); }
+
+  /*! \brief get sum of congestion in a box, bounds are inclusive
+   */
+  double getSum(int xl, int yt, int xr, int yb) const {
+    size_t row = (size_t)_x_limit + 1;
+    return _prefix[(size_t)(yb + 1) * row + (size_t)(xr + 1)] - _prefix[(size_t)yt * row + (size_t)(xr + 1)] -
+      _prefix[(size_t)(yb + 1) * row + (size_t)xl] + _prefix[(size_t)yt * row + (size_t)xl];
+  }
+
+  /*! \brief rebuild _prefix and _max_congestion from _congestion
+   */
+  void buildPrefix();
+
+  COORD _x_limit; //!< number of grids on x direction
+  COORD _y_limit; //!< number of grids on y direction
+  std::vector<double> _congestion; //!< congestion of each grid
+  std::vector<double> _prefix; //!< congestion of grids below and left of each corner, one row and column of padding
+  double _max_congestion; //!< congestion of the most congested grid
+
+};
+
+
+#endif
@@ -0,0 +1,106 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+#ifndef QPAR_ROUTE_OVERFLOW_HH
+#define QPAR_ROUTE_OVERFLOW_HH
+
+/*!
+ * \file qpar_route_overflow.hh
+ * \author Juexiao Su
+ * \date 09 Mar 2018
+ * \brief overused routing nodes and the targets that use them
+ */
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class RoutingGraph;
+class RoutingNode;
+class ParWireTarget;
+
+
+/*! \brief incrementally maintained set of overused routing nodes
+ *
+ * Every routing node keeps the targets whose routes use it, and every target
+ * keeps how many overused nodes its route uses. Routes are added and ripped up
+ * through the tracker, which only looks at the nodes of that route, so finding
+ * the targets to rip up and checking if the routing is valid cost time in the
+ * number of overused nodes instead of the size of the design.
+ *
+ * Wires routed by different threads use disjoint nodes. A node changing its
+ * overflow updates targets of other wires, so those updates hold a lock.
+ */
+class ParRouteOverflow {
+
+public:
+  /*! \brief default constructor, existing routes of the targets are added
+   *  \param RoutingGraph* routing graph
+   *  \param std::vector<ParWireTarget*>& all targets of the netlist
+   */
+  ParRouteOverflow(RoutingGraph* graph, std::vector<ParWireTarget*>& targets);
+
+  /*! \brief add the route of a target, its nodes have to carry its load already
+   */
+  void addRoute(ParWireTarget* target);
+
+  /*! \brief rip up the route of a target, the route itself is kept
+   */
+  void ripupTarget(ParWireTarget* target);
+
+  /*! \brief check if the route of a target uses an overused node
+   */
+  bool isTargetOverFlow(ParWireTarget* target) const {
+    return _overflow_num[getTargetIndex(target)] > 0;
+  }
+
+  /*! \brief get all overused nodes, in no particular order
+   */
+  const std::vector<RoutingNode*>& getOverFlowNodes() const { return _overflow_nodes; }
+
+  /*! \brief compare the tracked nodes and targets against the routing graph and routes
+   */
+  bool sanityCheck(RoutingGraph* graph, std::vector<ParWireTarget*>& targets) const;
+
+private:
+  ParRouteOverflow(const ParRouteOverflow&); //!< non-copyable
+
+  /*! \brief get index of a target
+   */
+  unsigned getTargetIndex(ParWireTarget* target) const { return _target_index.at(target); }
+
+  /*! \brief check if a node is in the overused set
+   */
+  bool isTracked(unsigned node) const { return _overflow_pos[node] >= 0; }
+
+  /*! \brief move a node in or out of the overused set after its load changed
+   */
+  void updateNode(RoutingNode* node);
+
+  std::unordered_map<ParWireTarget*, unsigned> _target_index; //!< index of each target, fixed after construction
+  std::vector<unsigned> _overflow_num; //!< number of overused nodes on the route of each target
+  std::vector<std::vector<ParWireTarget*> > _node_targets; //!< targets whose routes use each node
+  std::vector<RoutingNode*> _overflow_nodes; //!< overused nodes
+  std::vector<int> _overflow_pos; //!< position of each node in _overflow_nodes, -1 if not overused
+  std::mutex _mutex; //!< guards changes of the overused set
+
+};
+
+
+#endif
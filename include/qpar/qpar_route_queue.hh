@@ -0,0 +1,189 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+#ifndef QPAR_ROUTE_QUEUE_HH
+#define QPAR_ROUTE_QUEUE_HH
+
+/*!
+ * \file qpar_route_queue.hh
+ * \author Juexiao Su
+ * \date 08 Mar 2018
+ * \brief priority queues of vertices used by the router
+ */
+
+#include "qpar/qpar_graph.hh"
+
+#include <vector>
+#include <utility>
+
+
+/*! \brief interface of the router priority queue
+ *
+ * Every element is a vertex with its priority and the number of nodes
+ * on the path that reaches it. Pop returns the element with the lowest
+ * priority, ties are broken by vertex for heaps.
+ */
+class ParRouteQueue {
+
+public:
+  /*! \brief type of priority queue
+   */
+  enum ROUTE_QUEUE_TYPE {ROUTE_QUEUE_BUCKET, ROUTE_QUEUE_HEAP};
+
+  ParRouteQueue() {}
+
+  virtual ~ParRouteQueue() {}
+
+  /*! \brief push a vertex, a vertex already in the queue may be updated or added again
+   *  \param double priority
+   *  \param double number of nodes on the path to the vertex
+   *  \param qvertex vertex
+   */
+  virtual void push(double priority, double length, qvertex vertex) = 0;
+
+  /*! \brief pop the vertex with the lowest priority
+   *  \param double& priority of the vertex
+   *  \param double& number of nodes on the path to the vertex
+   *  \return qvertex vertex
+   */
+  virtual qvertex pop(double& priority, double& length) = 0;
+
+  /*! \brief get the lowest priority without popping, the queue cannot be empty
+   */
+  virtual double getTopPriority() = 0;
+
+  /*! \brief check if the queue is empty
+   */
+  virtual bool empty() const = 0;
+
+  /*! \brief remove all elements, the memory is kept
+   */
+  virtual void clear() = 0;
+
+  /*! \brief create queue by type
+   *  \param ROUTE_QUEUE_TYPE type
+   *  \param unsigned number of vertices in the graph
+   */
+  static ParRouteQueue* create(ROUTE_QUEUE_TYPE type, unsigned vertex_num);
+
+  /*! \brief get name of type
+   */
+  static const char* getTypeName(ROUTE_QUEUE_TYPE type);
+
+private:
+  ParRouteQueue(const ParRouteQueue&); //!< non-copyable
+
+};
+
+
+/*! \brief bucket queue for integer priorities
+ *
+ * Each integer priority owns a bucket and pop scans forward from the lowest
+ * non-empty bucket. With unit node costs a search only pushes priorities a
+ * little above the current one, so no priority is ever compared. A bucket
+ * is a small heap on the vertex, which breaks ties the same way as the
+ * heap queue. A vertex is added again when its cost improves, the stale
+ * copy is popped later.
+ */
+class BucketRouteQueue : public ParRouteQueue {
+
+public:
+  BucketRouteQueue() : _cursor(0), _top(0), _size(0) {}
+
+  virtual void push(double priority, double length, qvertex vertex);
+  virtual qvertex pop(double& priority, double& length);
+  virtual double getTopPriority();
+  virtual bool empty() const { return _size == 0; }
+  virtual void clear();
+
+private:
+  typedef std::pair<qvertex, double> BucketElement; //!< vertex and length
+
+  /*! \brief order a bucket heap by vertex, smallest on top
+   */
+  struct BucketCompare {
+    bool operator()(const BucketElement& e1, const BucketElement& e2) const {
+      return e1.first > e2.first;
+    }
+  };
+
+  BucketCompare _cmp; //!< bucket heap order
+
+  std::vector<std::vector<BucketElement> > _buckets; //!< elements of each priority
+  size_t _cursor; //!< buckets below the cursor are empty
+  size_t _top; //!< buckets from the top are empty
+  size_t _size; //!< number of elements
+
+};
+
+
+/*! \brief 4-ary heap indexed by vertex
+ *
+ * A vertex is in the heap at most once, pushing it again decreases its key
+ * in place, so the heap never holds stale copies. A 4-ary heap is shallower
+ * than a binary one. Slots keep the priority next to the vertex, so sifting
+ * compares without looking up per vertex arrays.
+ */
+class HeapRouteQueue : public ParRouteQueue {
+
+public:
+  HeapRouteQueue(unsigned vertex_num) :
+    _position(vertex_num, -1),
+    _length(vertex_num, 0.0) {}
+
+  virtual void push(double priority, double length, qvertex vertex);
+  virtual qvertex pop(double& priority, double& length);
+  virtual double getTopPriority() { return _heap[0].first; }
+  virtual bool empty() const { return _heap.empty(); }
+  virtual void clear();
+
+private:
+  typedef std::pair<double, qvertex> HeapElement; //!< priority and vertex
+
+  /*! \brief check if element e1 pops before element e2
+   */
+  static bool isBefore(const HeapElement& e1, const HeapElement& e2) {
+    if (e1.first != e2.first)
+      return e1.first < e2.first;
+    return e1.second < e2.second;
+  }
+
+  /*! \brief move the vertex at a slot toward the root
+   */
+  void siftUp(size_t slot);
+
+  /*! \brief move the vertex at a slot toward the leaves
+   */
+  void siftDown(size_t slot);
+
+  /*! \brief put an element at a slot
+   */
+  void setSlot(size_t slot, const HeapElement& element) {
+    _heap[slot] = element;
+    _position[element.second] = (int)slot;
+  }
+
+  std::vector<HeapElement> _heap; //!< elements in heap order
+  std::vector<int> _position; //!< slot of each vertex, -1 if not in the heap
+  std::vector<double> _length; //!< path length of each vertex in the heap
+
+};
+
+
+#endif
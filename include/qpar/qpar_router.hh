@@ -23,12 +23,16 @@
 
 #include "qpar/qpar_graph.hh"
 #include "qpar/qpar_route.hh"
+#include "qpar/qpar_routing_cost.hh"
+#include "qpar/qpar_route_queue.hh"
 
 #include <unordered_set>
 #include <list>
-#include <queue>
 #include <vector>
 #include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <cmath>
 
 
 class FastRoutingGraph;
@@ -45,84 +49,86 @@ class ParWireTarget;
  */
 
 
-/*! \brief customized priority queue that helps to store more information
- */
-
-/*! \brief priority element, will keep track current length 
- */
-typedef std::pair<double, qvertex> QElement;
-
-/*! \breif priority queue element
- */
-typedef std::pair<double, QElement> PElement;
-
-struct PQCompare {
-
-  bool operator()(const PElement& e1, const PElement& e2) const {
-    if (e1.first < e2.first)
-      return false;
-    else if (e1.first > e2.first)
-      return true;
-    else
-      return e1.second.second > e2.second.second; //break tie by qvertex
-  }
-
-};
-
+class ParRouter {
 
-class QPriorityQueue : public std::priority_queue<PElement, std::vector<PElement>, PQCompare> {
 
 public:
-  typedef std::priority_queue<PElement, std::vector<PElement>, PQCompare> SUPER;
 
-public:
-  /*! \brief copy the internal vector
+  /*! \brief default constructor
+   *  \param FastRoutingGraph& routing graph
+   *  \param RoutingCost& routing cost
+   *  \param double weight of the estimated remaining cost, 0 for dijkstra,
+   *         1 keeps the shortest path, larger values expand fewer nodes
+   *  \param bool search from both the source and the target until the searches meet
    */
-  std::vector<PElement> getVector() {
-    std::vector<PElement> re(this->c.begin(), this->c.end());
-    std::sort(re.begin(), re.end(), this->comp);
-    std::reverse(re.begin(), re.end());
-    return re;
-  }
+  ParRouter(FastRoutingGraph& graph, RoutingCost& cost, double astar_fac = 0.0, bool bidirectional = false) :
+    _graph(graph), _cost(cost), _use_window(false), _window(0, -1, 0, -1),
+    _hop_cost(astar_fac * cost.getMinCost()), _bidirectional(bidirectional), _stamp(0),
+    _back_pqueue(NULL), _meet(-1), _meet_cost(0.0), _expanded_num(0) {
+      _visited_node.resize(graph.get_vertex_num());
+      _visit_stamp.resize(graph.get_vertex_num(), 0);
+      _from_edge.resize(graph.get_vertex_num());
+
+      // unit costs with an integer astar factor keep every priority an integer,
+      // the potentials of a bidirectional astar are halves and can be negative
+      ParRouteQueue::ROUTE_QUEUE_TYPE type = ParRouteQueue::ROUTE_QUEUE_HEAP;
+      if (cost.isUnitCost() && astar_fac == std::floor(astar_fac) && !(bidirectional && astar_fac > 0.0))
+        type = ParRouteQueue::ROUTE_QUEUE_BUCKET;
+      _pqueue = ParRouteQueue::create(type, graph.get_vertex_num());
+
+      if (_bidirectional) {
+        _back_node.resize(graph.get_vertex_num());
+        _back_stamp.resize(graph.get_vertex_num(), 0);
+        _to_edge.resize(graph.get_vertex_num());
+        _back_pqueue = ParRouteQueue::create(type, graph.get_vertex_num());
+      }
+    }
 
-  /*! \brief push element into priority queue
+  /*! \brief default destructor
    */
-  void push(double p, const QElement& ele) {
-    SUPER::push(std::make_pair(p, ele));
+  ~ParRouter() {
+    delete _pqueue;
+    delete _back_pqueue;
   }
 
-  /*! \brief pop the top of the pqueue
+  /*! \brief only expand vertices located in cells inside the window
    */
-  std::pair<double, QElement> pop() {
-    if (this->size() == 0)
-      qlog.speakError("Cannot pop an empty queue!");
-    PElement top_ele = SUPER::top();
-    SUPER::pop();
-    return top_ele;
+  void setWindow(const Box& window) {
+    _window = window;
+    _use_window = true;
   }
 
-};
-
-class ParRouter {
-
-
-public:
-
-  /*! \brief default constructor
+  /*! \brief expand vertices in the whole graph
    */
-  ParRouter(FastRoutingGraph& graph, RoutingCost& cost) :
-    _graph(graph), _cost(cost) {
-      _visited_node.resize(graph.get_vertex_num());
-    }
+  void clearWindow() { _use_window = false; }
 
   /*! \brief route target
    */
   bool route(RoutingNode* src, RoutingNode* tgt, double slack, std::unordered_set<RoutingNode*>& used, ParWireTarget* target);
 
+  /*! \brief start the route tree of a wire, the tree only has the source
+   *         of the wire at first. Trees are only grown by dijkstra
+   */
+  void beginTree(RoutingNode* src);
+
+  /*! \brief grow the tree to its nearest sink, the search continues the
+   *         wavefront of the last call, every tree vertex is a source of cost 0.
+   *         buildRoutePath then gives the path from the source of the wire to the sink
+   *  \param std::vector<RoutingNode*>& sinks not on the tree yet
+   *  \param double slack of the wire
+   *  \param ParWireTarget* any target of the wire
+   *  \return int index of the sink reached, -1 if no sink can be reached
+   */
+  int routeTree(const std::vector<RoutingNode*>& sinks, double slack, ParWireTarget* target);
+
   /*! \brief back trace to find the path
    */
   void buildRoutePath(std::list<RoutingNode*>& path, std::list<RoutingEdge*>& edges);
 
+  /*! \brief get number of vertices expanded by the last route or tree
+   */
+  unsigned getExpandedNum() const { return _expanded_num; }
+
 
 private:
   FastRoutingGraph& _graph; //!< routing graph;
@@ -134,12 +140,107 @@ private:
    */
   void pushRoutedNodes(std::unordered_set<RoutingNode*>& used);
 
-  void expandNeighbors(QPriorityQueue* pqueue, qvertex current_vertex, double real_length, double slack, ParWireTarget* target);
+  void expandNeighbors(ParRouteQueue* pqueue, qvertex current_vertex, double real_length, double slack, ParWireTarget* target);
 
-  qvertex popBestVertex(QPriorityQueue* pqueue, double& current_cost, double& real_cost);
+  qvertex popBestVertex(ParRouteQueue* pqueue, double& current_cost, double& real_cost);
+
+  /*! \brief invalidate the costs of the last search
+   */
+  void nextStamp();
+
+  /*! \brief add the path from the tree to a vertex to the tree
+   */
+  void addTreeBranch(qvertex vertex);
+
+  /*! \brief search from the source and the target at the same time, the
+   *         best path through a vertex reached by both searches is kept
+   */
+  bool routeBidirectional(double slack, ParWireTarget* target);
+
+  /*! \brief expand a vertex of the search from the source in bidirectional mode
+   */
+  void expandForward(qvertex current_vertex, double real_length, double slack, ParWireTarget* target);
+
+  /*! \brief expand a vertex of the search from the target, the cost of
+   *         a step toward the target is the cost of the vertex it leaves
+   */
+  void expandBackward(qvertex current_vertex, double real_length, double slack, ParWireTarget* target);
+
+  /*! \brief check if a vertex can be expanded under the current window
+   */
+  bool isInWindow(qvertex vertex) const {
+    if (!_use_window) return true;
+    int x = _graph.get_x(vertex);
+    int y = _graph.get_y(vertex);
+    return x >= _window.xl() && x <= _window.xr() && y >= _window.yt() && y <= _window.yb();
+  }
+
+  /*! \brief estimate the cost between a vertex and a goal, every cell
+   *         on the way to the goal costs at least one node
+   */
+  double estimateCost(qvertex vertex, qvertex goal) const {
+    int dx = _graph.get_x(vertex) - _graph.get_x(goal);
+    int dy = _graph.get_y(vertex) - _graph.get_y(goal);
+    return _hop_cost * (double)(std::abs(dx) + std::abs(dy));
+  }
+
+  /*! \brief potential of a vertex in bidirectional mode, the search from the
+   *         source adds it and the search from the target subtracts it. The
+   *         average of the estimates to the target and from the source keeps
+   *         the step costs of both searches positive and the same along a path
+   */
+  double getPotential(qvertex vertex) const {
+    return 0.5 * (estimateCost(vertex, _target) - estimateCost(vertex, _source));
+  }
+
+  bool _use_window; //!< restrict expansion to the window
+  Box _window; //!< cells a route can use
+  double _hop_cost; //!< astar factor times the lower bound of a node cost
+  bool _bidirectional; //!< search from both the source and the target
+
+  /*! \brief get cost to reach a vertex in the current search, infinity if not reached
+   */
+  double getVisitCost(qvertex vertex) const {
+    if (_visit_stamp[vertex] != _stamp)
+      return std::numeric_limits<double>::infinity();
+    return _visited_node[vertex];
+  }
+
+  /*! \brief set cost to reach a vertex in the current search
+   */
+  void setVisitCost(qvertex vertex, double cost) {
+    _visited_node[vertex] = cost;
+    _visit_stamp[vertex] = _stamp;
+  }
+
+  /*! \brief get cost from a vertex to the target in the current search, infinity if not reached
+   */
+  double getBackCost(qvertex vertex) const {
+    if (_back_stamp[vertex] != _stamp)
+      return std::numeric_limits<double>::infinity();
+    return _back_node[vertex];
+  }
+
+  /*! \brief set cost from a vertex to the target in the current search
+   */
+  void setBackCost(qvertex vertex, double cost) {
+    _back_node[vertex] = cost;
+    _back_stamp[vertex] = _stamp;
+  }
 
-  std::vector<double> _visited_node;
-  std::unordered_map<qvertex, qedge> _from_edge;
+  unsigned _stamp; //!< stamp of the current search
+  std::vector<unsigned> _visit_stamp; //!< stamp of the search that reached each vertex
+  std::vector<double> _visited_node; //!< cost to reach each vertex, valid with the current stamp
+  std::vector<qedge> _from_edge; //!< edge each vertex is reached from, valid with the current stamp
+  ParRouteQueue* _pqueue; //!< queue reused by every search
+  std::vector<unsigned> _back_stamp; //!< stamp of the search that reached each vertex from the target
+  std::vector<double> _back_node; //!< cost from each vertex to the target, valid with the current stamp
+  std::vector<qedge> _to_edge; //!< edge each vertex leaves toward the target, valid with the current stamp
+  ParRouteQueue* _back_pqueue; //!< queue of the search from the target, NULL for a single search
+  qvertex _meet; //!< vertex on the best path reached by both searches, -1 if none
+  double _meet_cost; //!< cost of the best path through _meet
+  unsigned _expanded_num; //!< number of vertices expanded by the last route or tree
+  std::vector<unsigned> _sink_stamp; //!< stamp of the tree search each vertex is a sink of
   qvertex _source;
   qvertex _target;
 
@@ -21,7 +21,7 @@
 #define QPAR_ROUTING_COST_HH
 
 
-class RoutingNode;
+struct RoutingNodeState;
 class ParWireTarget;
 
 class RoutingCost {
@@ -29,12 +29,20 @@ class RoutingCost {
 public:
   RoutingCost() {}
   virtual ~RoutingCost() {}
-  virtual double compute_cost(RoutingNode* node,
+  virtual double compute_cost(const RoutingNodeState& node,
                               ParWireTarget* tgt,
                               double slack,
                               double current_length
                               ) = 0;
 
+  /*! \brief lower bound of the cost of any node
+   */
+  virtual double getMinCost() const = 0;
+
+  /*! \brief check if every node costs exactly 1
+   */
+  virtual bool isUnitCost() const { return false; }
+
 
 };
 
@@ -44,11 +52,13 @@ class RoutingCostNBR : public RoutingCost {
 public:
   RoutingCostNBR() {}
   virtual ~RoutingCostNBR() {}
-  virtual double compute_cost(RoutingNode* node,
+  virtual double compute_cost(const RoutingNodeState& node,
                               ParWireTarget* tgt,
                               double slack,
                               double current_length);
 
+  virtual double getMinCost() const;
+
   double getCongestionCost(unsigned load, unsigned capacity);
 
 
@@ -60,10 +70,14 @@ class RoutingCostSimple : public RoutingCost {
 public:
   RoutingCostSimple() {}
   virtual ~RoutingCostSimple() {}
-  virtual double compute_cost(RoutingNode* node,
+  virtual double compute_cost(const RoutingNodeState& node,
                               ParWireTarget* tgt,
                               double slack,
                               double current_length);
+
+  virtual double getMinCost() const { return 1.0; }
+
+  virtual bool isUnitCost() const { return true; }
 };
 
 
@@ -66,6 +66,26 @@ struct RoutingEdgeCmp {
 typedef std::set<RoutingNode*, RoutingNodeCmp> NODES;
 typedef std::set<RoutingEdge*, RoutingEdgeCmp> EDGES;
 
+/*! \brief the part of a routing node that changes during routing
+ *
+ * The routing graph keeps the states of all nodes in one array in node
+ * order, the router reads them without touching the nodes.
+ */
+struct RoutingNodeState {
+  unsigned load; //!< number of load
+  unsigned capacity; //!< capacity of the routing node
+  double history_cost; //!< history cost used in NBR algorithm
+  bool currently_used; //!< multi target wire with shared routing node
+  bool enabled; //!< if the routing node can be used to route
+
+  RoutingNodeState() :
+    load(0),
+    capacity(1),
+    history_cost(0.0),
+    currently_used(false),
+    enabled(true) {}
+};
+
 /*! \brief in the embedding routing graph, the routing graph can be only decided after placement is finished
  */
 class RoutingGraph {
@@ -100,6 +120,14 @@ public:
    */
   RoutingNode* getRoutingNode(ParElement* element, SYN::Pin* pin) const;
 
+  /*! \brief find qubit routing node by location, NULL if the cell does not have it
+   */
+  RoutingNode* getRoutingNode(COORD x, COORD y, COORD local) const;
+
+  /*! \brief get states of all nodes, in the order of node_begin()
+   */
+  RoutingNodeState* getNodeStates() { return _node_states.data(); }
+
   friend class RoutingCell;
   friend class RoutingTester;
 
@@ -110,6 +138,7 @@ private:
   std::unordered_map<HW_Cell*, RoutingCell*> _cells;
   NODES _nodes;
   EDGES _edges;
+  std::vector<RoutingNodeState> _node_states; //!< state of each node in node order
 
   /*! \brief create routing graph for cell
    */
@@ -203,6 +232,14 @@ public:
    */
   unsigned getIndex() const { return _node_index; }
 
+  /*! \brief get routing cell where the node is located
+   */
+  RoutingCell* getRoutingCell() const { return _rr_cell; }
+
+  /*! \brief set routing cell where the node is located
+   */
+  void setRoutingCell(RoutingCell* cell) { _rr_cell = cell; }
+
   /*! \brief add edge to this routing node
    */
   void addEdge(RoutingEdge* edge) {
@@ -226,44 +263,44 @@ public:
   /*! \brief check if the node is currently used by other target on the same wire
    */
   bool getCurrentlyUsed() const {
-    return _is_currently_used;
+    return _state->currently_used;
   }
 
   /*! \brief set currently used
    */
   void setCurrentlyUsed(bool val) {
-    _is_currently_used = val;
+    _state->currently_used = val;
   }
 
   /*! \brief add load on the routing node
    */
   void addLoad(unsigned i) {
-    _load += i;
+    _state->load += i;
   }
 
   /*! \brief sub load on the routing node
    */
   void subLoad(unsigned i) {
-    QASSERT(_load >= i);
-    _load -= i;
+    QASSERT(_state->load >= i);
+    _state->load -= i;
   }
 
   /*! \brief check if the load is overflow
    */
   bool isOverFlow() const {
-    return _load > _capacity;
+    return _state->load > _state->capacity;
   }
 
   /*! \brief get node load
    */
   unsigned getLoad() const {
-    return _load;
+    return _state->load;
   }
 
   /*! \brief get node capcity, 
    */
   unsigned getCapacity() const {
-    return _capacity;
+    return _state->capacity;
   }
 
   /*! \brief get congestion cost which is shared by the entire design
@@ -281,13 +318,13 @@ public:
   /*! \brief get history cost
    */
   double getHistoryCost()  const {
-    return _history_cost;
+    return _state->history_cost;
   }
 
   /*! \brief set history cost
    */
   void setHistoryCost(double val) {
-    _history_cost = val;
+    _state->history_cost = val;
   }
 
   /*! \brief check if the node is passing-by
@@ -298,9 +335,24 @@ public:
    */
   void setPass() { _isPass = true; }
 
-  bool isEnabled() const { return _isEnable; }
+  bool isEnabled() const { return _state->enabled; }
+
+  void setEnabled(bool val) { _state->enabled = val; }
+
+  /*! \brief move the state of the node to a slot owned by the routing graph
+   *  \param RoutingNodeState* slot of the node
+   *  \param unsigned index of the slot
+   */
+  void bindState(RoutingNodeState* state, unsigned index) {
+    *state = *_state;
+    _state = state;
+    _graph_index = index;
+  }
 
-  void setEnabled(bool val) { _isEnable = val; }
+  /*! \brief get index of the node state in the routing graph, which is also
+   *         the vertex of the node in the fast routing graph
+   */
+  unsigned getGraphIndex() const { return _graph_index; }
 
 private:
 
@@ -321,14 +373,11 @@ private:
   bool               _isLogicalQubit;  //!< indicates if the qubit is combined with two physical qubits
   bool               _isPass;         //!< inidcates if the qubit is passing node
 
-  unsigned           _load;           //!< number of load
-  unsigned           _capacity;       //!< capacity of each routing node
-  bool               _is_currently_used;  //!< multi target wire with shared routing node
+  RoutingNodeState   _own_state;      //!< state before the node is bound to the routing graph
+  RoutingNodeState*  _state;          //!< current state of the node
+  unsigned           _graph_index;    //!< index of the state in the routing graph
 
   static double   _congestion_cost;   //!< congestion factor used in NBR algorithm
-  double          _history_cost;      //!< history cost used in NBR algorithm
-
-  bool            _isEnable;          //!< if the routing node can be used to route
 
 
 };
@@ -412,6 +461,10 @@ public:
 
   std::vector<RoutingNode*>& getNodes() { return _nodes; }
 
+  /*! \brief get placement and routing grid
+   */
+  ParGrid* getGrid() const { return _grid; }
+
   
 
 private:
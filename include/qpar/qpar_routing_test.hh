@@ -29,6 +29,9 @@
 
 
 class ParSystem;
+class RoutingGraph;
+class FastRoutingGraph;
+class RoutingCost;
 
 class RoutingTester {
 
@@ -42,8 +45,20 @@ public:
    */
   void testRoutingGraph();
 
+  /*! \brief route every target with the single and the bidirectional
+   *         search and check both paths cost the same
+   */
+  void testBidirectionalRoute();
+
 private:
 
+  /*! \brief compare the single and the bidirectional search with the same astar factor,
+   *         the numbers of expanded vertices of both searches are added to the counters
+   */
+  void compareBidirectionalRoute(RoutingGraph& graph, FastRoutingGraph& fast_g, RoutingCost& cost,
+      double astar_fac, unsigned& single_expanded, unsigned& bidir_expanded);
+
+
   ParSystem* _par_system; //!< placement and routing system
 
 
@@ -0,0 +1,195 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+#ifndef QPAR_SCHEDULE_HH
+#define QPAR_SCHEDULE_HH
+
+/*!
+ * \file qpar_schedule.hh
+ * \author Juexiao Su
+ * \date 05 Mar 2018
+ * \brief annealing schedules, cooling, move radius, moves per temperature and exit
+ */
+
+#include <string>
+#include <chrono>
+
+
+/*! \brief statistics of the moves tried at one temperature
+ */
+struct AnnealStat {
+  int move_num; //!< number of moves tried
+  float success_rate; //!< accepted moves over tried moves
+  double cost_std; //!< standard deviation of the cost after each accepted move
+  double unit_cost; //!< total cost over number of wires
+
+  AnnealStat() :
+    move_num(0),
+    success_rate(0.0f),
+    cost_std(0.0),
+    unit_cost(0.0) {}
+};
+
+
+/*! \brief interface of annealing schedules
+ *
+ * The annealer asks the schedule for the next temperature and move radius
+ * after each temperature, and the placer asks it how many moves to try at
+ * a temperature and when to stop.
+ */
+class ParSchedule {
+
+public:
+  /*! \brief type of annealing schedule
+   */
+  enum SCHEDULE_TYPE {SCHEDULE_DEFAULT, SCHEDULE_VPR, SCHEDULE_LAM, SCHEDULE_BUDGET};
+
+  ParSchedule() : _move_limit(0), _temperature_num(0) {}
+
+  virtual ~ParSchedule() {}
+
+  /*! \brief start annealing
+   *  \param int number of moves per temperature chosen by the placer
+   */
+  virtual void start(int move_limit);
+
+  /*! \brief get number of moves to try at the current temperature
+   */
+  int getMoveLimit() const { return _move_limit; }
+
+  /*! \brief get number of finished temperatures
+   */
+  int getTemperatureNum() const { return _temperature_num; }
+
+  /*! \brief compute the next temperature
+   *  \param float current temperature
+   *  \param float current move radius
+   *  \param AnnealStat statistics of the current temperature
+   *  \return float next temperature
+   */
+  virtual float updateT(float t, float r_limit, const AnnealStat& stat) = 0;
+
+  /*! \brief compute the next move radius, the radius is kept where about 44% of the moves are accepted
+   *  \param float current move radius
+   *  \param float maximum move radius
+   *  \param float success rate of the current temperature
+   */
+  virtual float updateRLimit(float r_limit, float r_max, float success_rate) const;
+
+  /*! \brief check if annealing should stop
+   *  \param float current temperature
+   *  \param float total cost over number of wires
+   */
+  virtual bool shouldExit(float t, float unit_cost) const = 0;
+
+  /*! \brief create schedule by type
+   *  \param SCHEDULE_TYPE type
+   *  \param double seconds of annealing, only used by the budget schedule
+   */
+  static ParSchedule* create(SCHEDULE_TYPE type, double budget);
+
+  /*! \brief convert name to type
+   *  \return bool false if name is unknown
+   */
+  static bool getType(const std::string& name, SCHEDULE_TYPE& type);
+
+  /*! \brief get name of type
+   */
+  static const char* getTypeName(SCHEDULE_TYPE type);
+
+protected:
+  int _move_limit; //!< moves to try at the current temperature
+  int _temperature_num; //!< number of finished temperatures
+};
+
+
+/*! \brief the original schedule of the placer
+ *
+ * Cooling speed is chosen from the success rate, annealing stops at
+ * 0.08 times the unit cost or after 106 temperatures.
+ */
+class DefaultSchedule : public ParSchedule {
+
+public:
+  virtual float updateT(float t, float r_limit, const AnnealStat& stat);
+  virtual bool shouldExit(float t, float unit_cost) const;
+};
+
+
+/*! \brief adaptive schedule of VPR
+ *
+ * T is multiplied by 0.5, 0.9, 0.95 or 0.8 when the success rate is above
+ * 0.96, above 0.8, above 0.15 or below, annealing stops at 0.005 times the
+ * unit cost.
+ */
+class VPRSchedule : public ParSchedule {
+
+public:
+  virtual float updateT(float t, float r_limit, const AnnealStat& stat);
+  virtual bool shouldExit(float t, float unit_cost) const;
+};
+
+
+/*! \brief Lam-Delosme schedule
+ *
+ * The inverse temperature s = 1/T is increased by
+ * lambda / sigma * 1 / (s sigma)^2 * 4 rho (1 - rho)^2 / (2 - rho)^2,
+ * sigma is the cost deviation and rho the success rate, so the cooling is
+ * slow when the cost fluctuates and fast when nothing is accepted.
+ */
+class LamSchedule : public ParSchedule {
+
+public:
+  virtual float updateT(float t, float r_limit, const AnnealStat& stat);
+  virtual bool shouldExit(float t, float unit_cost) const;
+};
+
+
+/*! \brief schedule that finishes annealing within a wall clock budget
+ *
+ * T is cooled at a fixed rate so the number of temperatures left to the
+ * exit temperature is known. After each temperature the time per move is
+ * measured and the moves per temperature are scaled so the remaining
+ * temperatures use the remaining time. Annealing stops at the deadline.
+ */
+class BudgetSchedule : public ParSchedule {
+
+public:
+  /*! \brief default constructor
+   *  \param double seconds of annealing
+   */
+  BudgetSchedule(double budget) : _budget(budget), _base_move_limit(0), _total_move(0) {}
+
+  virtual void start(int move_limit);
+  virtual float updateT(float t, float r_limit, const AnnealStat& stat);
+  virtual bool shouldExit(float t, float unit_cost) const;
+
+private:
+  /*! \brief get seconds since start
+   */
+  double getElapsed() const;
+
+  double _budget; //!< seconds of annealing
+  int _base_move_limit; //!< moves per temperature chosen by the placer
+  std::chrono::steady_clock::time_point _start_time; //!< time of start
+  double _total_move; //!< moves tried since start
+};
+
+
+#endif
@@ -32,6 +32,9 @@ class ParTarget;
 class HW_Target_Dwave;
 class RoutingGraph;
 class FastRoutingGraph;
+class ParRouteCongestion;
+struct PlaceOption;
+struct RouteOption;
 
 /*! \brief a status struct to inidcate the Par status
  */
@@ -60,6 +63,9 @@ public:
     _hw_target(hw_target),
     _par_netlist(NULL),
     _par_target(NULL),
+    _routing_graph(NULL),
+    _fast_routing_graph(NULL),
+    _place_option(NULL),
     _rand_gen(NULL) {}
 
   /*! \brief default destructor
@@ -82,14 +88,30 @@ public:
   void initNetlist();
 
   /*! \brief perform constraints placement
+   *  \param PlaceOption placement options
    *  \return void
    */
-  void doPlacement();
+  void doPlacement(const PlaceOption& option);
 
-  /*! \brief perform chain routing
+  /*! \brief measure the speed of placement moves on the initial placement
+   *  \param PlaceOption placement options
+   *  \param int number of moves
+   *  \param float annealing temperature
    *  \return void
    */
-  void doRoute();
+  void benchPlacement(const PlaceOption& option, int num_move, float temperature);
+
+  /*! \brief restore a placement written by QPlace::dumpCurrentPlacement
+   *  \param std::string placement file
+   *  \return void
+   */
+  void readPlacement(const std::string& filename);
+
+  /*! \brief perform chain routing, a failed routing can be fed back to placement
+   *  \param RouteOption routing options
+   *  \return void
+   */
+  void doRoute(const RouteOption& option);
 
   /*! \brief perform configuration generation
    */
@@ -129,6 +151,18 @@ public:
   friend class PlacementTester;
 
 private:
+  /*! \brief build the routing graph of the current placement and route the netlist
+   *  \param RouteOption routing options
+   *  \param bool restore routes of the eco file
+   *  \return bool true if the routing is valid
+   */
+  bool routeNetlist(const RouteOption& option, bool use_eco);
+
+  /*! \brief anneal the current placement at a low temperature with the routing congestion
+   *  \param ParRouteCongestion& congestion of the failed routings
+   */
+  void refinePlacement(const ParRouteCongestion& congestion);
+
   static ParSystem* _system; //<! qpar system, a global data structure
  
   SYN::Model* _syn_netlist; //<! netlist from synthesis tool
@@ -138,6 +172,7 @@ private:
   ParTarget* _par_target; //!< hardware file used in placement and routing
   RoutingGraph* _routing_graph; //!< routing graph
   FastRoutingGraph* _fast_routing_graph; //!< fast routing graph
+  PlaceOption* _place_option; //!< options of the last placement, reused to refine it
 
   ParStatus _status; //!< system status indicates the the initializing procedure
   RandomGenerator* _rand_gen; //!< a random number generator used across entire qpar system
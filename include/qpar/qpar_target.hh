@@ -48,6 +48,7 @@ class ParGrid {
 
 public:
   ParGrid(HW_Cell* cell) : _cell(cell),
+   _element(NULL),
    _canbeplaced(true) {
     _grid_index = _grid_index_counter;
     ++_grid_index_counter;
@@ -116,8 +117,9 @@ class ParGridContainer : public std::vector<ParGrid*> {
   };
 public:
   /*! \brief shuffle the order of ParGrid*
+   *  \param unsigned seed of the shuffle
    */
-  void shuffle();
+  void shuffle(unsigned seed = 0);
 
   /*! \brief sort the containter based on id
    */
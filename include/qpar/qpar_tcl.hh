@@ -26,6 +26,8 @@
 TCL_COMMAND_DEFINE(QCOMMAND_build_qpar_nl)
 TCL_COMMAND_DEFINE(QCOMMAND_init_system)
 TCL_COMMAND_DEFINE(QCOMMAND_place)
+TCL_COMMAND_DEFINE(QCOMMAND_read_placement)
+TCL_COMMAND_DEFINE(QCOMMAND_bench_place)
 TCL_COMMAND_DEFINE(QCOMMAND_check_routing_graph)
 TCL_COMMAND_DEFINE(QCOMMAND_route)
 
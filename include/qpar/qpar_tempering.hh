@@ -0,0 +1,116 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+#ifndef QPAR_TEMPERING_HH
+#define QPAR_TEMPERING_HH
+
+/*!
+ * \file qpar_tempering.hh
+ * \author Juexiao Su
+ * \date 13 Feb 2018
+ * \brief parallel tempering (replica exchange) placement
+ */
+
+#include "qpar/qpar_place.hh"
+#include "qpar/qpar_utils.hh"
+
+#include <vector>
+#include <string>
+
+namespace SYN {
+  class Model;
+}
+
+class HW_Target_Dwave;
+class ParNetlist;
+class ParTarget;
+class ParThreadPool;
+
+
+/*! \brief replica exchange placement engine
+ *
+ * Each replica is a QPlace over its own ParNetlist and ParTarget, so the
+ * element, grid and wire states of different replicas never alias. Replicas
+ * anneal at fixed temperatures on a geometric ladder in parallel, the ladder is
+ * only scaled up during the first sweeps to leave the random initial placement.
+ * After every sweep, neighbouring temperatures exchange their replicas with the
+ * Metropolis criterion, which is the same as swapping the configurations. Replica 0
+ * uses the netlist and target of the system and receives the best placement at the end.
+ */
+class ParTempering {
+
+public:
+  /*! \brief default constructor
+   *  \param SYN::Model* model to build the netlist copies
+   *  \param HW_Target_Dwave* hardware to build the target copies
+   *  \param ParNetlist* netlist of the system
+   *  \param ParTarget* target of the system
+   *  \param PlaceOption placement options
+   */
+  ParTempering(SYN::Model* model, HW_Target_Dwave* hw_target,
+      ParNetlist* netlist, ParTarget* target, const PlaceOption& option);
+
+  /*! \brief delete the replica copies
+   */
+  ~ParTempering();
+
+  /*! \brief execute placement
+   */
+  void run();
+
+  /*! \brief print placement of the system netlist
+   */
+  void dumpCurrentPlacement(std::string filename) const;
+
+private:
+  ParTempering(const ParTempering&); //!< non-copyable
+
+  /*! \brief anneal the replicas assigned to one thread for a sweep
+   */
+  void annealReplicas(unsigned thread_id);
+
+  /*! \brief try to exchange the replicas of neighbouring temperatures
+   *  \param unsigned 0 or 1, the first temperature of the pairs
+   *  \return unsigned number of exchanges
+   */
+  unsigned exchangeReplicas(unsigned parity);
+
+  SYN::Model* _model; //!< model from synthesis
+  HW_Target_Dwave* _hw_target; //!< hardware target
+  PlaceOption _option; //!< placement options
+
+  std::vector<ParNetlist*> _netlists; //!< netlist of each replica, the first one is not owned
+  std::vector<ParTarget*> _targets; //!< target of each replica, the first one is not owned
+  std::vector<QPlace*> _placers; //!< placer of each replica
+
+  std::vector<float> _temperatures; //!< temperature ladder from cold to hot
+  std::vector<float> _radius; //!< move radius of each temperature
+  std::vector<unsigned> _replica_at; //!< replica annealing at each temperature
+  std::vector<unsigned> _success_num; //!< accepted moves of each temperature in the last sweep
+
+  int _sweep_moves; //!< moves of each replica between two exchanges
+  float _scale; //!< scale of the ladder in the current sweep
+
+  ParThreadPool* _thread_pool; //!< threads that anneal the replicas
+  RandomGenerator _random_gen; //!< random numbers of the exchanges
+
+};
+
+
+#endif
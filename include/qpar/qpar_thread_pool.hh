@@ -0,0 +1,88 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+#ifndef QPAR_THREAD_POOL_HH
+#define QPAR_THREAD_POOL_HH
+
+/*!
+ * \file qpar_thread_pool.hh
+ * \author Juexiao Su
+ * \date 09 Feb 2018
+ * \brief a fixed set of worker threads that run the same job together
+ */
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+
+/*! \brief fork-join thread pool
+ *
+ * run() hands the job to every thread and returns after all of them
+ * finished it. The calling thread works as thread 0, so a pool of N
+ * threads owns N-1 workers. The workers sleep between jobs, which keeps
+ * the cost of a short job in a hot loop low compared to creating threads.
+ */
+class ParThreadPool {
+
+public:
+  typedef std::function<void(unsigned)> JOB; //!< job takes the thread id
+
+  /*! \brief default constructor
+   *  \param unsigned number of threads including the calling thread
+   */
+  ParThreadPool(unsigned thread_num);
+
+  /*! \brief stop and join all workers
+   */
+  ~ParThreadPool();
+
+  /*! \brief get number of threads including the calling thread
+   */
+  unsigned getThreadNum() const { return _thread_num; }
+
+  /*! \brief run job(thread_id) on every thread and wait for all of them
+   */
+  void run(const JOB& job);
+
+private:
+  ParThreadPool(const ParThreadPool&); //!< non-copyable
+
+  /*! \brief worker thread main loop
+   */
+  void workerLoop(unsigned thread_id);
+
+  unsigned _thread_num; //!< number of threads including the calling thread
+  std::vector<std::thread> _workers; //!< worker threads
+
+  std::mutex _mutex; //!< protect the job status below
+  std::condition_variable _start_cond; //!< notify workers of a new job
+  std::condition_variable _finish_cond; //!< notify the caller that workers are done
+
+  const JOB* _job; //!< current job
+  unsigned _job_index; //!< increased for every job
+  unsigned _running; //!< number of workers still running the current job
+  bool _stop; //!< workers should exit
+
+};
+
+
+#endif
@@ -29,6 +29,9 @@
 
 #include <random>
 
+class ParSchedule;
+struct AnnealStat;
+
 
 /* \brief this is a random generator used in the entire binary
  * 
@@ -75,34 +78,23 @@ private:
 
 class Annealer {
 
-  const float annealer_best_rate = 0.44f;
-  const float annealer_step_1 = 0.96f;
-  const float annealer_step_2 = 0.8f;
-  const float annealer_step_3 = 0.15f;
-  const float annealer_cool_speed1 = 0.2f;
-  const float annealer_cool_speed2 = 0.75f;
-  const float annealer_cool_speed3 = 0.85f;
-  const float annealer_cool_speed4 = 0.6f;
-
 public:
 
-  /*! brief default construtor
+  /*! brief default construtor, cooling follows the default schedule
    */
-  Annealer(float init_t, float b_factor, float r_max) :
-    _initial_t(init_t),
-    _current_t(init_t),
-    _radius_max(r_max),
-    _radius_limit(r_max),
-    _boltzmann(b_factor) {
-      _rand = new RandomGenerator;
-    }
+  Annealer(float init_t, float b_factor, float r_max, int seed = 2);
 
   /*\brief default destructor
    */
-  ~Annealer() {
-    if (_rand) delete _rand;
-    _rand = NULL;
-  }
+  ~Annealer();
+
+  /*! \brief replace the annealing schedule, the annealer takes ownership
+   */
+  void setSchedule(ParSchedule* schedule);
+
+  /*! \brief get annealing schedule
+   */
+  ParSchedule* getSchedule() const { return _schedule; }
 
   /*! \brief get current temperature
    *  \return float current temperature
@@ -115,6 +107,10 @@ public:
    */
   void updateT(float success_rate);
 
+  /*! \brief update temperature by the statistics of the current temperature
+   */
+  void updateT(const AnnealStat& stat);
+
   /*! \brief update temperature by given success rate
    *  \param float success rate 
    */
@@ -153,7 +149,10 @@ public:
 
 private:
 
+  Annealer(const Annealer&); //!< non-copyable
+
   RandomGenerator* _rand; //!< random nubmer gen
+  ParSchedule* _schedule; //!< cooling, move radius and exit
 
   float _initial_t; //!< intial temperature
   float _current_t; //!< current temperature
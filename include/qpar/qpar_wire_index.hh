@@ -0,0 +1,155 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+#ifndef QPAR_WIRE_INDEX_HH
+#define QPAR_WIRE_INDEX_HH
+
+/*!
+ * \file qpar_wire_index.hh
+ * \author Juexiao Su
+ * \date 02 Feb 2018
+ * \brief spatial index from chimera cell to the wires whose bounding box covers it
+ */
+
+#include "hw_target/hw_loc.hh"
+
+#include <vector>
+
+class ParPlaceDB;
+
+
+/*! \brief grid bucketed wire index
+ *
+ * The target is divided into square buckets of bucket_size x bucket_size cells.
+ * A wire is registered in every bucket its current bounding box overlaps, so
+ * looking up the wires that cover a cell only visits the wires of one bucket.
+ * Each wire remembers its slot in every bucket, which makes removal O(1).
+ * Wires are indices of the placement database.
+ */
+class ParWireIndex {
+
+public:
+  /*! \brief default constructor
+   *  \param ParPlaceDB* placement database with the bounding boxes
+   *  \param COORD number of cells on x direction
+   *  \param COORD number of cells on y direction
+   *  \param unsigned bucket size in cells
+   */
+  ParWireIndex(ParPlaceDB* place_db, COORD x_limit, COORD y_limit, unsigned bucket_size);
+
+  /*! \brief default destructor
+   */
+  ~ParWireIndex() {}
+
+  /*! \brief register a wire with its current bounding box
+   */
+  void insertWire(unsigned wire);
+
+  /*! \brief unregister a wire from all buckets
+   */
+  void removeWire(unsigned wire);
+
+  /*! \brief move the wire to the buckets covered by its current bounding box
+   */
+  void updateWire(unsigned wire);
+
+  /*! \brief collect the wires whose current bounding box covers the cell
+   *  \param COORD x coordinate
+   *  \param COORD y coordinate
+   *  \param unsigned move stamp, found wires without the stamp are stamped in the database
+   *  \param std::vector<unsigned>& stamped wires are appended
+   */
+  void collectWires(COORD x, COORD y, unsigned stamp, std::vector<unsigned>& wires);
+
+  /*! \brief collect the wires whose current bounding box covers the cell
+   *  \param COORD x coordinate
+   *  \param COORD y coordinate
+   *  \param std::vector<unsigned>& found wires are appended, duplicates are not removed
+   */
+  void collectWires(COORD x, COORD y, std::vector<unsigned>& wires) const;
+
+  /*! \brief check the buckets against the current bounding box of each wire
+   */
+  bool sanityCheck() const;
+
+  /*! \brief get bucket size in cells
+   */
+  unsigned getBucketSize() const { return _bucket_size; }
+
+  /*! \brief pick a bucket size that splits the target into at most 16 buckets per side
+   */
+  static unsigned getDefaultBucketSize(COORD x_limit, COORD y_limit);
+
+private:
+
+  /*! \brief bucket range and slots of a registered wire
+   */
+  struct WireEntry {
+    int bxl; //!< left most bucket
+    int bxr; //!< right most bucket
+    int byt; //!< top most bucket
+    int byb; //!< bottom most bucket
+    std::vector<unsigned> slots; //!< position in each covered bucket, row major in the bucket range
+    bool registered; //!< if the wire is in the index
+
+    WireEntry() : bxl(0), bxr(-1), byt(0), byb(-1), registered(false) {}
+
+    /*! \brief check if the bucket is in the range
+     */
+    bool covers(int bx, int by) const {
+      return bx >= bxl && bx <= bxr && by >= byt && by <= byb;
+    }
+
+    /*! \brief get the slot index of a bucket in the range
+     */
+    unsigned slotIndex(int bx, int by) const {
+      return (unsigned)((by - byt) * (bxr - bxl + 1) + (bx - bxl));
+    }
+  };
+
+  /*! \brief get the entry of a wire
+   */
+  WireEntry& getEntry(unsigned wire);
+
+  /*! \brief compute the bucket range of the wire's current bounding box
+   */
+  void getBucketRange(unsigned wire, int& bxl, int& bxr, int& byt, int& byb) const;
+
+  /*! \brief get bucket index
+   */
+  unsigned bucketIndex(int bx, int by) const {
+    return (unsigned)(by * _bucket_num_x + bx);
+  }
+
+  /*! \brief remove a wire from one bucket and fix the slot of the wire filling the hole
+   */
+  void removeFromBucket(int bx, int by, unsigned slot);
+
+  ParPlaceDB* _place_db; //!< placement database with the bounding boxes
+  unsigned _bucket_size; //!< number of cells on each side of a bucket
+  int _bucket_num_x; //!< number of buckets on x direction
+  int _bucket_num_y; //!< number of buckets on y direction
+
+  std::vector<std::vector<unsigned> > _buckets; //!< wires registered in each bucket
+  std::vector<WireEntry> _entries; //!< wire entries indexed by wire
+
+};
+
+
+#endif
@@ -115,6 +115,32 @@ protected:
    *  \return bool
    */
   bool getIntOption(const int argc, const char** argv, const char* option_name, int& value);
+
+  /*! \brief get double value by given the argument name
+   *  \param argc argument count
+   *  \param argv argument vector
+   *  \param option_name argument name
+   *  \param double& return result
+   *  \return bool
+   */
+  bool getDoubleOption(const int argc, const char** argv, const char* option_name, double& value);
+
+  /*! \brief get string value by given the argument name
+   *  \param argc argument count
+   *  \param argv argument vector
+   *  \param option_name argument name
+   *  \param std::string& return result
+   *  \return bool
+   */
+  bool getStringOption(const int argc, const char** argv, const char* option_name, std::string& value);
+
+  /*! \brief check if certain argument exists
+   *  \param argc argument count
+   *  \param argv argument vector
+   *  \param option_name the name of argument needs to check
+   *  \return bool indicate weather the argument exists
+   */
+  bool isOptionExist(const int argc, const char** argv, const char* option_name);
 private:
 
   /*! \brief return a detailed help message
@@ -138,14 +164,6 @@ private:
   int getOptionIndex(const int argc, const char** argv, const char* option_name);
 
 
-  /*! \brief check if certain argument exists
-   *  \param argc argument count
-   *  \param argv argument vector
-   *  \param option_name the name of argument needs to check
-   *  \return bool indicate weather the argument exists
-   */
-  bool isOptionExist(const int argc, const char** argv, const char* option_name);
-
 
 
 
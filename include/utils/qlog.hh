@@ -106,6 +106,13 @@ public:
    */
   void skipLine();
 
+  /*!
+   * \brief silence speak on the calling thread, the message buffer is shared
+   *        so only one thread may speak at a time
+   * \param quiet true to drop messages of this thread
+   */
+  void setThreadQuiet(bool quiet);
+
 
 private:
 
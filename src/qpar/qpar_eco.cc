@@ -0,0 +1,255 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+/*!
+ * \file qpar_eco.cc
+ * \author Juexiao Su
+ * \date 21 Feb 2018
+ * \brief incremental placement and routing from a previous result
+ */
+
+#include "qpar/qpar_eco.hh"
+#include "qpar/qpar_netlist.hh"
+#include "qpar/qpar_target.hh"
+#include "qpar/qpar_place.hh"
+#include "qpar/qpar_route.hh"
+#include "qpar/qpar_routing_graph.hh"
+#include "syn/netlist.h"
+
+#include "utils/qlog.hh"
+
+#include <cstdio>
+#include <fstream>
+#include <list>
+#include <sstream>
+
+
+unsigned ParEco::fixPlacement(const std::string& filename) {
+  PLACE_LOCS locations;
+  if (!QPlace::readPlacement(filename, locations))
+    qlog.speakError("ECO: Cannot open %s to read", filename.c_str());
+
+  unsigned fixed_num = 0;
+  unsigned conflict_num = 0;
+  ELE_ITER ele_iter = _netlist->element_begin();
+  for (; ele_iter != _netlist->element_end(); ++ele_iter) {
+    ParElement* element = *ele_iter;
+    PLACE_LOCS::const_iterator loc_iter = locations.find(element->getName());
+    if (loc_iter == locations.end())
+      continue;
+
+    ParGrid* grid = _target->getGrid(loc_iter->second.first, loc_iter->second.second);
+    if (!grid || !grid->canBePlaced() || grid->getCurrentElement()) {
+      ++conflict_num;
+      continue;
+    }
+
+    element->setGrid(grid);
+    element->save();
+    grid->setParElement(element);
+    grid->save();
+    element->setMovable(false);
+    ++fixed_num;
+  }
+
+  qlog.speak("ECO", "%u of %lu elements keep their grids in %s, %lu elements are removed",
+      fixed_num, _netlist->getElementNumber(), filename.c_str(),
+      locations.size() - fixed_num - conflict_num);
+  if (conflict_num)
+    qlog.speak("ECO", "%u elements cannot keep their grids and are placed again", conflict_num);
+
+  return fixed_num;
+}
+
+unsigned ParEco::restoreRoutes(const std::string& filename, RoutingGraph* graph) {
+  std::ifstream infile(filename.c_str());
+  if (!infile.is_open())
+    qlog.speakError("ECO: Cannot open %s to read", filename.c_str());
+
+  // a target is identified by its wire and its target pin
+  std::unordered_map<std::string, std::vector<std::string> > routes;
+  std::string line;
+  while (std::getline(infile, line)) {
+    std::string wire_name;
+    std::vector<std::string> tokens;
+    if (!parseRoute(line, wire_name, tokens))
+      continue;
+    routes[wire_name + " " + tokens.back()].swap(tokens);
+  }
+
+  unsigned restored_num = 0;
+  unsigned target_num = 0;
+  std::vector<ParWireTarget*>& targets = _netlist->getTargets();
+  for (size_t i = 0; i < targets.size(); ++i) {
+    ParWireTarget* target = targets[i];
+    if (target->getDontRoute())
+      continue;
+    ++target_num;
+
+    ParWire* wire = target->getWire();
+    std::unordered_map<std::string, std::vector<std::string> >::const_iterator r_iter =
+      routes.find(wire->getName() + " " + getPinName(target->getTargetPin()));
+    if (r_iter == routes.end())
+      continue;
+
+    RoutePath* path = buildRoutePath(target, r_iter->second, graph);
+    if (!path)
+      continue;
+
+    // same bookkeeping as a routed target
+    wire->markUsedRoutingResource();
+    target->setRoutePath(path);
+    wire->updateWireRoute(path);
+    wire->unmarkUsedRoutingResource();
+    ++restored_num;
+  }
+
+  qlog.speak("ECO", "%u of %u targets keep their routes in %s, %u targets are routed again",
+      restored_num, target_num, filename.c_str(), target_num - restored_num);
+
+  return restored_num;
+}
+
+std::string ParEco::getPinName(SYN::Pin* pin) {
+  // same as ParWireTarget::printRoute
+  if (pin->isModelPin())
+    return "model." + pin->getName();
+  return pin->getGate()->getName() + "." + pin->getName();
+}
+
+bool ParEco::parseRoute(const std::string& line, std::string& wire_name,
+    std::vector<std::string>& tokens) {
+  const std::string tag = "Wire: ";
+  if (line.compare(0, tag.size(), tag) != 0)
+    return false;
+
+  size_t pos = line.find(' ', tag.size());
+  if (pos == std::string::npos)
+    return false;
+  wire_name = line.substr(tag.size(), pos - tag.size());
+
+  // pin names can have parentheses, match them
+  tokens.clear();
+  while (pos < line.size()) {
+    if (line[pos] == ' ') {
+      ++pos;
+    } else if (line.compare(pos, 2, "->") == 0) {
+      tokens.push_back("->");
+      pos += 2;
+    } else if (line[pos] == '(') {
+      size_t begin = pos + 1;
+      unsigned depth = 1;
+      for (++pos; pos < line.size() && depth; ++pos) {
+        if (line[pos] == '(')
+          ++depth;
+        else if (line[pos] == ')')
+          --depth;
+      }
+      if (depth)
+        return false;
+      tokens.push_back(line.substr(begin, pos - 1 - begin));
+    } else {
+      return false;
+    }
+  }
+
+  // a route starts and ends with a pin
+  return tokens.size() >= 2 && tokens.front() != "->" && tokens.back() != "->";
+}
+
+RoutePath* ParEco::buildRoutePath(ParWireTarget* target, const std::vector<std::string>& tokens,
+    RoutingGraph* graph) const {
+  if (tokens.front() != getPinName(target->getSourcePin()) ||
+      tokens.back() != getPinName(target->getTargetPin()))
+    return NULL;
+
+  RoutingNode* src_node = graph->getRoutingNode(target->getSourceElement(), target->getSourcePin());
+  RoutingNode* tgt_node = graph->getRoutingNode(target->getTargetElement(), target->getTargetPin());
+  if (!src_node || !tgt_node)
+    return NULL;
+
+  std::list<RoutingNode*> nodes;
+  nodes.push_back(src_node);
+  bool after_interaction = false;
+  for (size_t i = 1; i + 1 < tokens.size(); ++i) {
+    if (tokens[i] == "->") {
+      if (after_interaction)
+        return NULL;
+      after_interaction = true;
+      continue;
+    }
+
+    long long x = 0;
+    long long y = 0;
+    long long local = 0;
+    int len = 0;
+    if (sscanf(tokens[i].c_str(), "%lld,%lld,%lld%n", &x, &y, &local, &len) != 3)
+      return NULL;
+    std::string rest = tokens[i].substr((size_t)len);
+    if (!rest.empty() && rest != ", is_logic")
+      return NULL;
+
+    RoutingNode* node = graph->getRoutingNode((COORD)x, (COORD)y, (COORD)local);
+    if (!node || !node->isEnabled() || node->isLogic() != !rest.empty())
+      return NULL;
+
+    if (after_interaction) {
+      RoutingNode* interaction = findInteraction(nodes.back(), node);
+      if (!interaction)
+        return NULL;
+      nodes.push_back(interaction);
+      after_interaction = false;
+    }
+    nodes.push_back(node);
+  }
+  if (after_interaction)
+    return NULL;
+  nodes.push_back(tgt_node);
+
+  std::list<RoutingEdge*> edges;
+  std::list<RoutingNode*>::const_iterator n_iter = nodes.begin();
+  std::list<RoutingNode*>::const_iterator prev_iter = n_iter++;
+  for (; n_iter != nodes.end(); prev_iter = n_iter++) {
+    RoutingEdge* edge = findEdge(*prev_iter, *n_iter);
+    if (!edge)
+      return NULL;
+    edges.push_back(edge);
+  }
+
+  return new RoutePath(nodes, edges);
+}
+
+RoutingEdge* ParEco::findEdge(RoutingNode* node1, RoutingNode* node2) {
+  EDGES::iterator e_iter = node1->getEdges().begin();
+  for (; e_iter != node1->getEdges().end(); ++e_iter) {
+    if ((*e_iter)->getOtherNode(node1) == node2)
+      return *e_iter;
+  }
+  return NULL;
+}
+
+RoutingNode* ParEco::findInteraction(RoutingNode* qubit1, RoutingNode* qubit2) {
+  EDGES::iterator e_iter = qubit1->getEdges().begin();
+  for (; e_iter != qubit1->getEdges().end(); ++e_iter) {
+    RoutingNode* node = (*e_iter)->getOtherNode(qubit1);
+    if (node->isInteraction() && node->isEnabled() && findEdge(node, qubit2))
+      return node;
+  }
+  return NULL;
+}
@@ -0,0 +1,407 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+/*!
+ * \file qpar_global_place.cc
+ * \author Juexiao Su
+ * \date 16 Feb 2018
+ * \brief quadratic global placement and legalization onto grids
+ */
+
+#include "qpar/qpar_global_place.hh"
+#include "qpar/qpar_netlist.hh"
+#include "qpar/qpar_target.hh"
+
+#include "utils/qlog.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+// number of solve and spread iterations
+static const int global_place_iter_num = 20;
+
+// anchor weight of the first iteration relative to the average laplacian diagonal,
+// the weight grows linearly with the iterations
+static const double global_place_anchor_weight = 0.02;
+
+// used grids over placeable grids inside the placement region
+static const double global_place_density = 0.15;
+
+// conjugate gradient stopping criteria
+static const double global_place_cg_tolerance = 1e-5;
+static const unsigned global_place_cg_max_iter = 500;
+
+
+void ParSparseMatrix::addEntry(unsigned row, unsigned col, double val) {
+  QASSERT(row < _size && col < _size);
+  Entry entry;
+  entry.row = row;
+  entry.col = col;
+  entry.val = val;
+  _entries.push_back(entry);
+}
+
+void ParSparseMatrix::compress() {
+  // every row has a diagonal entry
+  for (unsigned i = 0; i < _size; ++i)
+    addEntry(i, i, 0.0);
+
+  std::sort(_entries.begin(), _entries.end());
+
+  _row_begin.assign(_size + 1, 0);
+  _diag_index.assign(_size, 0);
+  _cols.clear();
+  _values.clear();
+
+  for (size_t i = 0; i < _entries.size(); ++i) {
+    const Entry& entry = _entries[i];
+    if (!_cols.empty() && i > 0 &&
+        _entries[i - 1].row == entry.row && _entries[i - 1].col == entry.col) {
+      _values.back() += entry.val;
+      continue;
+    }
+
+    if (entry.row == entry.col)
+      _diag_index[entry.row] = (unsigned)_cols.size();
+    _cols.push_back(entry.col);
+    _values.push_back(entry.val);
+    ++_row_begin[entry.row + 1];
+  }
+
+  for (unsigned i = 0; i < _size; ++i)
+    _row_begin[i + 1] += _row_begin[i];
+
+  _entries.clear();
+}
+
+void ParSparseMatrix::multiply(const std::vector<double>& x, std::vector<double>& y) const {
+  y.resize(_size);
+  for (unsigned i = 0; i < _size; ++i) {
+    double sum = 0.0;
+    for (unsigned j = _row_begin[i]; j < _row_begin[i + 1]; ++j)
+      sum += _values[j] * x[_cols[j]];
+    y[i] = sum;
+  }
+}
+
+unsigned ParSparseMatrix::solve(const std::vector<double>& b, std::vector<double>& x,
+    double tolerance, unsigned max_iter) const {
+  x.resize(_size, 0.0);
+
+  std::vector<double> r(_size);
+  std::vector<double> z(_size);
+  std::vector<double> p(_size);
+  std::vector<double> q(_size);
+
+  multiply(x, q);
+  double b_norm = 0.0;
+  for (unsigned i = 0; i < _size; ++i) {
+    r[i] = b[i] - q[i];
+    b_norm += b[i] * b[i];
+  }
+  b_norm = std::sqrt(b_norm);
+  if (b_norm == 0.0)
+    b_norm = 1.0;
+
+  double rz = 0.0;
+  for (unsigned i = 0; i < _size; ++i) {
+    z[i] = r[i] / diagonal(i);
+    p[i] = z[i];
+    rz += r[i] * z[i];
+  }
+
+  unsigned iter = 0;
+  for (; iter < max_iter; ++iter) {
+    double r_norm = 0.0;
+    for (unsigned i = 0; i < _size; ++i)
+      r_norm += r[i] * r[i];
+    if (std::sqrt(r_norm) <= tolerance * b_norm)
+      break;
+
+    multiply(p, q);
+    double pq = 0.0;
+    for (unsigned i = 0; i < _size; ++i)
+      pq += p[i] * q[i];
+    if (pq <= 0.0)
+      break;
+
+    double alpha = rz / pq;
+    double rz_new = 0.0;
+    for (unsigned i = 0; i < _size; ++i) {
+      x[i] += alpha * p[i];
+      r[i] -= alpha * q[i];
+      z[i] = r[i] / diagonal(i);
+      rz_new += r[i] * z[i];
+    }
+
+    double beta = rz_new / rz;
+    rz = rz_new;
+    for (unsigned i = 0; i < _size; ++i)
+      p[i] = z[i] + beta * p[i];
+  }
+
+  return iter;
+}
+
+
+/*! \brief order element indices by a coordinate, ties are broken by index
+ */
+struct GlobalPlaceCoordCmp {
+  const std::vector<double>* coords;
+
+  bool operator()(unsigned e1, unsigned e2) const {
+    double c1 = (*coords)[e1];
+    double c2 = (*coords)[e2];
+    return c1 < c2 || (c1 == c2 && e1 < e2);
+  }
+};
+
+
+ParGlobalPlace::ParGlobalPlace(ParNetlist* netlist, ParTarget* target) :
+  _netlist(netlist),
+  _target(target),
+  _x_limit(target->getXLimit()),
+  _y_limit(target->getYLimit()),
+  _region_xl(0),
+  _region_xr(0),
+  _region_yt(0),
+  _region_yb(0) {
+}
+
+void ParGlobalPlace::run() {
+  ELE_ITER ele_iter = _netlist->element_begin();
+  for (; ele_iter != _netlist->element_end(); ++ele_iter) {
+    ParElement* element = *ele_iter;
+    _spread_x.push_back(element->getX());
+    _spread_y.push_back(element->getY());
+    _elements.push_back(element);
+  }
+
+  if (_elements.empty())
+    return;
+
+  _capacity.assign((size_t)((_x_limit + 1) * (_y_limit + 1)), 0);
+  unsigned placeable_num = 0;
+  for (COORD x = 0; x < _x_limit; ++x) {
+    for (COORD y = 0; y < _y_limit; ++y) {
+      ParGrid* grid = _target->getGrid(x, y);
+      unsigned used = (grid && grid->canBePlaced()) ? 1 : 0;
+      placeable_num += used;
+      _capacity[(size_t)((x + 1) * (_y_limit + 1) + y + 1)] = used +
+        _capacity[(size_t)(x * (_y_limit + 1) + y + 1)] +
+        _capacity[(size_t)((x + 1) * (_y_limit + 1) + y)] -
+        _capacity[(size_t)(x * (_y_limit + 1) + y)];
+    }
+  }
+  QASSERT(placeable_num >= _elements.size());
+
+  // a region around the center of the target that fits the elements at the target density
+  double fraction = std::min(1.0, (double)_elements.size() / (global_place_density * placeable_num));
+  COORD width = std::max((COORD)1, (COORD)std::ceil(std::sqrt(fraction) * (double)_x_limit));
+  COORD height = std::max((COORD)1, (COORD)std::ceil(std::sqrt(fraction) * (double)_y_limit));
+  _region_xl = (_x_limit - width) / 2;
+  _region_xr = _region_xl + width - 1;
+  _region_yt = (_y_limit - height) / 2;
+  _region_yb = _region_yt + height - 1;
+  while (getCapacity(_region_xl, _region_xr, _region_yt, _region_yb) < _elements.size()) {
+    _region_xl = std::max((COORD)0, _region_xl - 1);
+    _region_xr = std::min(_x_limit - 1, _region_xr + 1);
+    _region_yt = std::max((COORD)0, _region_yt - 1);
+    _region_yb = std::min(_y_limit - 1, _region_yb + 1);
+  }
+
+  buildMatrix();
+
+  double diag_ave = 0.0;
+  for (unsigned i = 0; i < _matrix.size(); ++i)
+    diag_ave += _laplacian_diag[i];
+  diag_ave = std::max(diag_ave / _matrix.size(), 1.0);
+
+  qlog.speak("Place", "Global placement of %lu elements in region (%ld,%ld)-(%ld,%ld)",
+      _elements.size(), (long)_region_xl, (long)_region_yt, (long)_region_xr, (long)_region_yb);
+
+  // the random initial placement is the first anchor
+  _x.assign(_spread_x.begin(), _spread_x.end());
+  _y.assign(_spread_y.begin(), _spread_y.end());
+
+  double best_length = std::numeric_limits<double>::max();
+  for (int iter = 0; iter < global_place_iter_num; ++iter) {
+    solve(global_place_anchor_weight * diag_ave * (iter + 1));
+    spread();
+
+    double length = computeWireLength();
+    if (length < best_length) {
+      best_length = length;
+      _best_x = _spread_x;
+      _best_y = _spread_y;
+    }
+  }
+
+  qlog.speak("Place", "Global placement wire length is %.1f", best_length);
+  commitPlacement();
+}
+
+void ParGlobalPlace::buildMatrix() {
+  // elements of each wire, an element can connect to the same wire twice
+  std::unordered_map<ParWire*, std::vector<unsigned> > wire_elements;
+  for (unsigned i = 0; i < _elements.size(); ++i) {
+    ParElement* element = _elements[i];
+    WIRE_ITER_V w_iter = element->begin();
+    for (; w_iter != element->end(); ++w_iter) {
+      std::vector<unsigned>& pins = wire_elements[*w_iter];
+      if (pins.empty() || pins.back() != i)
+        pins.push_back(i);
+    }
+  }
+
+  _matrix = ParSparseMatrix((unsigned)_elements.size());
+  _laplacian_diag.assign(_elements.size(), 0.0);
+
+  WIRE_ITER w_iter = _netlist->wire_begin();
+  for (; w_iter != _netlist->wire_end(); ++w_iter) {
+    if (!wire_elements.count(*w_iter))
+      continue;
+    const std::vector<unsigned>& pins = wire_elements[*w_iter];
+    _wire_elements.push_back(pins);
+    if (pins.size() < 2)
+      continue;
+
+    double weight = 1.0 / (double)(pins.size() - 1);
+    for (size_t i = 0; i < pins.size(); ++i) {
+      for (size_t j = i + 1; j < pins.size(); ++j) {
+        _matrix.addEntry(pins[i], pins[j], -weight);
+        _matrix.addEntry(pins[j], pins[i], -weight);
+        _laplacian_diag[pins[i]] += weight;
+        _laplacian_diag[pins[j]] += weight;
+      }
+    }
+  }
+
+  _matrix.compress();
+}
+
+void ParGlobalPlace::solve(double anchor_weight) {
+  unsigned size = _matrix.size();
+  std::vector<double> b(size);
+
+  for (unsigned i = 0; i < size; ++i)
+    _matrix.diagonal(i) = _laplacian_diag[i] + anchor_weight;
+
+  for (unsigned i = 0; i < size; ++i)
+    b[i] = anchor_weight * (double)_spread_x[i];
+  _matrix.solve(b, _x, global_place_cg_tolerance, global_place_cg_max_iter);
+
+  for (unsigned i = 0; i < size; ++i)
+    b[i] = anchor_weight * (double)_spread_y[i];
+  _matrix.solve(b, _y, global_place_cg_tolerance, global_place_cg_max_iter);
+}
+
+void ParGlobalPlace::spread() {
+  _order.resize(_elements.size());
+  for (unsigned i = 0; i < _order.size(); ++i)
+    _order[i] = i;
+
+  spreadRegion(0, _order.size(), _region_xl, _region_xr, _region_yt, _region_yb);
+}
+
+void ParGlobalPlace::spreadRegion(size_t begin, size_t end, COORD xl, COORD xr, COORD yt, COORD yb) {
+  if (begin == end)
+    return;
+
+  unsigned capacity = getCapacity(xl, xr, yt, yb);
+  QASSERT(end - begin <= capacity);
+
+  if (xl == xr && yt == yb) {
+    QASSERT(end - begin == 1);
+    _spread_x[_order[begin]] = xl;
+    _spread_y[_order[begin]] = yt;
+    return;
+  }
+
+  // cut the longer side, each half gets elements in proportion to its placeable grids
+  bool cut_x = (xr - xl) >= (yb - yt);
+  COORD mid = cut_x ? (xl + xr) / 2 : (yt + yb) / 2;
+  unsigned low_capacity = cut_x ? getCapacity(xl, mid, yt, yb) : getCapacity(xl, xr, yt, mid);
+  unsigned high_capacity = capacity - low_capacity;
+
+  size_t num = end - begin;
+  size_t low_num = (size_t)std::floor((double)num * low_capacity / capacity + 0.5);
+  low_num = std::max(low_num, num > high_capacity ? num - high_capacity : (size_t)0);
+  low_num = std::min(low_num, (size_t)low_capacity);
+
+  GlobalPlaceCoordCmp cmp;
+  cmp.coords = cut_x ? &_x : &_y;
+  std::sort(_order.begin() + begin, _order.begin() + end, cmp);
+
+  if (cut_x) {
+    spreadRegion(begin, begin + low_num, xl, mid, yt, yb);
+    spreadRegion(begin + low_num, end, mid + 1, xr, yt, yb);
+  } else {
+    spreadRegion(begin, begin + low_num, xl, xr, yt, mid);
+    spreadRegion(begin + low_num, end, xl, xr, mid + 1, yb);
+  }
+}
+
+unsigned ParGlobalPlace::getCapacity(COORD xl, COORD xr, COORD yt, COORD yb) const {
+  size_t stride = (size_t)(_y_limit + 1);
+  return _capacity[(size_t)(xr + 1) * stride + (size_t)(yb + 1)] -
+         _capacity[(size_t)xl * stride + (size_t)(yb + 1)] -
+         _capacity[(size_t)(xr + 1) * stride + (size_t)yt] +
+         _capacity[(size_t)xl * stride + (size_t)yt];
+}
+
+double ParGlobalPlace::computeWireLength() const {
+  double length = 0.0;
+  for (size_t i = 0; i < _wire_elements.size(); ++i) {
+    const std::vector<unsigned>& pins = _wire_elements[i];
+    if (pins.size() < 2)
+      continue;
+
+    COORD xl = _spread_x[pins[0]], xr = xl;
+    COORD yt = _spread_y[pins[0]], yb = yt;
+    for (size_t j = 1; j < pins.size(); ++j) {
+      xl = std::min(xl, _spread_x[pins[j]]);
+      xr = std::max(xr, _spread_x[pins[j]]);
+      yt = std::min(yt, _spread_y[pins[j]]);
+      yb = std::max(yb, _spread_y[pins[j]]);
+    }
+    length += (double)((xr - xl) + (yb - yt));
+  }
+  return length;
+}
+
+void ParGlobalPlace::commitPlacement() {
+  for (size_t i = 0; i < _elements.size(); ++i) {
+    ParGrid* grid = _elements[i]->getCurrentGrid();
+    grid->setParElement(NULL);
+    grid->save();
+  }
+
+  for (size_t i = 0; i < _elements.size(); ++i) {
+    ParElement* element = _elements[i];
+    ParGrid* grid = _target->getGrid(_best_x[i], _best_y[i]);
+    QASSERT(grid && grid->canBePlaced() && grid->getCurrentElement() == NULL);
+    element->setGrid(grid);
+    element->save();
+    grid->setParElement(element);
+    grid->save();
+  }
+}
@@ -0,0 +1,223 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+/*!
+ * \file qpar_move.cc
+ * \author Juexiao Su
+ * \date 23 Feb 2018
+ * \brief move generators of the placer and the agent choosing between them
+ */
+
+#include "qpar/qpar_move.hh"
+#include "qpar/qpar_place_db.hh"
+
+#include "utils/qlog.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// larger wires are ignored by directed moves
+static const size_t move_max_wire_size = 64;
+
+// probability to choose a random move type instead of the best one
+static const float move_agent_epsilon = 0.1f;
+
+// weight of the latest move in the average gain of a move type
+static const double move_agent_step = 0.01;
+
+
+static COORD clampCoord(COORD val, COORD min, COORD max) {
+  return std::min(std::max(val, min), max);
+}
+
+/*! \brief move to a location clamped into the region
+ *  \return bool false if the location is the current one
+ */
+static bool clampMove(const ParPlaceDB& place_db, unsigned element, const ParMoveRegion& region,
+    COORD& x, COORD& y) {
+  x = clampCoord(x, region.x_min, region.x_max);
+  y = clampCoord(y, region.y_min, region.y_max);
+  return x != place_db.getX(element) || y != place_db.getY(element);
+}
+
+bool ParUniformMove::propose(const ParPlaceDB& place_db, unsigned element,
+    const ParMoveRegion& region, RandomGenerator& random_gen, COORD& x, COORD& y) {
+  COORD ele_x = place_db.getX(element);
+  COORD ele_y = place_db.getY(element);
+  do {
+    x = (COORD)random_gen.iRand((int)region.x_min, (int)region.x_max);
+    y = (COORD)random_gen.iRand((int)region.y_min, (int)region.y_max);
+  } while( x == ele_x && y == ele_y );
+  return true;
+}
+
+bool ParMedianMove::propose(const ParPlaceDB& place_db, unsigned element,
+    const ParMoveRegion& region, RandomGenerator& random_gen, COORD& x, COORD& y) {
+  _xs.clear();
+  _ys.clear();
+  const unsigned* w_iter = place_db.wire_begin(element);
+  for (; w_iter != place_db.wire_end(element); ++w_iter) {
+    unsigned wire = *w_iter;
+    if (place_db.getPinNum(wire) > move_max_wire_size)
+      continue;
+
+    COORD xl = std::numeric_limits<COORD>::max();
+    COORD xr = std::numeric_limits<COORD>::min();
+    COORD yt = std::numeric_limits<COORD>::max();
+    COORD yb = std::numeric_limits<COORD>::min();
+    const unsigned* p_iter = place_db.pin_begin(wire);
+    for (; p_iter != place_db.pin_end(wire); ++p_iter) {
+      if (*p_iter == element)
+        continue;
+      xl = std::min(xl, place_db.getX(*p_iter));
+      xr = std::max(xr, place_db.getX(*p_iter));
+      yt = std::min(yt, place_db.getY(*p_iter));
+      yb = std::max(yb, place_db.getY(*p_iter));
+    }
+    if (xl > xr)
+      continue;
+
+    _xs.push_back(xl);
+    _xs.push_back(xr);
+    _ys.push_back(yt);
+    _ys.push_back(yb);
+  }
+
+  if (_xs.empty())
+    return false;
+
+  std::sort(_xs.begin(), _xs.end());
+  std::sort(_ys.begin(), _ys.end());
+  size_t n = _xs.size();
+  x = (COORD)random_gen.iRand((int)_xs[(n - 1) / 2], (int)_xs[n / 2]);
+  y = (COORD)random_gen.iRand((int)_ys[(n - 1) / 2], (int)_ys[n / 2]);
+  return clampMove(place_db, element, region, x, y);
+}
+
+bool ParCentroidMove::propose(const ParPlaceDB& place_db, unsigned element,
+    const ParMoveRegion& region, RandomGenerator& random_gen, COORD& x, COORD& y) {
+  double sum_x = 0.0;
+  double sum_y = 0.0;
+  double sum_weight = 0.0;
+  const unsigned* w_iter = place_db.wire_begin(element);
+  for (; w_iter != place_db.wire_end(element); ++w_iter) {
+    unsigned wire = *w_iter;
+    size_t size = place_db.getPinNum(wire);
+    if (size < 2 || size > move_max_wire_size)
+      continue;
+
+    double weight = 1.0 / (double)(size - 1);
+    const unsigned* p_iter = place_db.pin_begin(wire);
+    for (; p_iter != place_db.pin_end(wire); ++p_iter) {
+      if (*p_iter == element)
+        continue;
+      sum_x += weight * (double)place_db.getX(*p_iter);
+      sum_y += weight * (double)place_db.getY(*p_iter);
+      sum_weight += weight;
+    }
+  }
+
+  if (sum_weight == 0.0)
+    return false;
+
+  x = (COORD)std::floor(sum_x / sum_weight + 0.5);
+  y = (COORD)std::floor(sum_y / sum_weight + 0.5);
+  return clampMove(place_db, element, region, x, y);
+}
+
+bool ParCriticalMove::propose(const ParPlaceDB& place_db, unsigned element,
+    const ParMoveRegion& region, RandomGenerator& random_gen, COORD& x, COORD& y) {
+  int critical_wire = -1;
+  double max_cost = -1.0;
+  const unsigned* w_iter = place_db.wire_begin(element);
+  for (; w_iter != place_db.wire_end(element); ++w_iter) {
+    unsigned wire = *w_iter;
+    size_t size = place_db.getPinNum(wire);
+    if (size < 2 || size > move_max_wire_size)
+      continue;
+    if (place_db.getCost(wire) > max_cost) {
+      max_cost = place_db.getCost(wire);
+      critical_wire = (int)wire;
+    }
+  }
+
+  if (critical_wire < 0)
+    return false;
+
+  _candidates.clear();
+  const unsigned* p_iter = place_db.pin_begin((unsigned)critical_wire);
+  for (; p_iter != place_db.pin_end((unsigned)critical_wire); ++p_iter) {
+    if (*p_iter != element)
+      _candidates.push_back(*p_iter);
+  }
+  if (_candidates.empty())
+    return false;
+
+  unsigned other = _candidates[random_gen.uRand(0, (unsigned)_candidates.size() - 1)];
+  x = place_db.getX(other) + (COORD)random_gen.iRand(-1, 1);
+  y = place_db.getY(other) + (COORD)random_gen.iRand(-1, 1);
+  return clampMove(place_db, element, region, x, y);
+}
+
+ParMoveAgent::~ParMoveAgent() {
+  for (size_t i = 0; i < _generators.size(); ++i)
+    delete _generators[i];
+  _generators.clear();
+}
+
+void ParMoveAgent::addGenerator(ParMoveGenerator* generator) {
+  _generators.push_back(generator);
+  _gains.push_back(0.0);
+  _proposed.push_back(0);
+  _accepted.push_back(0);
+}
+
+unsigned ParMoveAgent::select(RandomGenerator& random_gen) {
+  QASSERT(!_generators.empty());
+  if (_generators.size() == 1)
+    return 0;
+
+  if (random_gen.fRand(0.0f, 1.0f) < move_agent_epsilon)
+    return random_gen.uRand(0, (unsigned)_generators.size() - 1);
+
+  unsigned best = 0;
+  for (unsigned i = 1; i < _gains.size(); ++i) {
+    if (_gains[i] > _gains[best])
+      best = i;
+  }
+  return best;
+}
+
+void ParMoveAgent::update(unsigned type, bool accepted, double delta_cost) {
+  ++_proposed[type];
+  if (accepted)
+    ++_accepted[type];
+  double gain = accepted ? -delta_cost : 0.0;
+  _gains[type] += move_agent_step * (gain - _gains[type]);
+}
+
+void ParMoveAgent::printStat() const {
+  for (size_t i = 0; i < _generators.size(); ++i) {
+    qlog.speak("Place", "%8s moves: %9u evaluated, %5.1f%% accepted, average gain %g",
+        _generators[i]->getName(), _proposed[i],
+        _proposed[i] ? 100.0 * (double)_accepted[i] / (double)_proposed[i] : 0.0,
+        _gains[i]);
+  }
+}
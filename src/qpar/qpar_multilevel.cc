@@ -0,0 +1,542 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+/*!
+ * \file qpar_multilevel.cc
+ * \author Juexiao Su
+ * \date 19 Feb 2018
+ * \brief multilevel placement on clustered netlists
+ */
+
+#include "qpar/qpar_multilevel.hh"
+#include "qpar/qpar_netlist.hh"
+#include "qpar/qpar_target.hh"
+
+#include "utils/qlog.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+// stop coarsening when a level has at most this many clusters
+static const unsigned multilevel_coarse_num = 64;
+
+// stop coarsening when a level keeps more than this fraction of clusters
+static const double multilevel_min_shrink = 0.9;
+
+static const unsigned multilevel_max_level = 20;
+
+// larger nets are ignored when matching clusters
+static const size_t multilevel_max_net_size = 32;
+
+// used grids over grids covered by the clusters, unless the design is denser
+static const double multilevel_density = 0.1;
+
+// moves per cluster at each temperature
+static const unsigned multilevel_moves_per_cluster = 20;
+
+// projected levels are annealed from this temperature, in unit of cost per net
+static const float multilevel_refine_t = 0.3f;
+
+// projected levels are annealed with this move radius in bins
+static const float multilevel_refine_r_limit = 3.0f;
+
+static const int multilevel_max_iter = 100;
+
+
+ParMultilevelPlace::ParMultilevelPlace(ParNetlist* netlist, ParTarget* target, int seed) :
+  _netlist(netlist),
+  _target(target),
+  _x_limit(target->getXLimit()),
+  _y_limit(target->getYLimit()),
+  _density(multilevel_density),
+  _stamp(0),
+  _random_gen(seed) {
+}
+
+ParMultilevelPlace::~ParMultilevelPlace() {
+  for (size_t i = 0; i < _levels.size(); ++i)
+    delete _levels[i];
+  _levels.clear();
+}
+
+void ParMultilevelPlace::run() {
+  ELE_ITER ele_iter = _netlist->element_begin();
+  for (; ele_iter != _netlist->element_end(); ++ele_iter)
+    _elements.push_back(*ele_iter);
+
+  if (_elements.empty())
+    return;
+
+  _capacity.assign((size_t)((_x_limit + 1) * (_y_limit + 1)), 0);
+  for (COORD x = 0; x < _x_limit; ++x) {
+    for (COORD y = 0; y < _y_limit; ++y) {
+      ParGrid* grid = _target->getGrid(x, y);
+      unsigned used = (grid && grid->canBePlaced()) ? 1 : 0;
+      _capacity[(size_t)((x + 1) * (_y_limit + 1) + y + 1)] = used +
+        _capacity[(size_t)(x * (_y_limit + 1) + y + 1)] +
+        _capacity[(size_t)((x + 1) * (_y_limit + 1) + y)] -
+        _capacity[(size_t)(x * (_y_limit + 1) + y)];
+    }
+  }
+
+  unsigned placeable_num = getCapacity(0, _x_limit - 1, 0, _y_limit - 1);
+  if (placeable_num < _elements.size())
+    qlog.speakError("Placement Failed available grids %u < elements %lu",
+        placeable_num, _elements.size());
+  _density = std::max(multilevel_density, (double)_elements.size() / (double)placeable_num);
+
+  buildFinestLevel();
+  while (_levels.size() < multilevel_max_level && coarsen()) {}
+
+  for (size_t i = 0; i < _levels.size(); ++i)
+    qlog.speak("Place", "Level %lu has %u clusters and %lu nets, bin pitch %.2f",
+        i, _levels[i]->size(), _levels[i]->nets.size(), _levels[i]->pitch);
+
+  unsigned level_index = (unsigned)_levels.size() - 1;
+  placeRandomly(*_levels[level_index]);
+  anneal(*_levels[level_index], true);
+
+  while (level_index > 0) {
+    --level_index;
+    project(level_index);
+    // level 0 is refined by the placer with the real cost
+    if (level_index > 0)
+      anneal(*_levels[level_index], false);
+  }
+
+  commitPlacement();
+}
+
+void ParMultilevelPlace::buildFinestLevel() {
+  ParClusterLevel* level = new ParClusterLevel;
+  level->sizes.assign(_elements.size(), 1);
+
+  std::unordered_map<ParWire*, unsigned> wire_net;
+  for (unsigned i = 0; i < _elements.size(); ++i) {
+    ParElement* element = _elements[i];
+    WIRE_ITER_V w_iter = element->begin();
+    for (; w_iter != element->end(); ++w_iter) {
+      if (!wire_net.count(*w_iter)) {
+        wire_net[*w_iter] = (unsigned)level->nets.size();
+        level->nets.push_back(std::vector<unsigned>());
+      }
+      // an element can connect to the same wire twice
+      std::vector<unsigned>& pins = level->nets[wire_net[*w_iter]];
+      if (pins.empty() || pins.back() != i)
+        pins.push_back(i);
+    }
+  }
+
+  std::vector<std::vector<unsigned> > nets;
+  for (size_t i = 0; i < level->nets.size(); ++i)
+    if (level->nets[i].size() > 1)
+      nets.push_back(level->nets[i]);
+  level->nets.swap(nets);
+
+  level->cluster_nets.resize(_elements.size());
+  for (unsigned i = 0; i < level->nets.size(); ++i)
+    for (size_t j = 0; j < level->nets[i].size(); ++j)
+      level->cluster_nets[level->nets[i][j]].push_back(i);
+
+  initializeBins(*level, 1.0);
+  _levels.push_back(level);
+}
+
+bool ParMultilevelPlace::coarsen() {
+  ParClusterLevel& fine = *_levels.back();
+  unsigned num = fine.size();
+  // level 1 is always built, it sets the density of the projected placement
+  if (_levels.size() > 1 && num <= multilevel_coarse_num)
+    return false;
+
+  unsigned max_size = std::max(2u, 2 * (unsigned)_elements.size() / multilevel_coarse_num);
+
+  std::vector<unsigned> order(num);
+  for (unsigned i = 0; i < num; ++i)
+    order[i] = i;
+  for (unsigned i = num; i > 1; --i)
+    std::swap(order[i - 1], order[_random_gen.uRand(0, i - 1)]);
+
+  // heavy edge matching, the edge weight is normalized by the cluster sizes
+  std::vector<bool> matched(num, false);
+  std::vector<double> score(num, 0.0);
+  std::vector<unsigned> touched;
+  std::vector<unsigned> sizes;
+  fine.parents.assign(num, 0);
+
+  for (unsigned i = 0; i < num; ++i) {
+    unsigned u = order[i];
+    if (matched[u])
+      continue;
+
+    touched.clear();
+    for (size_t n = 0; n < fine.cluster_nets[u].size(); ++n) {
+      const std::vector<unsigned>& pins = fine.nets[fine.cluster_nets[u][n]];
+      if (pins.size() > multilevel_max_net_size)
+        continue;
+      double weight = 1.0 / (double)(pins.size() - 1);
+      for (size_t p = 0; p < pins.size(); ++p) {
+        unsigned v = pins[p];
+        if (v == u || matched[v] || fine.sizes[u] + fine.sizes[v] > max_size)
+          continue;
+        if (score[v] == 0.0)
+          touched.push_back(v);
+        score[v] += weight;
+      }
+    }
+
+    int best = -1;
+    double best_score = 0.0;
+    for (size_t t = 0; t < touched.size(); ++t) {
+      unsigned v = touched[t];
+      double s = score[v] / ((double)fine.sizes[u] * (double)fine.sizes[v]);
+      if (s > best_score) {
+        best_score = s;
+        best = (int)v;
+      }
+      score[v] = 0.0;
+    }
+
+    matched[u] = true;
+    fine.parents[u] = (unsigned)sizes.size();
+    unsigned size = fine.sizes[u];
+    if (best >= 0) {
+      matched[best] = true;
+      fine.parents[best] = (unsigned)sizes.size();
+      size += fine.sizes[best];
+    }
+    sizes.push_back(size);
+  }
+
+  if (_levels.size() > 1 && sizes.size() > multilevel_min_shrink * num)
+    return false;
+
+  ParClusterLevel* coarse = new ParClusterLevel;
+  coarse->sizes.swap(sizes);
+  coarse->cluster_nets.resize(coarse->size());
+
+  for (size_t i = 0; i < fine.nets.size(); ++i) {
+    std::vector<unsigned> pins;
+    for (size_t j = 0; j < fine.nets[i].size(); ++j)
+      pins.push_back(fine.parents[fine.nets[i][j]]);
+    std::sort(pins.begin(), pins.end());
+    pins.erase(std::unique(pins.begin(), pins.end()), pins.end());
+    if (pins.size() < 2)
+      continue;
+
+    for (size_t j = 0; j < pins.size(); ++j)
+      coarse->cluster_nets[pins[j]].push_back((unsigned)coarse->nets.size());
+    coarse->nets.push_back(pins);
+  }
+
+  // a cluster fills its bin at the target density
+  double ave_size = (double)_elements.size() / (double)coarse->size();
+  initializeBins(*coarse, std::sqrt(ave_size / _density));
+
+  _levels.push_back(coarse);
+  return true;
+}
+
+void ParMultilevelPlace::initializeBins(ParClusterLevel& level, double pitch) const {
+  // shrink the bins until the clusters fit
+  for (; ; pitch *= 0.95) {
+    level.pitch = std::max(pitch, 1.0);
+    level.bin_num_x = std::max((COORD)1, (COORD)((double)_x_limit / level.pitch));
+    level.bin_num_y = std::max((COORD)1, (COORD)((double)_y_limit / level.pitch));
+
+    unsigned usable_num = 0;
+    for (COORD bx = 0; bx < level.bin_num_x; ++bx)
+      for (COORD by = 0; by < level.bin_num_y; ++by)
+        if (isUsableBin(level, bx, by))
+          ++usable_num;
+
+    if (usable_num >= level.size() || level.pitch == 1.0)
+      break;
+  }
+
+  level.bins.assign((size_t)(level.bin_num_x * level.bin_num_y), -1);
+  level.x.assign(level.size(), 0);
+  level.y.assign(level.size(), 0);
+}
+
+bool ParMultilevelPlace::isUsableBin(const ParClusterLevel& level, COORD bx, COORD by) const {
+  COORD xl = (COORD)((double)bx * level.pitch);
+  COORD yt = (COORD)((double)by * level.pitch);
+  COORD xr = std::min(std::max(xl, (COORD)((double)(bx + 1) * level.pitch) - 1), _x_limit - 1);
+  COORD yb = std::min(std::max(yt, (COORD)((double)(by + 1) * level.pitch) - 1), _y_limit - 1);
+  return getCapacity(xl, xr, yt, yb) > 0;
+}
+
+void ParMultilevelPlace::findFreeBin(ParClusterLevel& level, COORD x, COORD y, COORD& bx, COORD& by) const {
+  x = std::max((COORD)0, std::min(x, level.bin_num_x - 1));
+  y = std::max((COORD)0, std::min(y, level.bin_num_y - 1));
+
+  COORD max_dist = std::max(level.bin_num_x, level.bin_num_y);
+  for (COORD dist = 0; dist <= max_dist; ++dist) {
+    // closest free bin on the ring of bins at this distance
+    COORD best_d = std::numeric_limits<COORD>::max();
+    for (COORD i = x - dist; i <= x + dist; ++i) {
+      for (COORD j = y - dist; j <= y + dist; ++j) {
+        if (std::max(std::abs(i - x), std::abs(j - y)) != dist)
+          continue;
+        if (i < 0 || j < 0 || i >= level.bin_num_x || j >= level.bin_num_y)
+          continue;
+        if (level.bin(i, j) >= 0 || !isUsableBin(level, i, j))
+          continue;
+
+        COORD d = (i - x) * (i - x) + (j - y) * (j - y);
+        if (d < best_d) {
+          best_d = d;
+          bx = i;
+          by = j;
+        }
+      }
+    }
+
+    if (best_d != std::numeric_limits<COORD>::max())
+      return;
+  }
+
+  qlog.speakError("Placement does not have enough resources to performance placement");
+}
+
+void ParMultilevelPlace::placeRandomly(ParClusterLevel& level) {
+  for (unsigned i = 0; i < level.size(); ++i) {
+    COORD bx = 0, by = 0;
+    findFreeBin(level,
+        (COORD)_random_gen.iRand(0, (int)level.bin_num_x - 1),
+        (COORD)_random_gen.iRand(0, (int)level.bin_num_y - 1), bx, by);
+    level.x[i] = bx;
+    level.y[i] = by;
+    level.bin(bx, by) = (int)i;
+  }
+}
+
+void ParMultilevelPlace::project(unsigned level_index) {
+  ParClusterLevel& fine = *_levels[level_index];
+  const ParClusterLevel& coarse = *_levels[level_index + 1];
+
+  std::vector<unsigned> child_num(coarse.size(), 0);
+  std::vector<unsigned> child_index(fine.size(), 0);
+  for (unsigned i = 0; i < fine.size(); ++i)
+    child_index[i] = child_num[fine.parents[i]]++;
+
+  for (unsigned i = 0; i < fine.size(); ++i) {
+    unsigned parent = fine.parents[i];
+
+    // children of a cluster are spread over its bin, adjacent elements congest their wires
+    unsigned side = (unsigned)std::ceil(std::sqrt((double)child_num[parent]));
+    double step = coarse.pitch / (double)side;
+    double cx = (double)coarse.x[parent] * coarse.pitch + step * (child_index[i] % side + 0.5);
+    double cy = (double)coarse.y[parent] * coarse.pitch + step * (child_index[i] / side + 0.5);
+
+    COORD bx = 0, by = 0;
+    findFreeBin(fine, (COORD)(cx / fine.pitch), (COORD)(cy / fine.pitch), bx, by);
+    fine.x[i] = bx;
+    fine.y[i] = by;
+    fine.bin(bx, by) = (int)i;
+  }
+}
+
+void ParMultilevelPlace::anneal(ParClusterLevel& level, bool from_random) {
+  if (level.nets.empty())
+    return;
+
+  _net_stamp.assign(level.nets.size(), 0);
+  _stamp = 0;
+
+  double total_cost = computeTotalCost(level);
+  float max_r = (float)std::max(level.bin_num_x, level.bin_num_y);
+  Annealer annealer(0.0f, 1.0f, max_r, _random_gen.iRand(0, std::numeric_limits<int>::max()));
+
+  const int num_move = (int)(multilevel_moves_per_cluster * level.size());
+  float init_t = 0.0f;
+  if (from_random) {
+    // same as the placer, twenty times the cost deviation when every move is accepted
+    annealer.setCurrentT(std::numeric_limits<float>::max());
+    double ave = 0.0;
+    double sum_of_square = 0.0;
+    int move_num = std::max((int)level.size(), 100);
+    for (int i = 0; i < move_num; ++i) {
+      tryMove(level, annealer, total_cost);
+      ave += total_cost;
+      sum_of_square += total_cost * total_cost;
+    }
+    ave /= move_num;
+    double variance = (sum_of_square - move_num * ave * ave) / (move_num - 1);
+    init_t = (float)(20 * std::sqrt(std::max(variance, 0.0)));
+  } else {
+    init_t = multilevel_refine_t * (float)(total_cost / level.nets.size());
+    annealer.setRLimit(multilevel_refine_r_limit);
+  }
+  annealer.setInitT(init_t);
+  annealer.setCurrentT(init_t);
+
+  int iter = 0;
+  for (; iter < multilevel_max_iter; ++iter) {
+    if (annealer.shouldExit((float)(total_cost / level.nets.size())))
+      break;
+
+    int success_num = 0;
+    for (int i = 0; i < num_move; ++i)
+      if (tryMove(level, annealer, total_cost))
+        ++success_num;
+
+    // keep the incremental cost from drifting
+    total_cost = 0.0;
+    for (size_t n = 0; n < level.net_costs.size(); ++n)
+      total_cost += level.net_costs[n];
+
+    float success_rat = (float)success_num / (float)num_move;
+    annealer.updateT(success_rat);
+    annealer.updateMoveRadius(success_rat);
+  }
+
+  qlog.speak("Place", "Level of %u clusters is annealed in %d iterations, wire length %.1f",
+      level.size(), iter, total_cost);
+}
+
+bool ParMultilevelPlace::tryMove(ParClusterLevel& level, Annealer& annealer, double& total_cost) {
+  unsigned cluster = _random_gen.uRand(0, level.size() - 1);
+  COORD from_x = level.x[cluster];
+  COORD from_y = level.y[cluster];
+
+  COORD r_limit = std::max((COORD)1, (COORD)annealer.getRLimit());
+  COORD xl = std::max((COORD)0, from_x - r_limit);
+  COORD xr = std::min(level.bin_num_x - 1, from_x + r_limit);
+  COORD yt = std::max((COORD)0, from_y - r_limit);
+  COORD yb = std::min(level.bin_num_y - 1, from_y + r_limit);
+  if (xl == xr && yt == yb)
+    return false;
+
+  COORD to_x, to_y;
+  do {
+    to_x = (COORD)_random_gen.iRand((int)xl, (int)xr);
+    to_y = (COORD)_random_gen.iRand((int)yt, (int)yb);
+  } while (to_x == from_x && to_y == from_y);
+
+  if (!isUsableBin(level, to_x, to_y))
+    return false;
+
+  // move to an empty bin or swap with the cluster in it
+  int other = level.bin(to_x, to_y);
+  level.x[cluster] = to_x;
+  level.y[cluster] = to_y;
+  level.bin(to_x, to_y) = (int)cluster;
+  level.bin(from_x, from_y) = other;
+  if (other >= 0) {
+    level.x[other] = from_x;
+    level.y[other] = from_y;
+  }
+
+  ++_stamp;
+  _moved_nets.clear();
+  _moved_costs.clear();
+  double delta_cost = 0.0;
+  for (int k = 0; k < 2; ++k) {
+    int moved = (k == 0) ? (int)cluster : other;
+    if (moved < 0)
+      continue;
+
+    const std::vector<unsigned>& nets = level.cluster_nets[moved];
+    for (size_t n = 0; n < nets.size(); ++n) {
+      unsigned net = nets[n];
+      if (_net_stamp[net] == _stamp)
+        continue;
+      _net_stamp[net] = _stamp;
+      _moved_nets.push_back(net);
+      _moved_costs.push_back(level.net_costs[net]);
+
+      double cost = computeNetCost(level, net);
+      delta_cost += cost - level.net_costs[net];
+      level.net_costs[net] = cost;
+    }
+  }
+
+  if (annealer.shouldAccept(delta_cost)) {
+    total_cost += delta_cost;
+    return true;
+  }
+
+  level.x[cluster] = from_x;
+  level.y[cluster] = from_y;
+  level.bin(from_x, from_y) = (int)cluster;
+  level.bin(to_x, to_y) = other;
+  if (other >= 0) {
+    level.x[other] = to_x;
+    level.y[other] = to_y;
+  }
+  for (size_t n = 0; n < _moved_nets.size(); ++n)
+    level.net_costs[_moved_nets[n]] = _moved_costs[n];
+
+  return false;
+}
+
+double ParMultilevelPlace::computeNetCost(const ParClusterLevel& level, unsigned net) const {
+  const std::vector<unsigned>& pins = level.nets[net];
+  COORD xl = level.x[pins[0]], xr = xl;
+  COORD yt = level.y[pins[0]], yb = yt;
+  for (size_t i = 1; i < pins.size(); ++i) {
+    xl = std::min(xl, level.x[pins[i]]);
+    xr = std::max(xr, level.x[pins[i]]);
+    yt = std::min(yt, level.y[pins[i]]);
+    yb = std::max(yb, level.y[pins[i]]);
+  }
+  return (double)((xr - xl) + (yb - yt)) * level.pitch;
+}
+
+double ParMultilevelPlace::computeTotalCost(ParClusterLevel& level) const {
+  double cost = 0.0;
+  level.net_costs.resize(level.nets.size());
+  for (unsigned i = 0; i < level.nets.size(); ++i) {
+    level.net_costs[i] = computeNetCost(level, i);
+    cost += level.net_costs[i];
+  }
+  return cost;
+}
+
+unsigned ParMultilevelPlace::getCapacity(COORD xl, COORD xr, COORD yt, COORD yb) const {
+  size_t stride = (size_t)(_y_limit + 1);
+  return _capacity[(size_t)(xr + 1) * stride + (size_t)(yb + 1)] -
+         _capacity[(size_t)xl * stride + (size_t)(yb + 1)] -
+         _capacity[(size_t)(xr + 1) * stride + (size_t)yt] +
+         _capacity[(size_t)xl * stride + (size_t)yt];
+}
+
+void ParMultilevelPlace::commitPlacement() {
+  const ParClusterLevel& level = *_levels[0];
+
+  for (size_t i = 0; i < _elements.size(); ++i) {
+    ParGrid* grid = _elements[i]->getCurrentGrid();
+    grid->setParElement(NULL);
+    grid->save();
+  }
+
+  for (size_t i = 0; i < _elements.size(); ++i) {
+    ParElement* element = _elements[i];
+    ParGrid* grid = _target->getGrid(level.x[i], level.y[i]);
+    QASSERT(grid && grid->canBePlaced() && grid->getCurrentElement() == NULL);
+    element->setGrid(grid);
+    element->save();
+    grid->setParElement(element);
+    grid->save();
+  }
+}
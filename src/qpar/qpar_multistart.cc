@@ -0,0 +1,130 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+/*!
+ * \file qpar_multistart.cc
+ * \author Juexiao Su
+ * \date 06 Mar 2018
+ * \brief independent placements from different seeds, the best one is kept
+ */
+
+#include "qpar/qpar_multistart.hh"
+#include "qpar/qpar_place.hh"
+#include "qpar/qpar_netlist.hh"
+#include "qpar/qpar_target.hh"
+#include "qpar/qpar_thread_pool.hh"
+
+#include "utils/qlog.hh"
+
+#include <algorithm>
+#include <functional>
+#include <chrono>
+
+
+ParMultiStart::ParMultiStart(SYN::Model* model, HW_Target_Dwave* hw_target,
+    ParNetlist* netlist, ParTarget* target, const PlaceOption& option) :
+  _model(model),
+  _hw_target(hw_target),
+  _option(option),
+  _thread_pool(NULL) {
+
+  QASSERT(_option.starts > 1);
+  _netlists.push_back(netlist);
+  _targets.push_back(target);
+  for (unsigned i = 1; i < _option.starts; ++i) {
+    ParTarget* start_target = new ParTarget(_hw_target);
+    start_target->initParTarget();
+    _targets.push_back(start_target);
+    _netlists.push_back(new ParNetlist(_model));
+  }
+
+  // each start anneals with a single thread, start 0 is the single start placement
+  for (unsigned i = 0; i < _option.starts; ++i) {
+    PlaceOption start_option = _option;
+    start_option.threads = 1;
+    start_option.starts = 1;
+    start_option.seed = _option.seed + (int)i;
+    start_option.shuffle_seed = _option.shuffle_seed + i;
+    _placers.push_back(new QPlace(_netlists[i], _targets[i], start_option));
+  }
+}
+
+ParMultiStart::~ParMultiStart() {
+  for (size_t i = 0; i < _placers.size(); ++i)
+    delete _placers[i];
+  _placers.clear();
+
+  for (size_t i = 1; i < _netlists.size(); ++i)
+    delete _netlists[i];
+  _netlists.clear();
+
+  for (size_t i = 1; i < _targets.size(); ++i)
+    delete _targets[i];
+  _targets.clear();
+
+  if (_thread_pool)
+    delete _thread_pool;
+  _thread_pool = NULL;
+}
+
+void ParMultiStart::run() {
+  std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+  unsigned start_num = _option.starts;
+
+  // initialization logs, keep it on this thread
+  for (unsigned i = 0; i < start_num; ++i)
+    _placers[i]->initialize();
+
+  _placers[0]->dumpCurrentPlacement("init.place");
+
+  unsigned thread_num = std::min(std::max(_option.threads, 1u), start_num);
+  _thread_pool = new ParThreadPool(thread_num);
+  qlog.speak("Place", "Multi-start placement with %u starts on %u threads", start_num, thread_num);
+
+  _thread_pool->run(std::bind(&ParMultiStart::optimizeStarts, this, std::placeholders::_1));
+
+  unsigned best = 0;
+  for (unsigned i = 0; i < start_num; ++i) {
+    qlog.speak("Place", "Start %u with seed %d has cost %.6f",
+        i, _option.seed + (int)i, _placers[i]->getTotalCost());
+    if (_placers[i]->getTotalCost() < _placers[best]->getTotalCost())
+      best = i;
+  }
+  qlog.speak("Place", "Start %u has the best cost %.6f", best, _placers[best]->getTotalCost());
+
+  if (best != 0)
+    _placers[0]->copyPlacement(*_placers[best]);
+  _placers[0]->finish();
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+  qlog.speak("Place", "Placement finished in %.2f seconds", elapsed.count());
+}
+
+void ParMultiStart::optimizeStarts(unsigned thread_id) {
+  // the log buffer is shared, starts on different threads would overwrite each other
+  qlog.setThreadQuiet(true);
+  unsigned thread_num = _thread_pool->getThreadNum();
+  for (unsigned i = thread_id; i < _placers.size(); i += thread_num)
+    _placers[i]->optimize();
+  qlog.setThreadQuiet(false);
+}
+
+void ParMultiStart::dumpCurrentPlacement(std::string filename) const {
+  _placers[0]->dumpCurrentPlacement(filename);
+}
@@ -94,6 +94,17 @@ ParNetlist::~ParNetlist() {
   _wires.clear();
 }
 
+void ParNetlist::clearRoutes() {
+  for (size_t i = 0; i < _all_targets.size(); ++i) {
+    ParWireTarget* target = _all_targets[i];
+    RoutePath* route = target->getRoutePath();
+    if (!route)
+      continue;
+    target->ripupTarget();
+    delete route;
+    target->setRoutePath(NULL);
+  }
+}
 
 void ParNetlist::buildParNetlist() {
   QASSERT(_syn_netlist);
@@ -101,6 +112,7 @@ void ParNetlist::buildParNetlist() {
   std::vector<SYN::Gate*> gates;
   std::unordered_map<SYN::Gate*, ParElement*> gate_to_par_element;
   std::unordered_map<SYN::Net*, ParWire*> net_to_par_wire;
+  std::vector<ParWire*> par_wires; // wires in creation order
   gates = _syn_netlist->getModelGates();
 
   for (size_t i = 0; i < gates.size(); ++i) {
@@ -136,15 +148,17 @@ void ParNetlist::buildParNetlist() {
         parwire = new ParWire(net);
 
         net_to_par_wire.insert(std::make_pair(net, parwire));
+        par_wires.push_back(parwire);
       }
       element->addWire(parwire);
     }
   }
 
 
-  std::unordered_map<SYN::Net*, ParWire*>::iterator w_iter = net_to_par_wire.begin();
-  for (; w_iter != net_to_par_wire.end(); ++w_iter) {
-    ParWire* wire = w_iter->second;
+  // model pin elements are created while building targets, do not iterate the hash map
+  std::vector<ParWire*>::iterator w_iter = par_wires.begin();
+  for (; w_iter != par_wires.end(); ++w_iter) {
+    ParWire* wire = *w_iter;
     std::vector<ParWireTarget*> targets = wire->buildWireTarget(gate_to_par_element, _elements);
     _all_targets.insert(_all_targets.end(), targets.begin(), targets.end());
     if (wire->getElementNumber() <= 1) {
@@ -182,7 +196,8 @@ ParElement::ParElement(SYN::Gate* gate) :
 _gate(gate),
 _pin(NULL),
 _sink(NULL),
-_movable(true)
+_movable(true),
+_grid(NULL)
 {
   //qlog.speak("debug", "new gate %u", _element_index_counter);
   _element_index = _element_index_counter;
@@ -193,7 +208,8 @@ ParElement::ParElement(SYN::Pin* pin) :
 _gate(NULL),
 _pin(pin),
 _sink(NULL),
-_movable(true)
+_movable(true),
+_grid(NULL)
 {
   //qlog.speak("debug", "new pin %u", _element_index_counter);
   _element_index = _element_index_counter;
@@ -343,6 +359,10 @@ std::vector<ParWireTarget*>& ParWire::buildWireTarget(
 }
 
 void ParWire::recomputeBoundingBox() {
+  _bounding_box.getStatus() = computeBoundingBox();
+}
+
+BoundingBox ParWire::computeBoundingBox() const {
 
   int xl = std::numeric_limits<int>::max();
   int xr = -1;
@@ -354,7 +374,7 @@ void ParWire::recomputeBoundingBox() {
   int yte = 0;
   int ybe = 0;
 
-  ELE_ITER ele_iter = _elements.begin();
+  ParElementSet::const_iterator ele_iter = _elements.begin();
   for (; ele_iter != _elements.end(); ++ele_iter) {
     ParElement* ele = *ele_iter;
     COORD coordX = ele->getX();
@@ -392,8 +412,7 @@ void ParWire::recomputeBoundingBox() {
 
   Box box1(xl, xr, yt, yb);
   Box box2(xle,xre,yte,ybe);
-  _bounding_box.getStatus().setBoundingBox(box1);
-  _bounding_box.getStatus().setEdgeBox(box2);
+  return BoundingBox(box1, box2);
 
 }
 
@@ -497,75 +516,16 @@ BoundingBox ParWire::getCurrentBoundingBox() const {
   return _bounding_box.getStatus();
 }
 
-void ParWire::saveBoundingBox() {
-  _bounding_box.saveStatus();
+BoundingBox ParWire::getSavedBoundingBox() {
+  return _bounding_box.getSavedStatus();
 }
 
-void ParWire::updateBoundingBox(COORD from_x, COORD from_y, COORD to_x, COORD to_y) {
-  Box& bbox = _bounding_box.getStatus().getBoundBox();
-  Box& ebox = _bounding_box.getStatus().getEdgeBox();
-  bool recal = false ;
-
-  if (to_x < bbox.xl()) {
-    bbox.set_xl((int)to_x) ;
-    ebox.set_xl(1) ;
-  } else if (to_x == bbox.xl()) {
-    ebox.incr_xl() ;
-    if (from_x == bbox.xl())
-      ebox.decr_xl() ;
-  } else if (from_x == bbox.xl()) {
-    if (ebox.xl() > 1)
-      ebox.decr_xl() ;
-    else
-      recal = recal || true ;
-  }
-
-  if (to_x > bbox.xr()) {
-    bbox.set_xr((int)to_x) ;
-    ebox.set_xr(1) ;
-  } else if (to_x == bbox.xr()) {
-    ebox.incr_xr() ;
-    if (from_x == bbox.xr())
-      ebox.decr_xr() ;
-  } else if (from_x == bbox.xr()) {
-    if (ebox.xr() > 1)
-      ebox.decr_xr() ;
-    else
-      recal = recal || true ;
-  }
-
-  if (to_y < bbox.yt()) {
-    bbox.set_yt((int)to_y) ;
-    ebox.set_yt(1) ;
-  } else if (to_y == bbox.yt()) {
-    ebox.incr_yt() ;
-    if (from_y == bbox.yt())
-      ebox.decr_yt() ;
-  } else if (from_y == bbox.yt()) {
-    if (ebox.yt() > 1)
-      ebox.decr_yt() ;
-    else
-      recal = recal || true ;
-  }
-
-
-  if (to_y > bbox.yb()) {
-    bbox.set_yb((int)to_y) ;
-    ebox.set_yb(1) ;
-  } else if (to_y == bbox.yb()) {
-    ebox.incr_yb() ;
-    if (from_y == bbox.yb())
-      ebox.decr_yb() ;
-  } else if (from_y == bbox.yb()) {
-    if (ebox.yb() > 1)
-      ebox.decr_yb() ;
-    else
-      recal = recal || true ;
-  }
-
-  if (recal)
-    recomputeBoundingBox();
+void ParWire::setBoundingBox(BoundingBox box) {
+  _bounding_box.setStatus(box);
+}
 
+void ParWire::saveBoundingBox() {
+  _bounding_box.saveStatus();
 }
 
 ParElement* ParWire::getUniqElement() {
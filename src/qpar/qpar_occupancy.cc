@@ -0,0 +1,192 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+/*!
+ * \file qpar_occupancy.cc
+ * \author Juexiao Su
+ * \date 05 Feb 2018
+ * \brief data structures to count the used grids in a rectangle during placement
+ */
+
+#include "qpar/qpar_occupancy.hh"
+#include "qpar/qpar_target.hh"
+
+#include "utils/qlog.hh"
+
+
+ParOccupancy* ParOccupancy::create(OCCUPANCY_TYPE type, unsigned x, unsigned y) {
+  switch (type) {
+    case OCCUPANCY_PREFIX:
+      return new PrefixOccupancy(x, y);
+    case OCCUPANCY_FENWICK:
+      return new FenwickOccupancy(x, y);
+    default:
+      QASSERT(0);
+  }
+}
+
+bool ParOccupancy::getType(const std::string& name, OCCUPANCY_TYPE& type) {
+  if (name == "prefix") {
+    type = OCCUPANCY_PREFIX;
+    return true;
+  } else if (name == "fenwick") {
+    type = OCCUPANCY_FENWICK;
+    return true;
+  }
+  return false;
+}
+
+const char* ParOccupancy::getTypeName(OCCUPANCY_TYPE type) {
+  switch (type) {
+    case OCCUPANCY_PREFIX:
+      return "prefix";
+    case OCCUPANCY_FENWICK:
+      return "fenwick";
+    default:
+      QASSERT(0);
+  }
+}
+
+
+void PrefixOccupancy::build(const ParTarget& target) {
+  COORD y_limit = (COORD)_maxY;
+  COORD x_limit = (COORD)_maxX;
+
+  if (target.getGrid(0,0)->getCurrentElement())
+    _used_matrix.cell(0,0) = 1;
+  else
+    _used_matrix.cell(0,0) = 0;
+
+  for (COORD y = 1; y < y_limit; ++y) {
+    if (target.getGrid(0,y)->getCurrentElement())
+      _used_matrix.cell(0,(unsigned)y) = _used_matrix.cell(0,(unsigned)(y-1)) + 1;
+    else
+      _used_matrix.cell(0,(unsigned)y) = _used_matrix.cell(0,(unsigned)(y-1));
+  }
+
+  for (COORD x = 1; x < x_limit; ++x) {
+    if (target.getGrid(x, 0)->getCurrentElement())
+      _used_matrix.cell((unsigned)x, 0) = _used_matrix.cell((unsigned)(x-1),0) + 1;
+    else
+      _used_matrix.cell((unsigned)x, 0) = _used_matrix.cell((unsigned)(x-1),0);
+  }
+
+  for (unsigned x = 1; x < (unsigned)x_limit; ++x) {
+    for (unsigned y = 1; y < (unsigned)y_limit; ++y) {
+      unsigned used_element =
+        _used_matrix.cell(x-1, y) +
+        _used_matrix.cell(x, y-1) -
+        _used_matrix.cell(x-1, y-1);
+      if (target.getGrid(x,y)->getCurrentElement())
+        _used_matrix.cell(x,y) = used_element + 1;
+      else
+        _used_matrix.cell(x,y) = used_element;
+    }
+  }
+}
+
+void PrefixOccupancy::moveElement(COORD from_x, COORD from_y, COORD to_x, COORD to_y) {
+  QASSERT(from_x != to_x || from_y != to_y);
+  bool x_inc = to_x >= from_x;
+  bool y_inc = to_y >= from_y;
+
+  if (x_inc == y_inc) {
+    for (COORD i = (x_inc)?from_x:to_x; i < _maxX; ++i) {
+      for (COORD j = (x_inc)?from_y:to_y; j <= (((x_inc)?to_y:from_y) - 1); ++j) {
+        if (x_inc)
+          --_used_matrix.cell((unsigned)i, (unsigned)j);
+        else
+          ++_used_matrix.cell((unsigned)i, (unsigned)j);
+      }
+    }
+
+    for (COORD i = (x_inc)?from_x:to_x; i <= (((x_inc)?to_x:from_x) - 1); ++i) {
+      for (COORD j = (x_inc)?to_y:from_y; j < _maxY; ++j) {
+        if (x_inc)
+          --_used_matrix.cell((unsigned)i, (unsigned)j);
+        else
+          ++_used_matrix.cell((unsigned)i, (unsigned)j);
+      }
+    }
+
+  } else {
+    for (COORD i = (x_inc)?from_x:to_x; i <= (((x_inc)?to_x:from_x) - 1); ++i) {
+      for (COORD j = (x_inc)?from_y:to_y; j < _maxY; ++j) {
+        if (x_inc)
+          --_used_matrix.cell((unsigned)i, (unsigned)j);
+        else
+          ++_used_matrix.cell((unsigned)i, (unsigned)j);
+      }
+    }
+
+    for (COORD i = (x_inc)?to_x:from_x; i < _maxX; ++i) {
+      for (COORD j = (x_inc)?to_y:from_y; j <= (((x_inc)?from_y:to_y) - 1); ++j) {
+        if (x_inc)
+          ++_used_matrix.cell((unsigned)i, (unsigned)j);
+        else
+          --_used_matrix.cell((unsigned)i, (unsigned)j);
+      }
+    }
+  }
+}
+
+unsigned PrefixOccupancy::getUsedCell(unsigned xl, unsigned yt, unsigned xr, unsigned yb) const {
+  return _used_matrix.cell(xr, yb) +
+         ((xl == 0 || yt == 0) ? 0 : _used_matrix.cell(xl - 1, yt - 1)) -
+         ((xl == 0) ? 0 : _used_matrix.cell(xl - 1, yb)) -
+         ((yt == 0) ? 0 : _used_matrix.cell(xr, yt - 1));
+}
+
+
+void FenwickOccupancy::add(unsigned x, unsigned y, int val) {
+  for (unsigned i = x + 1; i <= _maxX; i += (i & (~i + 1)))
+    for (unsigned j = y + 1; j <= _maxY; j += (j & (~j + 1)))
+      _tree.cell(i, j) += val;
+}
+
+int FenwickOccupancy::prefix(unsigned x, unsigned y) const {
+  int sum = 0;
+  for (unsigned i = x; i > 0; i -= (i & (~i + 1)))
+    for (unsigned j = y; j > 0; j -= (j & (~j + 1)))
+      sum += _tree.cell(i, j);
+  return sum;
+}
+
+void FenwickOccupancy::build(const ParTarget& target) {
+  for (unsigned x = 0; x <= _maxX; ++x)
+    for (unsigned y = 0; y <= _maxY; ++y)
+      _tree.cell(x, y) = 0;
+
+  for (unsigned x = 0; x < _maxX; ++x)
+    for (unsigned y = 0; y < _maxY; ++y)
+      if (target.getGrid((COORD)x, (COORD)y)->getCurrentElement())
+        add(x, y, 1);
+}
+
+void FenwickOccupancy::moveElement(COORD from_x, COORD from_y, COORD to_x, COORD to_y) {
+  QASSERT(from_x != to_x || from_y != to_y);
+  add((unsigned)from_x, (unsigned)from_y, -1);
+  add((unsigned)to_x, (unsigned)to_y, 1);
+}
+
+unsigned FenwickOccupancy::getUsedCell(unsigned xl, unsigned yt, unsigned xr, unsigned yb) const {
+  int used = prefix(xr + 1, yb + 1) - prefix(xl, yb + 1) - prefix(xr + 1, yt) + prefix(xl, yt);
+  QASSERT(used >= 0);
+  return (unsigned)used;
+}
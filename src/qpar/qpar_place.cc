@@ -29,6 +29,15 @@
 #include "qpar/qpar_target.hh"
 #include "qpar/qpar_netlist.hh" 
 #include "qpar/qpar_place_cost.hh"
+#include "qpar/qpar_place_db.hh"
+#include "qpar/qpar_place_timing.hh"
+#include "qpar/qpar_wire_index.hh"
+#include "qpar/qpar_thread_pool.hh"
+#include "qpar/qpar_global_place.hh"
+#include "qpar/qpar_multilevel.hh"
+#include "qpar/qpar_move.hh"
+#include "qpar/qpar_schedule.hh"
+#include "qpar/qpar_route_congestion.hh"
 
 
 #include "utils/qlog.hh"
@@ -37,6 +46,8 @@
 #include <algorithm>
 #include <iomanip>
 #include <cmath>
+#include <chrono>
+#include <functional>
 
 #if 0
 #define DBG_CODE(code) code
@@ -44,42 +55,131 @@
 #define DBG_CODE(code)
 #endif
 
+// number of moves each thread evaluates in one batch
+static const unsigned place_moves_per_thread = 32;
+
+// annealing after global placement starts at this temperature, in unit of cost per wire
+static const float place_refine_t = 0.3f;
+
+// annealing after global placement starts with this move radius
+static const float place_refine_r_limit = 8.0f;
+
+// moves per element at each temperature when refining a multilevel placement
+static const float place_refine_moves_per_element = 20.0f;
+
 
 QPlace::~QPlace() {
-    if (_used_matrix)
-      delete _used_matrix;
-    _used_matrix = NULL;
+    if (_occupancy)
+      delete _occupancy;
+    _occupancy = NULL;
 
     if (_annealer)
       delete _annealer;
     _annealer = NULL;
 
+    if (_move_agent)
+      delete _move_agent;
+    _move_agent = NULL;
+
     if (_placement_cost)
       delete _placement_cost;
     _placement_cost = NULL;
+
+    if (_timing)
+      delete _timing;
+    _timing = NULL;
+
+    if (_wire_index)
+      delete _wire_index;
+    _wire_index = NULL;
+
+    if (_place_db)
+      delete _place_db;
+    _place_db = NULL;
+
+    if (_thread_pool)
+      delete _thread_pool;
+    _thread_pool = NULL;
 }
 
-void QPlace::run() {
+void QPlace::initialize() {
   initializePlacement();
 
-  _placement_cost = new CongestionAwareCost;
+  _placement_cost = new CongestionAwareCost(_option.scalar_cost);
 
-  _current_total_cost = computeTotalCost(true);
-  WIRE_ITER w_iter = _netlist->wire_begin(); 
-  for (; w_iter != _netlist->wire_end(); ++w_iter) {
-    (*w_iter)->saveCost();
+  if (_option.timing > 0.0) {
+    _timing = new ParPlaceTiming(_place_db, _netlist->getSynNetlist(), _option.timing);
+    _timing->update();
+    qlog.speak("Place", "Timing driven placement, %u logic levels, estimated critical chain is %.0f",
+        _timing->getMaxDepth(), _timing->getCriticalPath());
   }
 
+  _current_total_cost = computeTotalCost(true);
+
   qlog.speak("Place", "Initial placement cost is %.6f", _current_total_cost);
+}
 
-  //const int num_move = std::max((int)_movable_elements.size(), 100);
-  const int move_limit = (int)((float)4*std::pow((float)_movable_elements.size(), (float)1.333));
-  _annealer->setRLimit((float)(std::max(_hw_target->getXLimit(), _hw_target->getYLimit())));
+int QPlace::getMoveLimit() const {
+  // the multilevel placement is only refined, keep the runtime linear in the design size
+  if (_option.init == PlaceOption::INIT_MULTILEVEL)
+    return (int)(place_refine_moves_per_element * (float)_movable_elements.size());
+  return (int)((float)4*std::pow((float)_movable_elements.size(), (float)1.333));
+}
+
+void QPlace::run() {
+  std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+  initialize();
+
+  qlog.speak("QPlace", "Dump initial placement result");
+  dumpCurrentPlacement("init.place"); 
+  dumpUsedMatrix("init.matrix");
+
+  optimize();
 
-  //const float final_limit = 1.0;
-  const float init_t = getStartingT();
+  //sanityCheck();
+  finish();
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+  qlog.speak("Place", "Placement finished in %.2f seconds", elapsed.count());
+}
+
+void QPlace::optimize() {
+  if (_movable_elements.empty()) {
+    qlog.speak("Place", "All elements are fixed, nothing to place");
+    return;
+  }
+
+  //const int num_move = std::max((int)_movable_elements.size(), 100);
+  const bool warm_start = isWarmStart();
+  float init_t = 0.0f;
+  if (warm_start) {
+    // the current placement only needs local refinement at the given temperature
+    _annealer->setRLimit(place_refine_r_limit);
+    if (_option.refine_t > 0.0f)
+      init_t = _option.refine_t * (float)_current_total_cost / (float)_netlist->getWireNum();
+    else
+      init_t = _option.warm_t;
+    qlog.speak("Place", "Warm start from T %g", init_t);
+  } else if (_option.init != PlaceOption::INIT_RANDOM) {
+    // the global placement only needs local refinement
+    _annealer->setRLimit(place_refine_r_limit);
+    init_t = place_refine_t * (float)_current_total_cost / (float)_netlist->getWireNum();
+    qlog.speak("Place", "Refine global placement from T %g", init_t);
+  } else {
+    _annealer->setRLimit((float)(std::max(_hw_target->getXLimit(), _hw_target->getYLimit())));
+    init_t = getStartingT();
+  }
   _annealer->setInitT(init_t);
   _annealer->setCurrentT(init_t);
+  if (warm_start && _annealer->shouldExit((float)_current_total_cost / (float)_netlist->getWireNum()))
+    qlog.speak("Place", "Warm start T is below the exit temperature, placement is kept");
+
+  if (_option.threads > 1) {
+    _thread_pool = new ParThreadPool(_option.threads);
+    _batch_moves.resize(_option.threads * place_moves_per_thread);
+    qlog.speak("Place", "Use %u threads, %u moves per batch",
+        _option.threads, (unsigned)_batch_moves.size());
+  }
   
   int tot_iter = 0;
   int outer_iter = 0;
@@ -89,7 +189,9 @@ void QPlace::run() {
   double sum_of_square = 0;
   int success_num = 0;
 
-  qlog.speak("Place", "Start Placement");
+  ParSchedule* schedule = _annealer->getSchedule();
+  schedule->start(getMoveLimit());
+  qlog.speak("Place", "Start Placement with %s annealing schedule", ParSchedule::getTypeName(_option.schedule));
   std::stringstream print_sep;
   print_sep << "+";
   print_sep << std::setfill('-') << std::setw(10) << "+";
@@ -116,12 +218,21 @@ void QPlace::run() {
     sum_of_square = 0.0;
     success_num = 0;
     ++outer_iter;
+    const int move_limit = schedule->getMoveLimit();
 
-    for (int inner_iter = 0; inner_iter < move_limit; ++inner_iter) {
-      if (tryMove()) {
-        ++success_num;
-        cost_ave += _current_total_cost;
-        sum_of_square = _current_total_cost * _current_total_cost;
+    if (_thread_pool) {
+      int batch_size = (int)_batch_moves.size();
+      for (int inner_iter = 0; inner_iter < move_limit; inner_iter += batch_size) {
+        unsigned num_move = (unsigned)std::min(batch_size, move_limit - inner_iter);
+        success_num += (int)tryMoveBatch(num_move, cost_ave, sum_of_square);
+      }
+    } else {
+      for (int inner_iter = 0; inner_iter < move_limit; ++inner_iter) {
+        if (tryMove()) {
+          ++success_num;
+          cost_ave += _current_total_cost;
+          sum_of_square += _current_total_cost * _current_total_cost;
+        }
       }
     }
 
@@ -141,14 +252,18 @@ void QPlace::run() {
     else 
       cost_ave = _current_total_cost;
 
-    if (0) {
-      qlog.speak("Place", "sum of square is %f", sum_of_square);
-    }
-    //double std_dev = getStdDev(success_num, cost_ave, sum_of_square);
-    //float old_t = _annealer->getCurrentT();
-    _annealer->updateT(success_rat);
+    AnnealStat stat;
+    stat.move_num = move_limit;
+    stat.success_rate = success_rat;
+    stat.cost_std = getStdDev((unsigned)success_num, cost_ave, sum_of_square);
+    stat.unit_cost = _current_total_cost / (double)_netlist->getWireNum();
+    _annealer->updateT(stat);
     _annealer->updateMoveRadius(success_rat);
 
+    // criticalities follow the placement once per temperature
+    if (_timing)
+      updateTiming();
+
     std::stringstream place_stat;
     place_stat << "|";
     place_stat << std::setw(9) << outer_iter << "|";
@@ -163,14 +278,25 @@ void QPlace::run() {
     place_stat << std::setw(9) << tot_iter;
     place_stat << "|";
     qlog.speak("Place", "%s", place_stat.str().c_str());
-
-    if (outer_iter > 105)
-      break;
-
   }
   qlog.speak("Place", "%s", print_sep.str().c_str());
 
-  //sanityCheck();
+  if (_timing) {
+    _timing->update();
+    qlog.speak("Place", "Estimated critical chain is %.0f", _timing->getCriticalPath());
+  }
+
+  if (_move_agent->getGeneratorNum() > 1)
+    _move_agent->printStat();
+
+  if (_thread_pool)
+    qlog.speak("Place", "%u speculative moves were re-evaluated, %u were refreshed after a conflict",
+        _stale_move_num, _refresh_move_num);
+}
+
+void QPlace::finish() {
+  _place_db->storePlacement();
+
   ELE_ITER ele_iter = _netlist->element_begin();
   for (; ele_iter != _netlist->element_end(); ++ele_iter) {
     ParElement* element = *ele_iter;
@@ -178,45 +304,107 @@ void QPlace::run() {
   }
 }
 
+unsigned QPlace::anneal(float temperature, int num_move) {
+  _annealer->setCurrentT(temperature);
+
+  unsigned success_num = 0;
+  for (int i = 0; i < num_move; ++i)
+    if (tryMove())
+      ++success_num;
+
+  _annealer->updateMoveRadius((float)success_num / (float)num_move);
+
+  // keep the incremental cost from drifting
+  if (_timing)
+    updateTiming();
+  else
+    _current_total_cost = computeTotalCost(true);
+
+  return success_num;
+}
+
+void QPlace::copyPlacement(const QPlace& placer) {
+  QASSERT(_netlist->getElementNumber() == placer._netlist->getElementNumber());
+
+  // both netlists are built from the same model, so elements and wires have the same indices
+  for (unsigned i = 0; i < _place_db->getElementNum(); ++i)
+    QASSERT(_place_db->getElement(i)->getName() == placer._place_db->getElement(i)->getName());
+  _place_db->copyPlacement(*placer._place_db);
+
+  for (unsigned i = 0; i < _place_db->getWireNum(); ++i)
+    _wire_index->updateWire(i);
+
+  // the occupancy is built from the grids
+  _place_db->storePlacement();
+  _occupancy->build(*_hw_target);
+
+  if (_timing)
+    updateTiming();
+  else
+    _current_total_cost = computeTotalCost(true);
+}
+
 void QPlace::sanityCheck() {
-  WIRE_ITER w_iter = _netlist->wire_begin();
-  for(; w_iter != _netlist->wire_end(); ++w_iter) {
-    ParWire* wire = *w_iter;
-    QASSERT(wire->sanityCheck());
-  }
+  QASSERT(_place_db->sanityCheck());
+  QASSERT(_wire_index->sanityCheck());
 
-  ELE_ITER ele_iter = _netlist->element_begin();
-  for (; ele_iter != _netlist->element_end(); ++ele_iter) {
-    ParGrid* grid = (*ele_iter)->getCurrentGrid();
-    QASSERT(grid->getCurrentElement() == (*ele_iter));
-  }
-  
   usedMatrixSanityCheck();
   //qlog.speak("Placement", "total cost %f", computeTotalCost(true));
 }
 
 double QPlace::computeTotalCost(bool set_wire_cost) {
+  _cost_batch.clear();
+  for (unsigned wire = 0; wire < _place_db->getWireNum(); ++wire)
+    addCostWire(wire);
+  _placement_cost->computeCost(_cost_batch);
+
   double cost = 0.0;
-  WIRE_ITER w_iter = _netlist->wire_begin();
-  for(; w_iter != _netlist->wire_end(); ++w_iter) {
-    ParWire* wire = *w_iter;
-    double cost_t = _placement_cost->computeCost(wire, *_used_matrix);
+  for (unsigned wire = 0; wire < _place_db->getWireNum(); ++wire) {
+    double cost_t = _cost_batch.getCost(wire) * getWireWeight(wire, _place_db->getBox(wire));
     cost += cost_t;
     if (set_wire_cost)
-      wire->setCost(cost_t);
+      _place_db->setCost(wire, cost_t);
   }
   return cost;
 }
 
+void QPlace::addCostWire(unsigned wire) {
+  const Box& bbox = _place_db->getBox(wire);
+  unsigned used_cell = _occupancy->getUsedCell(bbox.xl(), bbox.yt(), bbox.xr(), bbox.yb());
+  _cost_batch.addWire(_place_db->getPinNum(wire), bbox, used_cell);
+}
+
+double QPlace::getWireWeight(unsigned wire, const Box& bbox) const {
+  double weight = _timing ? _timing->getWeight(wire) : 1.0;
+  if (_route_congestion)
+    weight *= _route_congestion->getWeight(bbox);
+  return weight;
+}
+
+void QPlace::updateTiming() {
+  _timing->update();
+  _current_total_cost = computeTotalCost(true);
+}
+
 
 void QPlace::initializePlacement() {
 
   // initialize annealer
   float max_r = (float)std::max(_hw_target->getXLimit(), _hw_target->getYLimit());
-  _annealer = new Annealer(100.0, 1.0, max_r);
+  _annealer = new Annealer(100.0, 1.0, max_r, _option.seed);
+  _annealer->setSchedule(ParSchedule::create(_option.schedule, _option.budget));
+
+  // uniform moves are the first move type, directed moves fall back to them
+  _move_agent = new ParMoveAgent();
+  _move_agent->addGenerator(new ParUniformMove());
+  if (_option.moves == PlaceOption::MOVES_ADAPTIVE) {
+    _move_agent->addGenerator(new ParMedianMove());
+    _move_agent->addGenerator(new ParCentroidMove());
+    _move_agent->addGenerator(new ParCriticalMove());
+  }
 
   ParGridContainer& grids = _hw_target->getGrids();
-  grids.shuffle();
+  grids.shuffle(_option.shuffle_seed);
   unsigned grid_index = 0;
 
   if (grids.size() < _netlist->getElementNumber())
@@ -224,15 +412,39 @@ void QPlace::initializePlacement() {
         grids.size(),
         _netlist->getElementNumber());
 
+  // fixed elements are already on their grids, see ParEco
+  // a warm start keeps the current placement, otherwise movable elements leave their grids
+  const bool warm_start = isWarmStart();
+  unsigned fixed_num = 0;
   ELE_ITER ele_iter = _netlist->element_begin();
   for (; ele_iter != _netlist->element_end(); ++ele_iter) {
     ParElement* element = *ele_iter;
+    ParGrid* grid = element->getCurrentGrid();
+    bool is_placed = grid && grid->getCurrentElement() == element;
     if (!element->isMovable()) {
-      qlog.speakError("Placement does not support fixed element!");
+      if (!is_placed)
+        qlog.speakError("Fixed element %s is not placed", element->getName().c_str());
+      ++fixed_num;
+    } else if (warm_start) {
+      if (!is_placed)
+        qlog.speakError("Warm start element %s is not placed", element->getName().c_str());
+    } else if (is_placed) {
+      grid->setParElement(NULL);
+      grid->save();
     }
-    _movable_elements.push_back(element);
+  }
 
-    while (!grids[grid_index]->canBePlaced() && grid_index < grids.size())
+  unsigned movable_num = 0;
+  for (ele_iter = _netlist->element_begin(); ele_iter != _netlist->element_end(); ++ele_iter) {
+    ParElement* element = *ele_iter;
+    if (!element->isMovable())
+      continue;
+    ++movable_num;
+    if (warm_start)
+      continue;
+
+    while (grid_index < grids.size() &&
+        (!grids[grid_index]->canBePlaced() || grids[grid_index]->getCurrentElement()))
       ++grid_index;
 
     if (grid_index == grids.size()) 
@@ -245,61 +457,57 @@ void QPlace::initializePlacement() {
     ++grid_index;
   }
 
+  if (fixed_num)
+    qlog.speak("Place", "%u elements are fixed, %u elements are placed",
+        fixed_num, movable_num);
 
-  // initilize bounding box for each wire
-  WIRE_ITER w_iter = _netlist->wire_begin();
-  for(; w_iter != _netlist->wire_end(); ++w_iter) {
-    ParWire* wire = *w_iter;
-    wire->initializeBoundingBox();
+  if ((fixed_num || warm_start) && _option.init != PlaceOption::INIT_RANDOM) {
+    qlog.speak("Place", "Global placement is skipped with fixed elements or a warm start");
+    _option.init = PlaceOption::INIT_RANDOM;
   }
 
-  COORD y_limit = _hw_target->getYLimit();
-  COORD x_limit = _hw_target->getXLimit();
+  if (_option.init == PlaceOption::INIT_QUADRATIC) {
+    ParGlobalPlace global_place(_netlist, _hw_target);
+    global_place.run();
+  } else if (_option.init == PlaceOption::INIT_MULTILEVEL) {
+    ParMultilevelPlace multilevel_place(_netlist, _hw_target, _option.seed);
+    multilevel_place.run();
+  }
 
-  QASSERT(y_limit);QASSERT(x_limit);
-  _used_matrix = new qpr_matrix<unsigned>((unsigned)x_limit, (unsigned)y_limit);
 
-  // initilize grid utilization matrix
-  if (_hw_target->getGrid(0,0)->getCurrentElement())
-    _used_matrix->cell(0,0) = 1;
-  else
-    _used_matrix->cell(0,0) = 0;
+  // the database owns the placement until finish, it also initializes the bounding boxes
+  _place_db = new ParPlaceDB(_netlist, _hw_target);
+  for (unsigned i = 0; i < _place_db->getElementNum(); ++i)
+    if (_place_db->isMovable(i))
+      _movable_elements.push_back(i);
 
-  for (COORD y = 1; y < y_limit; ++y) {
-    if (_hw_target->getGrid(0,y)->getCurrentElement())
-      _used_matrix->cell(0,(unsigned)y) = _used_matrix->cell(0,(unsigned)(y-1)) + 1;
-    else
-      _used_matrix->cell(0,(unsigned)y) = _used_matrix->cell(0,(unsigned)(y-1));
-  }
-
-  for (COORD x = 1; x < x_limit; ++x) {
-    if (_hw_target->getGrid(x, 0)->getCurrentElement())
-      _used_matrix->cell((unsigned)x, 0) = _used_matrix->cell((unsigned)(x-1),0) + 1;
-    else
-      _used_matrix->cell((unsigned)x, 0) = _used_matrix->cell((unsigned)(x-1),0);
-  }
+  COORD y_limit = _hw_target->getYLimit();
+  COORD x_limit = _hw_target->getXLimit();
 
-  for (unsigned x = 1; x < (unsigned)x_limit; ++x) {
-    for (unsigned y = 1; y < (unsigned)y_limit; ++y) {
-      unsigned used_element = 
-        _used_matrix->cell(x-1, y) +
-        _used_matrix->cell(x, y-1) -
-        _used_matrix->cell(x-1, y-1);
-      if (_hw_target->getGrid(x,y)->getCurrentElement())
-        _used_matrix->cell(x,y) = used_element + 1;
-      else
-        _used_matrix->cell(x,y) = used_element;
-    }
-  }
+  // build spatial wire index, it is updated when a move is committed
+  _wire_index = new ParWireIndex(_place_db, x_limit, y_limit,
+      ParWireIndex::getDefaultBucketSize(x_limit, y_limit));
+  for (unsigned i = 0; i < _place_db->getWireNum(); ++i)
+    _wire_index->insertWire(i);
 
-  qlog.speak("QPlace", "Dump initial placement result");
-  dumpCurrentPlacement("init.place"); 
-  dumpUsedMatrix("init.matrix");
+  QASSERT(y_limit);QASSERT(x_limit);
+  _occupancy = ParOccupancy::create(_option.occupancy, (unsigned)x_limit, (unsigned)y_limit);
+  qlog.speak("Place", "Use %s occupancy to count used grids",
+      ParOccupancy::getTypeName(_option.occupancy));
+
+  // initilize grid utilization
+  _occupancy->build(*_hw_target);
+
+  // batch stamps to detect conflicts between moves evaluated in parallel
+  _element_stamp.assign(_place_db->getElementNum(), 0);
+  _wire_box_stamp.assign(_place_db->getWireNum(), 0);
+  _wire_cost_stamp.assign(_place_db->getWireNum(), 0);
+  _grid_stamp.assign((size_t)(x_limit * y_limit), 0);
 }
 
 void QPlace::usedMatrixSanityCheck() {
-  for (unsigned i = 0; i < _used_matrix->getSizeX(); ++i)
-    for (unsigned j = 0; j < _used_matrix->getSizeY(); ++j)
+  for (unsigned i = 0; i < _occupancy->getSizeX(); ++i)
+    for (unsigned j = 0; j < _occupancy->getSizeY(); ++j)
       usedMatrixSanityCheck(i, j);
 }
 
@@ -307,45 +515,23 @@ void QPlace::usedMatrixSanityCheck(unsigned x, unsigned y) {
   unsigned sum = 0;
   for (COORD i = 0; i <= x; ++i) {
     for (COORD j = 0; j <= y; ++j) {
-      if (_hw_target->getGrid(i,j)->getCurrentElement())
+      if (_place_db->getGridElement(i, j) >= 0)
         ++sum;
     }
   }
-  if (_used_matrix->cell(x, y) != sum) {
+  if (_occupancy->getUsedCell(x, y) != sum) {
     dumpCurrentPlacement("debug.place");
     dumpUsedMatrix("debug.usedmatrix");
   }
-  QASSERT(_used_matrix->cell(x, y) == sum);
+  QASSERT(_occupancy->getUsedCell(x, y) == sum);
 }
 
-void QPlace::checkIfReadyToMove() {
-  WIRE_ITER w_iter = _netlist->wire_begin();
-  for(; w_iter != _netlist->wire_end(); ++w_iter) {
-    ParWire* wire = *w_iter;
-    QASSERT(wire->isReadyToMove());
-  }
-
-  ELE_ITER ele_iter = _netlist->element_begin();
-  for (; ele_iter != _netlist->element_end(); ++ele_iter) {
-    ParElement* element = *ele_iter;
-    QASSERT(element->isReadyToMove());
-  }
-
-  for (COORD x = 0; x < _hw_target->getXLimit(); ++x) {
-    for (COORD y = 0; y < _hw_target->getYLimit(); ++y) {
-      QASSERT(_hw_target->getGrid(x,y)->isReadyToMove());
-    }
-  }
-
-
-}
-
-void QPlace::generateMove(ParElement* &element, COORD& x, COORD& y) {
+void QPlace::generateMove(unsigned& element, COORD& x, COORD& y, unsigned& move_type) {
   unsigned ele_i = _random_gen.uRand(0, (int)_movable_elements.size()-1);
   element = _movable_elements[ele_i];
 
-  COORD ele_x = element->getX();
-  COORD ele_y = element->getY();
+  COORD ele_x = _place_db->getX(element);
+  COORD ele_y = _place_db->getY(element);
 
   float r_limit = _annealer->getRLimit();
 
@@ -362,17 +548,18 @@ void QPlace::generateMove(ParElement* &element, COORD& x, COORD& y) {
   QASSERT((ele_y - y_range_min) <= r_limit);
   QASSERT((y_range_max - ele_y) <= r_limit);
 
-  do {
-    x = (COORD)_random_gen.iRand((int)x_range_min, (int)x_range_max);
-    y = (COORD)_random_gen.iRand((int)y_range_min, (int)y_range_max);
-  } while( x == ele_x && y == ele_y );
+  ParMoveRegion region = {x_range_min, x_range_max, y_range_min, y_range_max};
+  move_type = _move_agent->select(_random_gen);
+  if (!_move_agent->getGenerator(move_type)->propose(*_place_db, element, region, _random_gen, x, y)) {
+    move_type = 0;
+    _move_agent->getGenerator(move_type)->propose(*_place_db, element, region, _random_gen, x, y);
+  }
 }
 
 
 bool QPlace::tryMove() {
   // check if they placer is ready to move, this is unnecessary, only for debug
 #ifdef SANITY_CHECK
-  checkIfReadyToMove();
   usedMatrixSanityCheck();
   sanityCheck();
 #endif
@@ -380,29 +567,40 @@ bool QPlace::tryMove() {
   COORD x = std::numeric_limits<COORD>::max();
   COORD y = std::numeric_limits<COORD>::max();
 
-  ParElement* ele = NULL;
-  generateMove(ele, x, y);
+  unsigned ele = 0;
+  unsigned move_type = 0;
+  generateMove(ele, x, y, move_type);
 
-  COORD from_x = ele->getX();
-  COORD from_y = ele->getY();
+  COORD from_x = _place_db->getX(ele);
+  COORD from_y = _place_db->getY(ele);
 
-  ParGrid* tgt_grid = _hw_target->getGrid(x, y);
-  bool is_swap = tgt_grid->getCurrentElement();
+  // fixed elements are never swapped away
+  int tgt_ele = _place_db->getGridElement(x, y);
+  if (tgt_ele >= 0 && !_place_db->isMovable((unsigned)tgt_ele)) {
+    _move_agent->update(move_type, false, 0.0);
+    return false;
+  }
 
 
   findAffectedElementsAndWires(ele, x, y);
 
+  _cost_batch.clear();
+  for (size_t i = 0; i < _affected_wires.size(); ++i)
+    addCostWire(_affected_wires[i]);
+  _placement_cost->computeCost(_cost_batch);
+
   double delta_cost = 0;
-  WIRE_ITER w_iter = _affected_wires.begin();
-  for (; w_iter != _affected_wires.end(); ++w_iter) {
-    ParWire* par_wire = *w_iter;
-    par_wire->saveCost();
-    double new_cost = _placement_cost->computeCost(par_wire, *_used_matrix);
-    par_wire->setCost(new_cost);
-    delta_cost += (new_cost - par_wire->getSavedCost());
+  for (size_t i = 0; i < _affected_wires.size(); ++i) {
+    unsigned wire = _affected_wires[i];
+    double old_cost = _place_db->getCost(wire);
+    double new_cost = _cost_batch.getCost(i) * getWireWeight(wire, _place_db->getBox(wire));
+    _saved_costs.push_back(old_cost);
+    _place_db->setCost(wire, new_cost);
+    delta_cost += (new_cost - old_cost);
   }
 
   bool accept = _annealer->shouldAccept(delta_cost);
+  _move_agent->update(move_type, accept, delta_cost);
   if (accept) {
     commitMove();
     //qlog.speak("Place", "old_cost %f", _current_total_cost);
@@ -410,181 +608,352 @@ bool QPlace::tryMove() {
     //qlog.speak("Place", "delta cost is %f, new_cost %f", delta_cost,
     //    _current_total_cost);
   } else 
-    restoreMove(from_x, from_y, x, y, is_swap);
+    restoreMove(from_x, from_y, x, y);
 
   _affected_wires.clear();
-  _affected_elements.clear();
-  _affected_grids.clear();
+  _saved_boxes.clear();
+  _saved_costs.clear();
+  _moved_wire_num = 0;
   return accept;
 }
 
 void QPlace::commitMove() {
-  for (size_t i = 0; i < _affected_elements.size(); ++i) {
-    ParElement* element = _affected_elements[i];
-    element->save();
-  }
+  // the bounding boxes of other affected wires did not change
+  for (size_t i = 0; i < _moved_wire_num; ++i)
+    _wire_index->updateWire(_affected_wires[i]);
+}
 
-  for (size_t i = 0; i < _affected_grids.size(); ++i) {
-    ParGrid* grid = _affected_grids[i];
-    grid->save();
-  }
+void QPlace::restoreMove(COORD from_x, COORD from_y, COORD to_x, COORD to_y) {
+  int src_ele = _place_db->getGridElement(to_x, to_y);
+  int tgt_ele = _place_db->getGridElement(from_x, from_y);
+  QASSERT(src_ele >= 0);
 
-  WIRE_ITER w_iter = _affected_wires.begin();
-  for (; w_iter != _affected_wires.end(); ++w_iter) {
-    (*w_iter)->saveBoundingBox();
-    (*w_iter)->saveCost();
+  _place_db->placeElement((unsigned)src_ele, from_x, from_y);
+  if (tgt_ele >= 0) {
+    _place_db->placeElement((unsigned)tgt_ele, to_x, to_y);
+  } else {
+    _place_db->clearGrid(to_x, to_y);
+    _occupancy->moveElement(to_x, to_y, from_x, from_y);
   }
 
+  for (size_t i = 0; i < _moved_wire_num; ++i)
+    _place_db->setBoundingBox(_affected_wires[i], _saved_boxes[i]);
+
+  for (size_t i = 0; i < _affected_wires.size(); ++i)
+    _place_db->setCost(_affected_wires[i], _saved_costs[i]);
+
 }
 
-void QPlace::restoreMove(COORD from_x, COORD from_y, COORD to_x, COORD to_y, bool is_swap) {
-  for (size_t i = 0; i < _affected_elements.size(); ++i) {
-    ParElement* element = _affected_elements[i];
-    element->restore();
+
+void QPlace::findAffectedElementsAndWires(unsigned element, COORD dest_x, COORD dest_y) {
+  QASSERT(_affected_wires.size() == 0);
+  QASSERT(_saved_boxes.size() == 0);
+  QASSERT(_saved_costs.size() == 0);
+
+  // a wire is affected once per move, reset the stamps when they wrap around
+  if (++_move_stamp == 0) {
+    _place_db->clearMoveStamps();
+    _move_stamp = 1;
   }
 
-  for (size_t i = 0; i < _affected_grids.size(); ++i) {
-    ParGrid* grid = _affected_grids[i];
-    grid->restore();
+  COORD from_x = _place_db->getX(element);
+  COORD from_y = _place_db->getY(element);
+
+  int tgt_element = _place_db->getGridElement(dest_x, dest_y);
+  bool is_swap = tgt_element >= 0;
+
+  _place_db->placeElement(element, dest_x, dest_y);
+  if (is_swap) {
+    _place_db->placeElement((unsigned)tgt_element, from_x, from_y);
+  } else {
+    _place_db->clearGrid(from_x, from_y);
+
+    //only swap to an empty grid need to update the use matrix
+    _occupancy->moveElement(from_x, from_y, dest_x, dest_y);
+    //usedMatrixSanityCheck();
   }
 
-  WIRE_ITER w_iter = _affected_wires.begin();
-  for (; w_iter != _affected_wires.end(); ++w_iter) {
-    (*w_iter)->restore();
+
+  const unsigned* w_iter = _place_db->wire_begin(element);
+  for (; w_iter != _place_db->wire_end(element); ++w_iter) {
+    unsigned wire = *w_iter;
+    _place_db->markMove(wire, _move_stamp);
+    _affected_wires.push_back(wire);
+    _saved_boxes.push_back(_place_db->getBoundingBox(wire));
+    _place_db->updateBoundingBox(wire, from_x, from_y, dest_x, dest_y);
+  }
+
+  if (is_swap) {
+    w_iter = _place_db->wire_begin((unsigned)tgt_element);
+    for (; w_iter != _place_db->wire_end((unsigned)tgt_element); ++w_iter) {
+      unsigned wire = *w_iter;
+      // swapping two elements of the same wire does not change its bounding box
+      if (!_place_db->markMove(wire, _move_stamp)) {
+        size_t i = std::find(_affected_wires.begin(), _affected_wires.end(), wire) - _affected_wires.begin();
+        _place_db->setBoundingBox(wire, _saved_boxes[i]);
+        continue;
+      }
+      _affected_wires.push_back(wire);
+      _saved_boxes.push_back(_place_db->getBoundingBox(wire));
+      _place_db->updateBoundingBox(wire, dest_x, dest_y, from_x, from_y);
+    }
   }
+  _moved_wire_num = _affected_wires.size();
 
-  if (!is_swap)
-    updateUseMatrix(to_x, to_y, from_x, from_y);
 
+  // moving to an empty grid changes the utilization of every wire covering either grid,
+  // the wire index is only updated on commit, but wires whose bounding box changed are already stamped
+  if (!is_swap) {
+    _wire_index->collectWires(from_x, from_y, _move_stamp, _affected_wires);
+    _wire_index->collectWires(dest_x, dest_y, _move_stamp, _affected_wires);
+  }
 }
 
+unsigned QPlace::tryMoveBatch(unsigned num_move, double& cost_sum, double& cost_square_sum) {
+  QASSERT(num_move <= _batch_moves.size());
+  ++_batch_stamp;
+  _batch_moved_wires.clear();
+  _batch_moved_grids.clear();
 
-void QPlace::findAffectedElementsAndWires(ParElement* element, COORD dest_x, COORD dest_y) {
-  QASSERT(_affected_elements.size() == 0);
-  QASSERT(_affected_wires.size() == 0);
-  QASSERT(_affected_grids.size() == 0);
-  element->save();
+  // moves are generated in order, so the random sequence does not depend on thread timing
+  for (unsigned i = 0; i < num_move; ++i) {
+    PlaceMove& move = _batch_moves[i];
+    generateMove(move.element, move.to_x, move.to_y, move.move_type);
+  }
+  _batch_move_num = num_move;
+
+  _thread_pool->run(std::bind(&QPlace::evaluateBatch, this, std::placeholders::_1));
+
+  // commit in generation order, a move that conflicts with an accepted move is evaluated again
+  unsigned success_num = 0;
+  for (unsigned i = 0; i < num_move; ++i) {
+    PlaceMove& move = _batch_moves[i];
+    if (!refreshMove(move)) {
+      ++_stale_move_num;
+      if (_place_db->getX(move.element) == move.to_x && _place_db->getY(move.element) == move.to_y)
+        continue;
+      evaluateMove(move);
+    }
 
-  ParGrid* src_grid = element->getCurrentGrid();
-  src_grid->save();
+    if (move.tgt_element >= 0 && !_place_db->isMovable((unsigned)move.tgt_element)) {
+      _move_agent->update(move.move_type, false, 0.0);
+      continue;
+    }
 
-  ParGrid* tgt_grid = _hw_target->getGrid(dest_x, dest_y);
-  tgt_grid->save();
+    bool accept = _annealer->shouldAccept(move.delta_cost);
+    _move_agent->update(move.move_type, accept, move.delta_cost);
+    if (!accept)
+      continue;
 
-  _affected_grids.push_back(src_grid);
-  _affected_grids.push_back(tgt_grid);
+    applyMove(move);
+    ++success_num;
+    cost_sum += _current_total_cost;
+    cost_square_sum += _current_total_cost * _current_total_cost;
 
+#ifdef SANITY_CHECK
+    sanityCheck();
+    for (size_t j = 0; j < move.wires.size(); ++j) {
+      double cost = _placement_cost->computeCost(*_place_db, move.wires[j], *_occupancy) *
+        getWireWeight(move.wires[j], _place_db->getBox(move.wires[j]));
+      QASSERT(std::fabs(cost - _place_db->getCost(move.wires[j])) < 1e-9);
+    }
+#endif
+  }
 
-  ParElement* tgt_element = tgt_grid->getCurrentElement();
-  bool is_swap = tgt_element;
+  return success_num;
+}
 
-  COORD from_x = src_grid->getLoc().getLocX();
-  COORD from_y = src_grid->getLoc().getLocY();
+void QPlace::evaluateBatch(unsigned thread_id) {
+  unsigned thread_num = _thread_pool->getThreadNum();
+  for (unsigned i = thread_id; i < _batch_move_num; i += thread_num)
+    evaluateMove(_batch_moves[i]);
+}
 
-  COORD to_x = tgt_grid->getLoc().getLocX();
-  COORD to_y = tgt_grid->getLoc().getLocY();
-  
+void QPlace::evaluateMove(PlaceMove& move) const {
+  move.wires.clear();
+  move.boxes.clear();
+  move.costs.clear();
+  move.delta_cost = 0.0;
+
+  unsigned element = move.element;
+  move.from_x = _place_db->getX(element);
+  move.from_y = _place_db->getY(element);
+  move.tgt_element = _place_db->getGridElement(move.to_x, move.to_y);
+  int tgt_element = move.tgt_element;
+
+  const unsigned* w_iter = _place_db->wire_begin(element);
+  for (; w_iter != _place_db->wire_end(element); ++w_iter) {
+    move.wires.push_back(*w_iter);
+    move.boxes.push_back(predictBoundingBox(move, *w_iter));
+  }
 
-  if (is_swap) {
-    tgt_element->save();
-    _affected_elements.push_back(element);
-    _affected_elements.push_back(tgt_element);
-    tgt_grid->setParElement(element);
-    src_grid->setParElement(tgt_element);
-
-    element->setGrid(tgt_grid);
-    tgt_element->setGrid(src_grid);
-  } else {
-    _affected_elements.push_back(element);
-    tgt_grid->setParElement(element);
-    src_grid->setParElement(NULL);
+  if (tgt_element >= 0) {
+    w_iter = _place_db->wire_begin((unsigned)tgt_element);
+    for (; w_iter != _place_db->wire_end((unsigned)tgt_element); ++w_iter) {
+      unsigned wire = *w_iter;
+      if (std::find(move.wires.begin(), move.wires.end(), wire) != move.wires.end())
+        continue;
+      move.wires.push_back(wire);
+      move.boxes.push_back(predictBoundingBox(move, wire));
+    }
+  }
+  move.moved_wire_num = move.wires.size();
+
+  // moving to an empty grid changes the utilization of every wire covering either grid
+  if (tgt_element < 0) {
+    _wire_index->collectWires(move.from_x, move.from_y, move.wires);
+    _wire_index->collectWires(move.to_x, move.to_y, move.wires);
+    // wires are indexed in uniq id order, so the cost is summed in the same order on every run
+    std::sort(move.wires.begin() + move.moved_wire_num, move.wires.end());
+    move.wires.erase(std::unique(move.wires.begin() + move.moved_wire_num, move.wires.end()),
+        move.wires.end());
+
+    // wires of the moved element are already in the front
+    size_t num_wire = move.moved_wire_num;
+    for (size_t i = move.moved_wire_num; i < move.wires.size(); ++i) {
+      unsigned wire = move.wires[i];
+      if (std::find(move.wires.begin(), move.wires.begin() + move.moved_wire_num, wire) !=
+          move.wires.begin() + move.moved_wire_num)
+        continue;
+      move.wires[num_wire++] = wire;
+      move.boxes.push_back(_place_db->getBoundingBox(wire));
+    }
+    move.wires.resize(num_wire);
+  }
 
-    element->setGrid(tgt_grid);
+  for (size_t i = 0; i < move.wires.size(); ++i) {
+    double new_cost = computeMoveCost(move, i);
+    move.costs.push_back(new_cost);
+    move.delta_cost += (new_cost - _place_db->getCost(move.wires[i]));
+  }
+}
 
-    ////only swap to an empty grid need to update the use matrix
-    //updateUseMatrix(src_grid->getLoc().getLocX(), src_grid->getLoc().getLocY(),
-    //              dest_x, dest_y);
+BoundingBox QPlace::predictBoundingBox(const PlaceMove& move, unsigned wire) const {
+  bool on_element = _place_db->hasWire(move.element, wire);
+  bool on_tgt_element = move.tgt_element >= 0 &&
+    _place_db->hasWire((unsigned)move.tgt_element, wire);
+
+  // swapping two elements of the same wire does not change its bounding box
+  if (on_element && on_tgt_element)
+    return _place_db->getBoundingBox(wire);
+  else if (on_element)
+    return _place_db->predictBoundingBox(wire, move.from_x, move.from_y,
+        move.to_x, move.to_y, move.element, move.tgt_element);
+  QASSERT(on_tgt_element);
+  return _place_db->predictBoundingBox(wire, move.to_x, move.to_y,
+      move.from_x, move.from_y, (unsigned)move.tgt_element, (int)move.element);
+}
 
-    ////sanity check
-    updateUseMatrix(from_x, from_y, to_x, to_y);
-    //usedMatrixSanityCheck();
+double QPlace::computeMoveCost(const PlaceMove& move, size_t index) const {
+  const Box& bbox = move.boxes[index].getBoundBox();
+  unsigned used_cell = _occupancy->getUsedCell(bbox.xl(), bbox.yt(), bbox.xr(), bbox.yb());
+
+  // the occupancy still has the element on the source grid
+  if (move.tgt_element < 0) {
+    if (bbox.isInBox((int)move.from_x, (int)move.from_y))
+      --used_cell;
+    if (bbox.isInBox((int)move.to_x, (int)move.to_y))
+      ++used_cell;
   }
 
+  return _placement_cost->computeCost(_place_db->getPinNum(move.wires[index]), bbox, used_cell) *
+    getWireWeight(move.wires[index], bbox);
+}
 
-  std::vector<ParElement*>::iterator ele_iter = _affected_elements.begin();
-  for (; ele_iter != _affected_elements.end(); ++ele_iter) {
-    ParElement* curr_ele = *ele_iter;
-    WIRE_ITER_V w_iter = curr_ele->begin();
-    for (; w_iter != curr_ele->end(); ++w_iter) {
-      _affected_wires.insert(*w_iter);
-      if (curr_ele == element)
-        (*w_iter)->updateBoundingBox(from_x, from_y, to_x, to_y);
-      else if (curr_ele == tgt_element)
-        (*w_iter)->updateBoundingBox(to_x, to_y, from_x, from_y);
-      else
-        QASSERT(0);
+bool QPlace::refreshMove(PlaceMove& move) {
+  // the element was moved, or the target grid was filled or emptied
+  if (_element_stamp[move.element] == _batch_stamp ||
+      _grid_stamp[gridIndex(move.to_x, move.to_y)] == _batch_stamp)
+    return false;
+
+  // a wire grew over one of the grids and is missing in the affected wires,
+  // its cost is computed below because its bounding box changed in the batch
+  if (move.tgt_element < 0) {
+    for (size_t i = 0; i < _batch_moved_wires.size(); ++i) {
+      unsigned wire = _batch_moved_wires[i];
+      if (!_place_db->isInBox(wire, move.from_x, move.from_y) &&
+          !_place_db->isInBox(wire, move.to_x, move.to_y))
+        continue;
+      if (std::find(move.wires.begin(), move.wires.end(), wire) != move.wires.end())
+        continue;
+      move.wires.push_back(wire);
+      move.boxes.push_back(_place_db->getBoundingBox(wire));
+      move.costs.push_back(_place_db->getCost(wire));
     }
   }
 
+  bool refresh = false;
+  for (size_t i = 0; i < move.wires.size(); ++i) {
+    unsigned wire = move.wires[i];
+    bool is_moved = i < move.moved_wire_num;
 
-  if (!is_swap) {
-    WIRE_ITER w_iter = _netlist->wire_begin(); 
-    for (; w_iter != _netlist->wire_end(); ++w_iter) {
-      if (_affected_wires.count(*w_iter)) continue;
-
-      ParWire* wire = *w_iter;
-      if (wire->getCurrentBoundingBox().getBoundBox().isInBox((unsigned)from_x, (unsigned)from_y) ||
-          wire->getCurrentBoundingBox().getBoundBox().isInBox((unsigned)to_x, (unsigned)to_y))
-        _affected_wires.insert(*w_iter);
+    // another element of the wire moved, the elements of this move did not
+    if (_wire_box_stamp[wire] == _batch_stamp) {
+      if (is_moved)
+        move.boxes[i] = predictBoundingBox(move, wire);
+      else
+        move.boxes[i] = _place_db->getBoundingBox(wire);
+    } else if (_wire_cost_stamp[wire] != _batch_stamp) {
+      // the cost before the move is unchanged, but the new bounding box
+      // of a moved wire can cover a grid whose utilization changed
+      bool stale = false;
+      const Box& bbox = move.boxes[i].getBoundBox();
+      for (size_t j = 0; !stale && is_moved && j < _batch_moved_grids.size(); ++j)
+        stale = bbox.isInBox((int)_batch_moved_grids[j].first, (int)_batch_moved_grids[j].second);
+      if (!stale) continue;
     }
+
+    move.costs[i] = computeMoveCost(move, i);
+    refresh = true;
+  }
+
+  if (refresh) {
+    ++_refresh_move_num;
+    move.delta_cost = 0.0;
+    for (size_t i = 0; i < move.wires.size(); ++i)
+      move.delta_cost += (move.costs[i] - _place_db->getCost(move.wires[i]));
   }
+
+  return true;
 }
 
-void QPlace::updateUseMatrix(COORD from_x, COORD from_y, COORD to_x, COORD to_y) {
-  QASSERT(from_x != to_x || from_y != to_y);
-  bool x_inc = to_x >= from_x;
-  bool y_inc = to_y >= from_y;
+size_t QPlace::gridIndex(COORD x, COORD y) const {
+  return (size_t)(y * _hw_target->getXLimit() + x);
+}
 
-  if (x_inc == y_inc) {
-    for (COORD i = (x_inc)?from_x:to_x; i < _used_matrix->getSizeX(); ++i) {
-      for (COORD j = (x_inc)?from_y:to_y; j <= (((x_inc)?to_y:from_y) - 1); ++j) {
-        if (x_inc)
-          --_used_matrix->cell((unsigned)i, (unsigned)j);
-        else
-          ++_used_matrix->cell((unsigned)i, (unsigned)j);
-      }
-    }
+void QPlace::applyMove(const PlaceMove& move) {
+  QASSERT(_place_db->getGridElement(move.from_x, move.from_y) == (int)move.element);
+  QASSERT(_place_db->getGridElement(move.to_x, move.to_y) == move.tgt_element);
 
-    for (COORD i = (x_inc)?from_x:to_x; i <= (((x_inc)?to_x:from_x) - 1); ++i) {
-      for (COORD j = (x_inc)?to_y:from_y; j < _used_matrix->getSizeY(); ++j) {
-        if (x_inc)
-          --_used_matrix->cell((unsigned)i, (unsigned)j);
-        else
-          ++_used_matrix->cell((unsigned)i, (unsigned)j);
-      }
-    }
+  _place_db->placeElement(move.element, move.to_x, move.to_y);
+  _element_stamp[move.element] = _batch_stamp;
 
+  if (move.tgt_element >= 0) {
+    _place_db->placeElement((unsigned)move.tgt_element, move.from_x, move.from_y);
+    _element_stamp[(unsigned)move.tgt_element] = _batch_stamp;
   } else {
-    for (COORD i = (x_inc)?from_x:to_x; i <= (((x_inc)?to_x:from_x) - 1); ++i) {
-      for (COORD j = (x_inc)?from_y:to_y; j < _used_matrix->getSizeY(); ++j) {
-        if (x_inc)
-          --_used_matrix->cell((unsigned)i, (unsigned)j);
-        else
-          ++_used_matrix->cell((unsigned)i, (unsigned)j);
-      }
-    }
-
-    for (COORD i = (x_inc)?to_x:from_x; i < _used_matrix->getSizeX(); ++i) {
-      for (COORD j = (x_inc)?to_y:from_y; j <= (((x_inc)?from_y:to_y) - 1); ++j) {
-        if (x_inc)
-          ++_used_matrix->cell((unsigned)i, (unsigned)j);
-        else
-          --_used_matrix->cell((unsigned)i, (unsigned)j);
-      }
+    _place_db->clearGrid(move.from_x, move.from_y);
+    _occupancy->moveElement(move.from_x, move.from_y, move.to_x, move.to_y);
+    _batch_moved_grids.push_back(std::make_pair(move.from_x, move.from_y));
+    _batch_moved_grids.push_back(std::make_pair(move.to_x, move.to_y));
+  }
+  _grid_stamp[gridIndex(move.from_x, move.from_y)] = _batch_stamp;
+  _grid_stamp[gridIndex(move.to_x, move.to_y)] = _batch_stamp;
+
+  for (size_t i = 0; i < move.wires.size(); ++i) {
+    unsigned wire = move.wires[i];
+    if (i < move.moved_wire_num) {
+      _place_db->setBoundingBox(wire, move.boxes[i]);
+      _wire_index->updateWire(wire);
+      if (_wire_box_stamp[wire] != _batch_stamp)
+        _batch_moved_wires.push_back(wire);
+      _wire_box_stamp[wire] = _batch_stamp;
     }
+    _place_db->setCost(wire, move.costs[i]);
+    _wire_cost_stamp[wire] = _batch_stamp;
   }
 
-
+  _current_total_cost += move.delta_cost;
 }
 
 void QPlace::dumpUsedMatrix(std::string filename) const {
@@ -600,7 +969,7 @@ void QPlace::dumpUsedMatrix(std::string filename) const {
   COORD x_limit = _hw_target->getYLimit();
   for (COORD y = 0; y < y_limit; ++y) {
     for (COORD x = 0; x < x_limit; ++x) {
-      outfile << "x: "  << x << " y: " << y << " " << _used_matrix->cell((unsigned)x, (unsigned)y) << std::endl;
+      outfile << "x: "  << x << " y: " << y << " " << _occupancy->getUsedCell((unsigned)x, (unsigned)y) << std::endl;
     }
   }
 
@@ -613,12 +982,10 @@ void QPlace::dumpCurrentPlacement(std::string filename) const {
   
 
   qlog.speak("QPlace", "Dump placement to %s", filename.c_str());
-  ELE_ITER ele_iter = _netlist->element_begin();
-  for (; ele_iter != _netlist->element_end(); ++ele_iter) {
-    ParElement* element = *ele_iter;
-    COORD x = element->getX();
-    COORD y = element->getY();
-    std::string name = element->getName();
+  for (unsigned i = 0; i < _place_db->getElementNum(); ++i) {
+    COORD x = _place_db->getX(i);
+    COORD y = _place_db->getY(i);
+    std::string name = _place_db->getElement(i)->getName();
     outfile << "Gate: " << name <<
       " " << x <<" " << y << std::endl;
   }
@@ -628,6 +995,34 @@ void QPlace::dumpCurrentPlacement(std::string filename) const {
 }
 
 
+bool QPlace::readPlacement(const std::string& filename, PLACE_LOCS& locations) {
+  std::ifstream infile(filename.c_str());
+  if (!infile.is_open())
+    return false;
+
+  // names of model pins have spaces, coordinates are the last two fields
+  const std::string tag = "Gate: ";
+  std::string line;
+  while (std::getline(infile, line)) {
+    if (line.compare(0, tag.size(), tag) != 0)
+      continue;
+    size_t y_pos = line.rfind(' ');
+    size_t x_pos = (y_pos == std::string::npos || y_pos == 0) ?
+      std::string::npos : line.rfind(' ', y_pos - 1);
+    if (x_pos == std::string::npos || x_pos < tag.size())
+      continue;
+
+    std::istringstream ss(line.substr(x_pos));
+    COORD x = 0;
+    COORD y = 0;
+    if (!(ss >> x >> y))
+      continue;
+    locations[line.substr(tag.size(), x_pos - tag.size())] = std::make_pair(x, y);
+  }
+
+  return true;
+}
+
 float QPlace::getStartingT() {
 
 
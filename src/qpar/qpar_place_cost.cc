@@ -17,13 +17,23 @@
  *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
  ****************************************************************************/
 
+
 #include "qpar/qpar_place_cost.hh"
-#include "qpar/qpar_netlist.hh"
+#include "qpar/qpar_place_db.hh"
+#include "qpar/qpar_occupancy.hh"
 
 #include "utils/qlog.hh"
 
 #include <cmath>
 #include <cassert>
+#include <cstring>
+#include <stdint.h>
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define QPAR_COST_SIMD
+#include <immintrin.h>
+#endif
 
 //data from ICCAD 1994 960-965 by Eric Cheng
 const float PlacementCost::cross_count[50] = {  
@@ -39,22 +49,267 @@ const float PlacementCost::cross_count[50] = {
   2.6887f, 2.7148f, 2.7410f, 2.7671f, 2.7933f
 };
 
+// exponent of the fill rate
+static const double FILL_EXP = 1.3;
+// upper bound of the fill rate after the crossing factor
+static const double MAX_FILL = 0.95;
 
+// 2 / (k * ln2), odd terms of log2(m) = log2((1 + t) / (1 - t)), |t| <= 0.172
+static const double LOG2_C1 = 2.8853900817779268;
+static const double LOG2_C3 = 0.9617966939259756;
+static const double LOG2_C5 = 0.5770780163555853;
+static const double LOG2_C7 = 0.4121985831111324;
+static const double LOG2_C9 = 0.3205988979753252;
+// 1 / k!, taylor terms of exp(z), |z| <= ln2 / 2
+static const double EXP_C2 = 0.5;
+static const double EXP_C3 = 0.16666666666666666;
+static const double EXP_C4 = 0.041666666666666664;
+static const double EXP_C5 = 0.008333333333333333;
+static const double EXP_C6 = 0.001388888888888889;
+static const double EXP_C7 = 0.0001984126984126984;
+static const double LN2 = 0.6931471805599453;
+static const double SQRT2 = 1.4142135623730951;
+// 2^52 + 1023, turns a biased exponent put in the low mantissa bits into the exponent
+static const double EXP_BIAS_MAGIC = 4503599627371519.0;
 
 
-double CongestionAwareCost::computeCost(ParWire* wire, const qpr_matrix<unsigned>& used_matrix) {
+/*! \brief crossing count factor of a wire
+ */
+static double crossingFactor(unsigned pin_num) {
+  if (pin_num <= 49)
+    return PlacementCost::cross_count[pin_num];
+  return static_cast<float>(2.7933 + 0.02616 * (pin_num - 50));
+}
 
-  //this is a model wire that connects only to the top module port
-  if (wire->getElementNumber() <= 1) return 0.0;
+/*! \brief x^1.3 for x in [0, 1]
+ *
+ * x = m * 2^e with m in [sqrt(1/2), sqrt(2)), log2(m) by the series in
+ * t = (m - 1) / (m + 1) up to t^9, y = 1.3 * (e + log2(m)) and
+ * 2^y = 2^n * sqrt(2) * exp((y - n - 0.5) * ln2) with exp up to z^7.
+ * The relative error is below 1e-8. The vector kernels do the same
+ * operations in the same order, so all paths give the same bits.
+ */
+static double fastPow(double x) {
+  if (x == 0.0)
+    return 0.0;
+
+  uint64_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  double e = (double)((int)(bits >> 52) - 1023);
+  bits = (bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL;
+  double m;
+  std::memcpy(&m, &bits, sizeof(m));
+  if (m > SQRT2) {
+    m = m * 0.5;
+    e = e + 1.0;
+  }
+
+  double t = (m - 1.0) / (m + 1.0);
+  double t2 = t * t;
+  double log2m = ((((LOG2_C9 * t2 + LOG2_C7) * t2 + LOG2_C5) * t2 + LOG2_C3) * t2 + LOG2_C1) * t;
+  double y = FILL_EXP * (e + log2m);
+
+  double n = std::floor(y);
+  double z = ((y - n) - 0.5) * LN2;
+  double q = ((((((EXP_C7 * z + EXP_C6) * z + EXP_C5) * z + EXP_C4) * z + EXP_C3) * z + EXP_C2) * z + 1.0) * z + 1.0;
+
+  uint64_t scale_bits = (uint64_t)((int)n + 1023) << 52;
+  double scale;
+  std::memcpy(&scale, &scale_bits, sizeof(scale));
+  return (q * SQRT2) * scale;
+}
+
+/*! \brief cost of one wire from the batch inputs, fill^1.3 by fastPow
+ */
+static double fastCost(double perimeter, double cells, double used_cell, double crossing) {
+  double fill_rate = fastPow(used_cell / cells) * crossing;
+  fill_rate = std::min(fill_rate, MAX_FILL);
+  return perimeter / (1.0 - fill_rate);
+}
+
+/*! \brief cost of one wire from the batch inputs, fill^1.3 by std::pow
+ */
+static double exactCost(double perimeter, double cells, double used_cell, double crossing) {
+  double fill_rate = used_cell / cells;
+  QASSERT(fill_rate <= 1.0);
+  fill_rate = std::pow(fill_rate, FILL_EXP) * crossing;
+  fill_rate = std::min(fill_rate, MAX_FILL);
+  return perimeter / (1.0 - fill_rate);
+}
+
+static void computeCostScalar(size_t num, const double* perimeters, const double* cells,
+    const double* used_cells, const double* crossings, double* costs) {
+  for (size_t i = 0; i < num; ++i)
+    costs[i] = fastCost(perimeters[i], cells[i], used_cells[i], crossings[i]);
+}
+
+#ifdef QPAR_COST_SIMD
+
+static void computeCostSSE2(size_t num, const double* perimeters, const double* cells,
+    const double* used_cells, const double* crossings, double* costs) {
+  const __m128d zero = _mm_setzero_pd();
+  const __m128d one = _mm_set1_pd(1.0);
+  const __m128i mantissa_mask = _mm_set1_epi64x(0x000FFFFFFFFFFFFFLL);
+  const __m128i one_bits = _mm_set1_epi64x(0x3FF0000000000000LL);
+  const __m128i magic_bits = _mm_set1_epi64x(0x4330000000000000LL);
+
+  size_t i = 0;
+  for (; i + 2 <= num; i += 2) {
+    __m128d used = _mm_loadu_pd(used_cells + i);
+    __m128d x = _mm_div_pd(used, _mm_loadu_pd(cells + i));
+
+    __m128i bits = _mm_castpd_si128(x);
+    __m128d e = _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(_mm_srli_epi64(bits, 52), magic_bits)),
+        _mm_set1_pd(EXP_BIAS_MAGIC));
+    __m128d m = _mm_castsi128_pd(_mm_or_si128(_mm_and_si128(bits, mantissa_mask), one_bits));
+    __m128d big = _mm_cmpgt_pd(m, _mm_set1_pd(SQRT2));
+    m = _mm_or_pd(_mm_and_pd(big, _mm_mul_pd(m, _mm_set1_pd(0.5))), _mm_andnot_pd(big, m));
+    e = _mm_add_pd(e, _mm_and_pd(big, one));
+
+    __m128d t = _mm_div_pd(_mm_sub_pd(m, one), _mm_add_pd(m, one));
+    __m128d t2 = _mm_mul_pd(t, t);
+    __m128d p = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(LOG2_C9), t2), _mm_set1_pd(LOG2_C7));
+    p = _mm_add_pd(_mm_mul_pd(p, t2), _mm_set1_pd(LOG2_C5));
+    p = _mm_add_pd(_mm_mul_pd(p, t2), _mm_set1_pd(LOG2_C3));
+    p = _mm_add_pd(_mm_mul_pd(p, t2), _mm_set1_pd(LOG2_C1));
+    __m128d y = _mm_mul_pd(_mm_set1_pd(FILL_EXP), _mm_add_pd(e, _mm_mul_pd(p, t)));
+
+    // floor without sse4.1, y is small enough for int32
+    __m128i n_int = _mm_cvttpd_epi32(y);
+    __m128d n = _mm_cvtepi32_pd(n_int);
+    __m128d above = _mm_cmpgt_pd(n, y);
+    n = _mm_sub_pd(n, _mm_and_pd(above, one));
+    n_int = _mm_cvttpd_epi32(n);
+
+    __m128d z = _mm_mul_pd(_mm_sub_pd(_mm_sub_pd(y, n), _mm_set1_pd(0.5)), _mm_set1_pd(LN2));
+    __m128d q = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(EXP_C7), z), _mm_set1_pd(EXP_C6));
+    q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(EXP_C5));
+    q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(EXP_C4));
+    q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(EXP_C3));
+    q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(EXP_C2));
+    q = _mm_add_pd(_mm_mul_pd(q, z), one);
+    q = _mm_add_pd(_mm_mul_pd(q, z), one);
+
+    __m128i biased = _mm_add_epi32(n_int, _mm_set1_epi32(1023));
+    __m128d scale = _mm_castsi128_pd(_mm_slli_epi64(_mm_unpacklo_epi32(biased, _mm_setzero_si128()), 52));
+    __m128d power = _mm_mul_pd(_mm_mul_pd(q, _mm_set1_pd(SQRT2)), scale);
+    power = _mm_andnot_pd(_mm_cmpeq_pd(used, zero), power);
+
+    __m128d fill_rate = _mm_mul_pd(power, _mm_loadu_pd(crossings + i));
+    fill_rate = _mm_min_pd(fill_rate, _mm_set1_pd(MAX_FILL));
+    _mm_storeu_pd(costs + i, _mm_div_pd(_mm_loadu_pd(perimeters + i), _mm_sub_pd(one, fill_rate)));
+  }
+
+  computeCostScalar(num - i, perimeters + i, cells + i, used_cells + i, crossings + i, costs + i);
+}
+
+__attribute__((target("avx2")))
+static void computeCostAVX2(size_t num, const double* perimeters, const double* cells,
+    const double* used_cells, const double* crossings, double* costs) {
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256i mantissa_mask = _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL);
+  const __m256i one_bits = _mm256_set1_epi64x(0x3FF0000000000000LL);
+  const __m256i magic_bits = _mm256_set1_epi64x(0x4330000000000000LL);
+
+  size_t i = 0;
+  for (; i + 4 <= num; i += 4) {
+    __m256d used = _mm256_loadu_pd(used_cells + i);
+    __m256d x = _mm256_div_pd(used, _mm256_loadu_pd(cells + i));
+
+    __m256i bits = _mm256_castpd_si256(x);
+    __m256d e = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52), magic_bits)),
+        _mm256_set1_pd(EXP_BIAS_MAGIC));
+    __m256d m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, mantissa_mask), one_bits));
+    __m256d big = _mm256_cmp_pd(m, _mm256_set1_pd(SQRT2), _CMP_GT_OQ);
+    m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), big);
+    e = _mm256_add_pd(e, _mm256_and_pd(big, one));
+
+    __m256d t = _mm256_div_pd(_mm256_sub_pd(m, one), _mm256_add_pd(m, one));
+    __m256d t2 = _mm256_mul_pd(t, t);
+    __m256d p = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(LOG2_C9), t2), _mm256_set1_pd(LOG2_C7));
+    p = _mm256_add_pd(_mm256_mul_pd(p, t2), _mm256_set1_pd(LOG2_C5));
+    p = _mm256_add_pd(_mm256_mul_pd(p, t2), _mm256_set1_pd(LOG2_C3));
+    p = _mm256_add_pd(_mm256_mul_pd(p, t2), _mm256_set1_pd(LOG2_C1));
+    __m256d y = _mm256_mul_pd(_mm256_set1_pd(FILL_EXP), _mm256_add_pd(e, _mm256_mul_pd(p, t)));
+
+    __m256d n = _mm256_floor_pd(y);
+    __m256d z = _mm256_mul_pd(_mm256_sub_pd(_mm256_sub_pd(y, n), _mm256_set1_pd(0.5)), _mm256_set1_pd(LN2));
+    __m256d q = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(EXP_C7), z), _mm256_set1_pd(EXP_C6));
+    q = _mm256_add_pd(_mm256_mul_pd(q, z), _mm256_set1_pd(EXP_C5));
+    q = _mm256_add_pd(_mm256_mul_pd(q, z), _mm256_set1_pd(EXP_C4));
+    q = _mm256_add_pd(_mm256_mul_pd(q, z), _mm256_set1_pd(EXP_C3));
+    q = _mm256_add_pd(_mm256_mul_pd(q, z), _mm256_set1_pd(EXP_C2));
+    q = _mm256_add_pd(_mm256_mul_pd(q, z), one);
+    q = _mm256_add_pd(_mm256_mul_pd(q, z), one);
+
+    __m128i biased = _mm_add_epi32(_mm256_cvttpd_epi32(n), _mm_set1_epi32(1023));
+    __m256d scale = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_cvtepu32_epi64(biased), 52));
+    __m256d power = _mm256_mul_pd(_mm256_mul_pd(q, _mm256_set1_pd(SQRT2)), scale);
+    power = _mm256_andnot_pd(_mm256_cmp_pd(used, zero, _CMP_EQ_OQ), power);
 
-  BoundingBox current_bb = wire->getCurrentBoundingBox();
-  Box bbox = current_bb.getBoundBox();
-  //Box ebox = current_bb.getEdgeBox();
+    __m256d fill_rate = _mm256_mul_pd(power, _mm256_loadu_pd(crossings + i));
+    fill_rate = _mm256_min_pd(fill_rate, _mm256_set1_pd(MAX_FILL));
+    _mm256_storeu_pd(costs + i, _mm256_div_pd(_mm256_loadu_pd(perimeters + i), _mm256_sub_pd(one, fill_rate)));
+  }
+
+  // the rest of the program is not vex encoded, leave the upper halves clean
+  _mm256_zeroupper();
+  computeCostScalar(num - i, perimeters + i, cells + i, used_cells + i, crossings + i, costs + i);
+}
+
+#endif
+
+
+void PlaceCostBatch::clear() {
+  _perimeters.clear();
+  _cells.clear();
+  _used_cells.clear();
+  _crossings.clear();
+  _costs.clear();
+}
+
+void PlaceCostBatch::addWire(unsigned pin_num, const Box& bbox, unsigned used_cell) {
+  //this is a model wire that connects only to the top module port, its cost is 0
+  if (pin_num <= 1) {
+    _perimeters.push_back(0.0);
+    _cells.push_back(1.0);
+    _used_cells.push_back(0.0);
+    _crossings.push_back(0.0);
+    return;
+  }
 
   unsigned width = bbox.xr() - bbox.xl() + 1;
   unsigned hight = bbox.yb() - bbox.yt() + 1;
 
-  unsigned number_of_cell = width * hight;
+  _perimeters.push_back(double(width + hight));
+  _cells.push_back(double(width * hight));
+  _used_cells.push_back(double(used_cell));
+  _crossings.push_back(crossingFactor(pin_num));
+}
+
+
+CongestionAwareCost::CongestionAwareCost(bool scalar) :
+  _scalar(scalar),
+  _kernel(computeCostScalar) {
+
+#ifdef QPAR_COST_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    _kernel = computeCostAVX2;
+  else
+    _kernel = computeCostSSE2;
+#endif
+}
+
+double CongestionAwareCost::computeCost(const ParPlaceDB& place_db, unsigned wire,
+    const ParOccupancy& occupancy) const {
+
+  //this is a model wire that connects only to the top module port
+  unsigned pin_num = place_db.getPinNum(wire);
+  if (pin_num <= 1) return 0.0;
+
+  const Box& bbox = place_db.getBox(wire);
 
   unsigned xl = bbox.xl();
   unsigned yt = bbox.yt();
@@ -62,26 +317,52 @@ double CongestionAwareCost::computeCost(ParWire* wire, const qpr_matrix<unsigned
   unsigned xr = bbox.xr();
   unsigned yb = bbox.yb();
 
-  unsigned used_cell = used_matrix.cell(xr, yb) +
-                       ((xl == 0 || yt == 0) ? 0 : used_matrix.cell(xl - 1, yt - 1)) -
-                       ((xl == 0) ? 0 : used_matrix.cell(xl - 1, yb)) -
-                       ((yt == 0) ? 0 : used_matrix.cell(xr, yt - 1));
+  unsigned used_cell = occupancy.getUsedCell(xl, yt, xr, yb);
 
-  double fill_rate = double(used_cell)/double(number_of_cell);
-  QASSERT(fill_rate <= 1.0);
+  return computeCost(pin_num, bbox, used_cell);
+
+}
 
-  fill_rate = std::pow(fill_rate, 1.3);
-  unsigned number_of_ele = (unsigned)wire->getElementNumber();
+double CongestionAwareCost::computeCost(unsigned pin_num, const Box& bbox, unsigned used_cell) const {
 
-  if (number_of_ele <= 49)
-    fill_rate = fill_rate * PlacementCost::cross_count[number_of_ele];
-  else
-    fill_rate = fill_rate * static_cast<float>(2.7933 + 0.02616 * (number_of_ele - 50));
+  //this is a model wire that connects only to the top module port
+  if (pin_num <= 1) return 0.0;
+
+  unsigned width = bbox.xr() - bbox.xl() + 1;
+  unsigned hight = bbox.yb() - bbox.yt() + 1;
+
+  unsigned number_of_cell = width * hight;
+
+  if (_scalar)
+    return exactCost(double(width + hight), double(number_of_cell), double(used_cell), crossingFactor(pin_num));
+
+  QASSERT(used_cell <= number_of_cell);
+  return fastCost(double(width + hight), double(number_of_cell), double(used_cell), crossingFactor(pin_num));
+
+}
 
-  fill_rate = std::min(fill_rate, 0.95);
+void CongestionAwareCost::computeCost(PlaceCostBatch& batch) const {
+  size_t num = batch._perimeters.size();
+  batch._costs.resize(num);
+  if (num == 0)
+    return;
 
-  double cost = (width + hight)/(1-fill_rate);
+  if (_scalar) {
+    for (size_t i = 0; i < num; ++i)
+      batch._costs[i] = exactCost(batch._perimeters[i], batch._cells[i],
+          batch._used_cells[i], batch._crossings[i]);
+    return;
+  }
 
-  return cost;
+  _kernel(num, batch._perimeters.data(), batch._cells.data(), batch._used_cells.data(),
+      batch._crossings.data(), batch._costs.data());
 
+#ifdef SANITY_CHECK
+  for (size_t i = 0; i < num; ++i) {
+    double cost = fastCost(batch._perimeters[i], batch._cells[i], batch._used_cells[i], batch._crossings[i]);
+    double exact = exactCost(batch._perimeters[i], batch._cells[i], batch._used_cells[i], batch._crossings[i]);
+    QASSERT(cost == batch._costs[i]);
+    QASSERT(std::fabs(cost - exact) <= 1e-6 * exact);
+  }
+#endif
 }
@@ -0,0 +1,314 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+/*!
+ * \file qpar_place_db.cc
+ * \author Juexiao Su
+ * \date 26 Feb 2018
+ * \brief compact placement state indexed by element and wire
+ */
+
+#include "qpar/qpar_place_db.hh"
+#include "qpar/qpar_netlist.hh"
+#include "qpar/qpar_target.hh"
+
+#include "utils/qlog.hh"
+
+#include <algorithm>
+#include <limits>
+
+
+ParPlaceDB::ParPlaceDB(ParNetlist* netlist, ParTarget* target) :
+  _target(target),
+  _x_limit(target->getXLimit()),
+  _y_limit(target->getYLimit()) {
+
+  unsigned max_element_id = 0;
+  ELE_ITER ele_iter = netlist->element_begin();
+  for (; ele_iter != netlist->element_end(); ++ele_iter) {
+    _elements.push_back(*ele_iter);
+    max_element_id = std::max(max_element_id, (*ele_iter)->getUniqId());
+  }
+  _element_index.assign(max_element_id + 1, std::numeric_limits<unsigned>::max());
+  for (unsigned i = 0; i < _elements.size(); ++i)
+    _element_index[_elements[i]->getUniqId()] = i;
+
+  // wires in uniq id order, the total cost is summed in the same order as the netlist
+  unsigned max_wire_id = 0;
+  WIRE_ITER w_iter = netlist->wire_begin();
+  for (; w_iter != netlist->wire_end(); ++w_iter) {
+    _wires.push_back(*w_iter);
+    max_wire_id = std::max(max_wire_id, (*w_iter)->getUniqId());
+  }
+  std::vector<unsigned> wire_index(max_wire_id + 1, std::numeric_limits<unsigned>::max());
+  for (unsigned i = 0; i < _wires.size(); ++i)
+    wire_index[_wires[i]->getUniqId()] = i;
+
+  _wire_pin_start.push_back(0);
+  for (unsigned i = 0; i < _wires.size(); ++i) {
+    ELE_ITER e_iter = _wires[i]->element_begin();
+    for (; e_iter != _wires[i]->element_end(); ++e_iter)
+      _wire_pins.push_back(getElementIndex(*e_iter));
+    _wire_pin_start.push_back((unsigned)_wire_pins.size());
+  }
+
+  // a wire can show up twice on an element, keep the first one
+  _element_wire_start.push_back(0);
+  for (unsigned i = 0; i < _elements.size(); ++i) {
+    unsigned begin = (unsigned)_element_wires.size();
+    WIRE_ITER_V e_w_iter = _elements[i]->begin();
+    for (; e_w_iter != _elements[i]->end(); ++e_w_iter) {
+      unsigned wire = wire_index[(*e_w_iter)->getUniqId()];
+      QASSERT(wire < _wires.size());
+      if (std::find(_element_wires.begin() + begin, _element_wires.end(), wire) == _element_wires.end())
+        _element_wires.push_back(wire);
+    }
+    _element_wire_start.push_back((unsigned)_element_wires.size());
+  }
+
+  _x.resize(_elements.size());
+  _y.resize(_elements.size());
+  _movable.resize(_elements.size());
+  _grid_element.assign((size_t)(_x_limit * _y_limit), -1);
+  for (unsigned i = 0; i < _elements.size(); ++i) {
+    ParGrid* grid = _elements[i]->getCurrentGrid();
+    QASSERT(grid && grid->getCurrentElement() == _elements[i]);
+    placeElement(i, grid->getLoc().getLocX(), grid->getLoc().getLocY());
+    _movable[i] = _elements[i]->isMovable();
+  }
+
+  _boxes.resize(_wires.size());
+  for (unsigned i = 0; i < _wires.size(); ++i)
+    initializeBoundingBox(i);
+  _costs.assign(_wires.size(), 0.0);
+  _move_stamps.assign(_wires.size(), 0);
+}
+
+unsigned ParPlaceDB::getElementIndex(const ParElement* element) const {
+  QASSERT(element->getUniqId() < _element_index.size());
+  unsigned index = _element_index[element->getUniqId()];
+  QASSERT(index < _elements.size());
+  return index;
+}
+
+bool ParPlaceDB::hasWire(unsigned element, unsigned wire) const {
+  return std::find(wire_begin(element), wire_end(element), wire) != wire_end(element);
+}
+
+void ParPlaceDB::copyPlacement(const ParPlaceDB& db) {
+  QASSERT(db.getElementNum() == getElementNum() && db.getWireNum() == getWireNum());
+  QASSERT(db._x_limit == _x_limit && db._y_limit == _y_limit);
+
+  // both databases are built from the same model, so indices match
+  _x = db._x;
+  _y = db._y;
+  _grid_element = db._grid_element;
+  _boxes = db._boxes;
+  _costs = db._costs;
+}
+
+void ParPlaceDB::storePlacement() {
+  for (unsigned i = 0; i < _elements.size(); ++i) {
+    ParGrid* grid = _elements[i]->getCurrentGrid();
+    grid->setParElement(NULL);
+    grid->save();
+  }
+
+  for (unsigned i = 0; i < _elements.size(); ++i) {
+    ParGrid* grid = _target->getGrid(getX(i), getY(i));
+    QASSERT(grid && grid->getCurrentElement() == NULL);
+    _elements[i]->setGrid(grid);
+    _elements[i]->save();
+    grid->setParElement(_elements[i]);
+    grid->save();
+  }
+
+  for (unsigned i = 0; i < _wires.size(); ++i) {
+    _wires[i]->initializeBoundingBox();
+    _wires[i]->setCost(_costs[i]);
+    _wires[i]->saveCost();
+  }
+}
+
+void ParPlaceDB::updateBoundingBox(unsigned wire, COORD from_x, COORD from_y, COORD to_x, COORD to_y) {
+  if (incrementBoundingBox(_boxes[wire], from_x, from_y, to_x, to_y))
+    initializeBoundingBox(wire);
+}
+
+BoundingBox ParPlaceDB::predictBoundingBox(unsigned wire, COORD from_x, COORD from_y,
+    COORD to_x, COORD to_y, unsigned element, int swapped) const {
+  BoundingBox box = _boxes[wire];
+  if (incrementBoundingBox(box, from_x, from_y, to_x, to_y))
+    box = computeBoundingBox(wire, (int)element, to_x, to_y, swapped, from_x, from_y);
+  return box;
+}
+
+BoundingBox ParPlaceDB::computeBoundingBox(unsigned wire, int ele1, COORD x1, COORD y1,
+    int ele2, COORD x2, COORD y2) const {
+
+  int xl = std::numeric_limits<int>::max();
+  int xr = -1;
+  int yt = std::numeric_limits<int>::max();
+  int yb = -1;
+
+  int xle = 0;
+  int xre = 0;
+  int yte = 0;
+  int ybe = 0;
+
+  for (const unsigned* p_iter = pin_begin(wire); p_iter != pin_end(wire); ++p_iter) {
+    int ele = (int)*p_iter;
+    int coordX;
+    int coordY;
+    if (ele == ele1) {
+      coordX = (int)x1;
+      coordY = (int)y1;
+    } else if (ele == ele2) {
+      coordX = (int)x2;
+      coordY = (int)y2;
+    } else {
+      coordX = _x[ele];
+      coordY = _y[ele];
+    }
+
+    if (coordX < xl) {
+      xl = coordX;
+      xle = 1;
+    } else if (coordX == xl) {
+      ++xle;
+    }
+
+    if (coordX > xr) {
+      xr = coordX;
+      xre = 1;
+    } else if (coordX == xr) {
+      ++xre;
+    }
+
+    if (coordY > yb) {
+      yb = coordY;
+      ybe = 1;
+    } else if (coordY == yb) {
+      ++ybe;
+    }
+
+    if (coordY < yt) {
+      yt = coordY;
+      yte = 1;
+    } else if (coordY == yt) {
+      ++yte;
+    }
+  }
+
+  return BoundingBox(Box(xl, xr, yt, yb), Box(xle, xre, yte, ybe));
+}
+
+bool ParPlaceDB::incrementBoundingBox(BoundingBox& box, COORD from_x, COORD from_y, COORD to_x, COORD to_y) {
+  Box& bbox = box.getBoundBox();
+  Box& ebox = box.getEdgeBox();
+  bool recal = false ;
+
+  if (to_x < bbox.xl()) {
+    bbox.set_xl((int)to_x) ;
+    ebox.set_xl(1) ;
+  } else if (to_x == bbox.xl()) {
+    ebox.incr_xl() ;
+    if (from_x == bbox.xl())
+      ebox.decr_xl() ;
+  } else if (from_x == bbox.xl()) {
+    if (ebox.xl() > 1)
+      ebox.decr_xl() ;
+    else
+      recal = true ;
+  }
+
+  if (to_x > bbox.xr()) {
+    bbox.set_xr((int)to_x) ;
+    ebox.set_xr(1) ;
+  } else if (to_x == bbox.xr()) {
+    ebox.incr_xr() ;
+    if (from_x == bbox.xr())
+      ebox.decr_xr() ;
+  } else if (from_x == bbox.xr()) {
+    if (ebox.xr() > 1)
+      ebox.decr_xr() ;
+    else
+      recal = true ;
+  }
+
+  if (to_y < bbox.yt()) {
+    bbox.set_yt((int)to_y) ;
+    ebox.set_yt(1) ;
+  } else if (to_y == bbox.yt()) {
+    ebox.incr_yt() ;
+    if (from_y == bbox.yt())
+      ebox.decr_yt() ;
+  } else if (from_y == bbox.yt()) {
+    if (ebox.yt() > 1)
+      ebox.decr_yt() ;
+    else
+      recal = true ;
+  }
+
+  if (to_y > bbox.yb()) {
+    bbox.set_yb((int)to_y) ;
+    ebox.set_yb(1) ;
+  } else if (to_y == bbox.yb()) {
+    ebox.incr_yb() ;
+    if (from_y == bbox.yb())
+      ebox.decr_yb() ;
+  } else if (from_y == bbox.yb()) {
+    if (ebox.yb() > 1)
+      ebox.decr_yb() ;
+    else
+      recal = true ;
+  }
+
+  return recal;
+}
+
+bool ParPlaceDB::sanityCheck() const {
+  for (unsigned i = 0; i < _elements.size(); ++i) {
+    if (getGridElement(getX(i), getY(i)) != (int)i) {
+      qlog.speak("Place", "Sanity Checking Element: %s is not on its grid", _elements[i]->getName().c_str());
+      return false;
+    }
+  }
+
+  unsigned used_grid = 0;
+  for (size_t i = 0; i < _grid_element.size(); ++i)
+    if (_grid_element[i] >= 0)
+      ++used_grid;
+  if (used_grid != _elements.size()) {
+    qlog.speak("Place", "Sanity Checking Grid: %u grids are used by %u elements",
+        used_grid, (unsigned)_elements.size());
+    return false;
+  }
+
+  for (unsigned i = 0; i < _wires.size(); ++i) {
+    BoundingBox box = computeBoundingBox(i, -1, 0, 0, -1, 0, 0);
+    if (!(box.getBoundBox() == getBox(i))) {
+      qlog.speak("Place", "Sanity Checking Net: %s bounding box is not equal to incr",
+          _wires[i]->getName().c_str());
+      return false;
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,145 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+/*!
+ * \file qpar_place_timing.cc
+ * \author Juexiao Su
+ * \date 02 Mar 2018
+ * \brief wire criticality from estimated chain lengths for timing driven placement
+ */
+
+#include "qpar/qpar_place_timing.hh"
+#include "qpar/qpar_place_db.hh"
+#include "qpar/qpar_netlist.hh"
+
+#include "syn/netlist.h"
+#include "utils/qlog.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+// exponent on the criticality, only wires close to the critical path get weight
+static const double CRIT_EXP = 4.0;
+
+
+ParPlaceTiming::ParPlaceTiming(const ParPlaceDB* place_db, SYN::Model* model, double weight) :
+  _place_db(place_db),
+  _weight(weight),
+  _max_depth(0),
+  _critical_path(0.0) {
+
+  QASSERT(place_db && model);
+  unsigned wire_num = place_db->getWireNum();
+
+  std::unordered_map<SYN::Net*, unsigned> net_to_wire;
+  for (unsigned i = 0; i < wire_num; ++i)
+    net_to_wire.insert(std::make_pair(place_db->getWire(i)->getSynNet(), i));
+
+  // a wire is ready when the output pin driving it is reached
+  std::vector<SYN::Pin*> pins;
+  model->topoOrder(pins);
+  std::vector<bool> ordered(wire_num, false);
+  for (size_t i = 0; i < pins.size(); ++i) {
+    if (!pins[i]->isOutpin() || pins[i]->net() == NULL)
+      continue;
+    std::unordered_map<SYN::Net*, unsigned>::const_iterator w_iter = net_to_wire.find(pins[i]->net());
+    if (w_iter == net_to_wire.end() || ordered[w_iter->second])
+      continue;
+    ordered[w_iter->second] = true;
+    _order.push_back(w_iter->second);
+  }
+
+  // wires of a cycle are not in the order, they only get the arrival of the fanins seen before
+  unsigned missing = 0;
+  for (unsigned i = 0; i < wire_num; ++i) {
+    if (!ordered[i]) {
+      _order.push_back(i);
+      ++missing;
+    }
+  }
+  if (missing)
+    qlog.speak("Place", "%u wires are not in topological order", missing);
+
+  _fanin_start.push_back(0);
+  for (unsigned i = 0; i < wire_num; ++i) {
+    unsigned begin = (unsigned)_fanins.size();
+    SYN::Pin* source = place_db->getWire(i)->getSynNet()->uniqSource();
+    if (source && source->isGatePin()) {
+      SYN::Gate* gate = source->getGate();
+      SYN::Element::PIN_ITER p_iter = gate->begin();
+      for (; p_iter != gate->end(); ++p_iter) {
+        if (!(*p_iter)->isInpin() || (*p_iter)->net() == NULL)
+          continue;
+        std::unordered_map<SYN::Net*, unsigned>::const_iterator w_iter = net_to_wire.find((*p_iter)->net());
+        if (w_iter == net_to_wire.end() || w_iter->second == i)
+          continue;
+        if (std::find(_fanins.begin() + begin, _fanins.end(), w_iter->second) == _fanins.end())
+          _fanins.push_back(w_iter->second);
+      }
+    }
+    _fanin_start.push_back((unsigned)_fanins.size());
+  }
+
+  std::vector<unsigned> depths(wire_num, 0);
+  for (size_t i = 0; i < _order.size(); ++i) {
+    unsigned wire = _order[i];
+    unsigned depth = 0;
+    for (unsigned j = _fanin_start[wire]; j < _fanin_start[wire + 1]; ++j)
+      depth = std::max(depth, depths[_fanins[j]]);
+    depths[wire] = depth + 1;
+    _max_depth = std::max(_max_depth, depth + 1);
+  }
+
+  _arrivals.assign(wire_num, 0.0);
+  _requireds.assign(wire_num, 0.0);
+  _criticalities.assign(wire_num, 0.0);
+  _weights.assign(wire_num, 1.0);
+}
+
+double ParPlaceTiming::getDelay(unsigned wire) const {
+  const Box& bbox = _place_db->getBox(wire);
+  return (double)(bbox.xr() - bbox.xl() + bbox.yb() - bbox.yt() + 1);
+}
+
+void ParPlaceTiming::update() {
+  _critical_path = 0.0;
+  for (size_t i = 0; i < _order.size(); ++i) {
+    unsigned wire = _order[i];
+    double arrival = 0.0;
+    for (unsigned j = _fanin_start[wire]; j < _fanin_start[wire + 1]; ++j)
+      arrival = std::max(arrival, _arrivals[_fanins[j]] + getDelay(_fanins[j]));
+    _arrivals[wire] = arrival;
+    _critical_path = std::max(_critical_path, arrival + getDelay(wire));
+  }
+
+  // fanouts come later in the order, so the required time at the sinks is final when a wire is visited
+  _requireds.assign(_requireds.size(), _critical_path);
+  for (size_t i = _order.size(); i > 0; --i) {
+    unsigned wire = _order[i - 1];
+    double required = _requireds[wire] - getDelay(wire);
+    for (unsigned j = _fanin_start[wire]; j < _fanin_start[wire + 1]; ++j)
+      _requireds[_fanins[j]] = std::min(_requireds[_fanins[j]], required);
+
+    double criticality = 1.0 - (required - _arrivals[wire]) / _critical_path;
+    criticality = std::max(0.0, std::min(criticality, 1.0));
+    _criticalities[wire] = criticality;
+    _weights[wire] = 1.0 + _weight * std::pow(criticality, CRIT_EXP);
+  }
+}
@@ -20,19 +20,42 @@
 
 #include "qpar/qpar_route.hh"
 #include "qpar/qpar_router.hh"
+#include "qpar/qpar_route_overflow.hh"
 #include "qpar/qpar_netlist.hh"
 #include "qpar/qpar_routing_graph.hh"
 #include "qpar/qpar_routing_cost.hh"
+#include "qpar/qpar_target.hh"
+#include "qpar/qpar_thread_pool.hh"
 #include "syn/netlist.h"
 #include "utils/qlog.hh"
 
 #include <algorithm>
 #include <fstream>
+#include <functional>
+#include <limits>
 #include <sstream>
+#include <unordered_map>
+
+
+//! cells around the pins and routes of a wire that parallel routing can use
+static const int route_region_margin = 2;
+
+//! factor a target window margin grows by when no route is found inside
+static const int window_growth = 2;
+
+/*! \brief check if two regions share a cell
+ */
+static bool isRegionOverlap(const Box& box1, const Box& box2) {
+  return box1.xl() <= box2.xr() && box2.xl() <= box1.xr() &&
+    box1.yt() <= box2.yb() && box2.yt() <= box1.yb();
+}
 
 
 FastRoutingGraph::FastRoutingGraph(RoutingGraph* graph) :
-SUPER(graph->getNodeNum(), graph->getEdgeNum()){
+SUPER(graph->getNodeNum(), graph->getEdgeNum()),
+_states(graph->getNodeStates()),
+_max_x(0),
+_max_y(0) {
   NODES::iterator n_iter = graph->node_begin();
   for (; n_iter != graph->node_end(); ++n_iter) {
     RoutingNode* node = *n_iter;
@@ -48,6 +71,29 @@ SUPER(graph->getNodeNum(), graph->getEdgeNum()){
     add_edge(edge, node1, node2);
   }
 
+  // vertices are added in node order, so a vertex is also the index of its node state
+  _adj_start.push_back(0);
+  for (qvertex v = 0; v < (qvertex)get_vertex_num(); ++v) {
+    QASSERT(get_e_vertex(v)->getGraphIndex() == (unsigned)v);
+    std::pair<vertex2edge::edge_iter, vertex2edge::edge_iter> edge_iter_pair = get_edges(v);
+    vertex2edge::edge_iter e_iter = edge_iter_pair.first;
+    for (; e_iter != edge_iter_pair.second; ++e_iter) {
+      _adj_vertex.push_back(get_other_vertex(*e_iter, v));
+      _adj_edge.push_back(*e_iter);
+    }
+    _adj_start.push_back((unsigned)_adj_vertex.size());
+  }
+
+  _vertex_x.resize(get_vertex_num());
+  _vertex_y.resize(get_vertex_num());
+  for (qvertex v = 0; v < (qvertex)get_vertex_num(); ++v) {
+    RoutingCell* cell = get_e_vertex(v)->getRoutingCell();
+    QASSERT(cell);
+    _vertex_x[v] = (int)cell->getGrid()->getLoc().getLocX();
+    _vertex_y[v] = (int)cell->getGrid()->getLoc().getLocY();
+    _max_x = std::max(_max_x, _vertex_x[v]);
+    _max_y = std::max(_max_y, _vertex_y[v]);
+  }
 
 }
 
@@ -76,10 +122,24 @@ QRoute::~QRoute() {
   if (_first_router) delete _first_router;
   _first_router = NULL;
 
+  for (size_t i = 0; i < _thread_routers.size(); ++i)
+    delete _thread_routers[i];
+  _thread_routers.clear();
+
+  for (size_t i = 0; i < _thread_first_routers.size(); ++i)
+    delete _thread_first_routers[i];
+  _thread_first_routers.clear();
+
+  if (_thread_pool) delete _thread_pool;
+  _thread_pool = NULL;
+
+  if (_overflow) delete _overflow;
+  _overflow = NULL;
+
 }
 
 
-void QRoute::run() {
+bool QRoute::run() {
 
   qlog.speak("Route", "Initialize routing...");
   initializeRouting();
@@ -103,7 +163,7 @@ void QRoute::run() {
     routeAllTarget(targets, N);
   
     unsigned overflow;
-    bool valid = isRoutingValid(targets, overflow);
+    bool valid = isRoutingValid(overflow);
     //updateWireSlack();
 
     if (valid) {
@@ -124,72 +184,57 @@ void QRoute::run() {
   }
   qlog.speak("ROUTE", " +----------+----------------+----------+-------------+-----------------+-------------+");
 
-  if (!routing_suc)
-    qlog.speakError("Routing Failed");
-
-  qlog.speak("ROUTE", " successfully route netlist");
+  if (routing_suc)
+    qlog.speak("ROUTE", " successfully route netlist");
 
+  return routing_suc;
 }
 
 
 bool QRoute::isTargetOverFlow(ParWireTarget* target) {
 
   if (target->getDontRoute()) return false;
-  
-  RoutePath* path = target->getRoutePath();
 
-  for (size_t i = 0; i < path->size(); ++i) {
-    RoutingNode* node = path->at(i);
-    if (node->isOverFlow())
-      return true;
-  }
-
-  return false;
+  return _overflow->isTargetOverFlow(target);
 
 }
 
-bool QRoute::isRoutingValid(std::vector<ParWireTarget*>& targets, unsigned& overflow) {
-
-  //1) first method iterator all targets;
-  std::set<RoutingNode*> invalid_nodes1;
-  for (size_t i = 0; i < targets.size(); ++i) {
-    ParWireTarget* target = targets[i];
-
-    if (target->getDontRoute()) continue;
-
-    RoutePath* path = target->getRoutePath();
+bool QRoute::isRoutingValid(unsigned& overflow) {
 
-    for (size_t i = 0; i < path->size(); ++i) {
-      RoutingNode* node = path->at(i);
-      if (node->isOverFlow()) {
-        if (!invalid_nodes1.count(node))
-          node->setHistoryCost(3 + node->getHistoryCost());
-        invalid_nodes1.insert(node);
-      }
-    }
-  }
+#ifdef SANITY_CHECK
+  std::vector<ParWireTarget*>& targets = _netlist->getTargets();
+  QASSERT(_overflow->sanityCheck(_rr_graph, targets));
+#endif
 
-  std::set<RoutingNode*> invalid_nodes2;
-  NODES::iterator node_iter = _rr_graph->node_begin();
-  for (; node_iter != _rr_graph->node_end(); ++node_iter) {
-    RoutingNode* node = *node_iter;
-    if (node->isOverFlow())
-      invalid_nodes2.insert(node);
+  const std::vector<RoutingNode*>& overflow_nodes = _overflow->getOverFlowNodes();
+  for (size_t i = 0; i < overflow_nodes.size(); ++i) {
+    RoutingNode* node = overflow_nodes[i];
+    node->setHistoryCost(3 + node->getHistoryCost());
   }
 
-  QASSERT(invalid_nodes2.size() == invalid_nodes1.size());
-
-  overflow = (unsigned)invalid_nodes1.size();
+  overflow = (unsigned)overflow_nodes.size();
   return (overflow == 0);
 }
 
 void QRoute::initializeRouting() {
 
   _cost = new RoutingCostNBR();
-  _router = new ParRouter(*_f_graph, *_cost);
+  _router = new ParRouter(*_f_graph, *_cost, _option.astar_fac, _option.bidir);
 
   _cost_simple = new RoutingCostSimple();
-  _first_router = new ParRouter(*_f_graph, *_cost_simple);
+  _first_router = new ParRouter(*_f_graph, *_cost_simple, _option.astar_fac, _option.bidir);
+
+  // routing costs are stateless, every thread owns its routers
+  if (_option.threads > 1) {
+    _thread_pool = new ParThreadPool(_option.threads);
+    for (unsigned i = 0; i < _option.threads; ++i) {
+      _thread_routers.push_back(new ParRouter(*_f_graph, *_cost, _option.astar_fac, _option.bidir));
+      _thread_first_routers.push_back(new ParRouter(*_f_graph, *_cost_simple, _option.astar_fac, _option.bidir));
+    }
+    qlog.speak("Route", "Route with %u threads", _option.threads);
+  }
+
+  _overflow = new ParRouteOverflow(_rr_graph, _netlist->getTargets());
 
   initializeWireSlack(); 
   RoutingNode::setCongestionCost(0.001);
@@ -211,23 +256,191 @@ void QRoute::routeAllTarget(std::vector<ParWireTarget*>& targets, unsigned iter)
   TargetSlackCmp cmp;
   std::sort(targets.begin(), targets.end(), cmp);
 
+  if (_thread_pool) {
+    routeAllTargetParallel(targets, iter);
+  } else if (_option.steiner) {
+    std::vector<ParWire*> wires;
+    std::unordered_map<ParWire*, std::vector<ParWireTarget*> > wire_targets;
+    groupTargetsByWire(targets, iter, wires, wire_targets);
+    for (size_t i = 0; i < wires.size(); ++i)
+      routeWire(wire_targets[wires[i]], router);
+  } else {
+    std::vector<ParWireTarget*>::iterator tgt_iter = targets.begin();
+    for (; tgt_iter != targets.end(); ++tgt_iter) {
+      ParWireTarget* tgt = *tgt_iter;
 
-  std::vector<ParWireTarget*>::iterator tgt_iter = targets.begin();
-  for (; tgt_iter != targets.end(); ++tgt_iter) {
-    ParWireTarget* tgt = *tgt_iter;
-
-    if (iter > 10 ) {
-      if (!isTargetOverFlow(tgt)) continue;
+      // incremental routing only rips up restored routes that overflow
+      if (iter > 10 || !_option.eco_file.empty()) {
+        if (tgt->getRoutePath() && !isTargetOverFlow(tgt)) continue;
+      }
+      //checkLoad();
+      routeTarget(tgt, router);
+      //checkLoad();
     }
-    //checkLoad();
-    routeTarget(tgt, router);
-    //checkLoad();
   }
 
   updateWireSlack();
   RoutingNode::setCongestionCost(RoutingNode::getCongestionCost() + 6);
 }
 
+void QRoute::routeAllTargetParallel(std::vector<ParWireTarget*>& targets, unsigned iter) {
+
+  std::vector<ParWire*> wires;
+  std::unordered_map<ParWire*, std::vector<ParWireTarget*> > wire_targets;
+  groupTargetsByWire(targets, iter, wires, wire_targets);
+
+  std::vector<Box> regions;
+  for (size_t i = 0; i < wires.size(); ++i)
+    regions.push_back(getWireRegion(wires[i]));
+
+  // wires in slack order join the first batch whose regions they do not overlap
+  _batch_first_iter = (iter == 1);
+  std::vector<std::vector<ParWireTarget*> > failed_targets;
+  size_t failed_num = 0;
+  std::vector<bool> routed(wires.size(), false);
+  size_t routed_num = 0;
+  unsigned batch_num = 0;
+  while (routed_num < wires.size()) {
+    _batch_wires.clear();
+    _batch_targets.clear();
+    _batch_regions.clear();
+
+    for (size_t i = 0; i < wires.size(); ++i) {
+      if (routed[i]) continue;
+
+      bool overlap = false;
+      for (size_t j = 0; j < _batch_regions.size() && !overlap; ++j)
+        overlap = isRegionOverlap(regions[i], _batch_regions[j]);
+      if (overlap) continue;
+
+      routed[i] = true;
+      ++routed_num;
+      _batch_wires.push_back(wires[i]);
+      _batch_targets.push_back(wire_targets[wires[i]]);
+      _batch_regions.push_back(regions[i]);
+    }
+
+    _batch_failed.assign(_batch_wires.size(), std::vector<ParWireTarget*>());
+    _thread_pool->run(std::bind(&QRoute::routeBatch, this, std::placeholders::_1));
+    ++batch_num;
+
+    for (size_t i = 0; i < _batch_failed.size(); ++i) {
+      if (_batch_failed[i].empty()) continue;
+      failed_targets.push_back(_batch_failed[i]);
+      failed_num += _batch_failed[i].size();
+    }
+  }
+
+  // targets without a route inside their region are routed on the whole graph
+  ParRouter* router = (iter == 1) ? _first_router : _router;
+  for (size_t i = 0; i < failed_targets.size(); ++i) {
+    if (_option.steiner) {
+      routeWire(failed_targets[i], router);
+    } else {
+      for (size_t j = 0; j < failed_targets[i].size(); ++j)
+        routeTarget(failed_targets[i][j], router);
+    }
+  }
+
+  qlog.speak("Route", "Iteration %u routed %lu wires in %u batches, %lu targets outside regions",
+      iter, wires.size(), batch_num, failed_num);
+}
+
+void QRoute::routeBatch(unsigned thread_id) {
+  // the log buffer is shared, threads would overwrite each other
+  qlog.setThreadQuiet(true);
+  unsigned thread_num = _thread_pool->getThreadNum();
+  ParRouter* router = _batch_first_iter ? _thread_first_routers[thread_id] : _thread_routers[thread_id];
+  for (size_t i = thread_id; i < _batch_wires.size(); i += thread_num) {
+    router->setWindow(_batch_regions[i]);
+    std::vector<ParWireTarget*>& wire_targets = _batch_targets[i];
+    if (_option.steiner) {
+      if (!tryRouteWire(wire_targets, router))
+        _batch_failed[i] = wire_targets;
+      continue;
+    }
+    for (size_t j = 0; j < wire_targets.size(); ++j) {
+      if (!tryRouteTarget(wire_targets[j], router))
+        _batch_failed[i].push_back(wire_targets[j]);
+    }
+  }
+  router->clearWindow();
+  qlog.setThreadQuiet(false);
+}
+
+void QRoute::groupTargetsByWire(std::vector<ParWireTarget*>& targets, unsigned iter,
+    std::vector<ParWire*>& wires, std::unordered_map<ParWire*, std::vector<ParWireTarget*> >& wire_targets) {
+
+  for (size_t i = 0; i < targets.size(); ++i) {
+    ParWireTarget* tgt = targets[i];
+    if (tgt->getDontRoute()) continue;
+
+    // incremental routing only rips up restored routes that overflow
+    if (iter > 10 || !_option.eco_file.empty()) {
+      if (tgt->getRoutePath() && !isTargetOverFlow(tgt)) continue;
+    }
+
+    ParWire* wire = tgt->getWire();
+    if (!wire_targets.count(wire))
+      wires.push_back(wire);
+    wire_targets[wire].push_back(tgt);
+  }
+
+  if (!_option.steiner) return;
+
+  for (size_t i = 0; i < wires.size(); ++i) {
+    std::vector<ParWireTarget*>& wire_tgts = wire_targets[wires[i]];
+    wire_tgts.clear();
+    std::vector<ParWireTarget*>& all_tgts = wires[i]->getTargets();
+    for (size_t j = 0; j < all_tgts.size(); ++j) {
+      if (!all_tgts[j]->getDontRoute())
+        wire_tgts.push_back(all_tgts[j]);
+    }
+  }
+}
+
+Box QRoute::getWireRegion(ParWire* wire) const {
+  int xl = std::numeric_limits<int>::max();
+  int xr = std::numeric_limits<int>::min();
+  int yt = std::numeric_limits<int>::max();
+  int yb = std::numeric_limits<int>::min();
+
+  ELE_ITER e_iter = wire->element_begin();
+  for (; e_iter != wire->element_end(); ++e_iter) {
+    const HW_Loc& loc = (*e_iter)->getCurrentGrid()->getLoc();
+    xl = std::min(xl, (int)loc.getLocX());
+    xr = std::max(xr, (int)loc.getLocX());
+    yt = std::min(yt, (int)loc.getLocY());
+    yb = std::max(yb, (int)loc.getLocY());
+  }
+
+  // current routes are ripped up, their nodes have to be inside the region too
+  std::unordered_set<RoutingNode*>& nodes = wire->getUsedRoutingNodes();
+  std::unordered_set<RoutingNode*>::iterator n_iter = nodes.begin();
+  for (; n_iter != nodes.end(); ++n_iter) {
+    const HW_Loc& loc = (*n_iter)->getRoutingCell()->getGrid()->getLoc();
+    xl = std::min(xl, (int)loc.getLocX());
+    xr = std::max(xr, (int)loc.getLocX());
+    yt = std::min(yt, (int)loc.getLocY());
+    yb = std::max(yb, (int)loc.getLocY());
+  }
+
+  return Box(xl - route_region_margin, xr + route_region_margin,
+      yt - route_region_margin, yb + route_region_margin);
+}
+
+Box QRoute::getTargetWindow(ParWireTarget* target, int margin) const {
+  HW_Loc src_loc = target->getSourceElement()->getCurrentGrid()->getLoc();
+  HW_Loc tgt_loc = target->getTargetElement()->getCurrentGrid()->getLoc();
+
+  int xl = std::min((int)src_loc.getLocX(), (int)tgt_loc.getLocX());
+  int xr = std::max((int)src_loc.getLocX(), (int)tgt_loc.getLocX());
+  int yt = std::min((int)src_loc.getLocY(), (int)tgt_loc.getLocY());
+  int yb = std::max((int)src_loc.getLocY(), (int)tgt_loc.getLocY());
+
+  return Box(xl - margin, xr + margin, yt - margin, yb + margin);
+}
+
 void QRoute::updateWireSlack() {
   double longest_length = 0;
   WIRE_ITER w_iter = _netlist->wire_begin();
@@ -251,7 +464,34 @@ void QRoute::routeTarget(ParWireTarget* target, ParRouter* router) {
 
   if (target->getDontRoute()) return;
 
-  target->ripupTarget();
+  // the window grows until a route is found or it covers the whole graph
+  if (_option.window >= 0) {
+    int margin = _option.window;
+    while (true) {
+      Box window = getTargetWindow(target, margin);
+      if (window.xl() <= 0 && window.xr() >= _f_graph->get_max_x() &&
+          window.yt() <= 0 && window.yb() >= _f_graph->get_max_y())
+        break;
+
+      router->setWindow(window);
+      bool found = tryRouteTarget(target, router);
+      router->clearWindow();
+      if (found) return;
+      margin = margin * window_growth + 1;
+    }
+  }
+
+  if (!tryRouteTarget(target, router)) {
+    qlog.speakError("Cannot find route for %s wire %s pin",
+        target->getWire()->getName().c_str(),
+        target->getName().c_str());
+  }
+
+}
+
+bool QRoute::tryRouteTarget(ParWireTarget* target, ParRouter* router) {
+
+  _overflow->ripupTarget(target);
   ParWire* wire = target->getWire();
 
   wire->markUsedRoutingResource();
@@ -272,16 +512,75 @@ void QRoute::routeTarget(ParWireTarget* target, ParRouter* router) {
 
   std::unordered_set<RoutingNode*> used = wire->getUsedRoutingNodes();
 
-  if (router->route(src_node, tgt_node, slack, used, target)) {
+  bool found = router->route(src_node, tgt_node, slack, used, target);
+  if (found) {
     updateRoute(target, slack, router);
   } else {
-    qlog.speakError("Cannot find route for %s wire %s pin",
-        wire->getName().c_str(),
-        target->getName().c_str());
+    // the old route is ripped up already
+    delete target->getRoutePath();
+    target->setRoutePath(NULL);
+  }
+
+  wire->unmarkUsedRoutingResource();
+
+  return found;
+}
+
+void QRoute::routeWire(std::vector<ParWireTarget*>& targets, ParRouter* router) {
+
+  if (!tryRouteWire(targets, router)) {
+    qlog.speakError("Cannot find route for %s wire",
+        targets.front()->getWire()->getName().c_str());
+  }
+
+}
+
+bool QRoute::tryRouteWire(std::vector<ParWireTarget*>& targets, ParRouter* router) {
+
+  ParWire* wire = targets.front()->getWire();
+  for (size_t i = 0; i < targets.size(); ++i) {
+    ParWireTarget* target = targets[i];
+    _overflow->ripupTarget(target);
+    delete target->getRoutePath();
+    target->setRoutePath(NULL);
+  }
+
+  double slack = wire->getSlack();
+
+  ParWireTarget* first = targets.front();
+  RoutingNode* src_node = _rr_graph->getRoutingNode(first->getSourceElement(), first->getSourcePin());
+  QASSERT(src_node);
+
+  std::vector<ParWireTarget*> remain_targets;
+  std::vector<RoutingNode*> sinks;
+  for (size_t i = 0; i < targets.size(); ++i) {
+    ParWireTarget* target = targets[i];
+    QASSERT(_rr_graph->getRoutingNode(target->getSourceElement(), target->getSourcePin()) == src_node);
+    RoutingNode* tgt_node = _rr_graph->getRoutingNode(target->getTargetElement(), target->getTargetPin());
+    QASSERT(tgt_node);
+    remain_targets.push_back(target);
+    sinks.push_back(tgt_node);
+  }
+
+  // every sink joins the tree at its closest node, its route is the tree
+  // path from the source to the sink
+  bool found = true;
+  router->beginTree(src_node);
+  while (!sinks.empty()) {
+    int sink = router->routeTree(sinks, slack, first);
+    if (sink < 0) {
+      found = false;
+      break;
+    }
+
+    updateRoute(remain_targets[sink], slack, router);
+    remain_targets.erase(remain_targets.begin() + sink);
+    sinks.erase(sinks.begin() + sink);
   }
 
   wire->unmarkUsedRoutingResource();
 
+  return found;
 }
 
 void QRoute::checkLoad() {
@@ -333,6 +632,7 @@ void QRoute::updateRoute(ParWireTarget* target, double& slack, ParRouter* router
   RoutePath* new_route = new RoutePath(nodes, edges);
   target->setRoutePath(new_route);
   target->getWire()->updateWireRoute(new_route);
+  _overflow->addRoute(target);
 }
 
 void QRoute::printAllRoute(std::string filename) {
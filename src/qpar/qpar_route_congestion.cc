@@ -0,0 +1,94 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+/*!
+ * \file qpar_route_congestion.cc
+ * \author Juexiao Su
+ * \date 07 Mar 2018
+ * \brief routing congestion of each grid, fed back to placement
+ */
+
+#include "qpar/qpar_route_congestion.hh"
+#include "qpar/qpar_routing_graph.hh"
+#include "qpar/qpar_utils.hh"
+#include "hw_target/hw_object.hh"
+
+#include "utils/qlog.hh"
+
+#include <algorithm>
+
+// extra weight of a wire whose bounding box only covers the most congested grids
+static const double route_congestion_weight = 1.0;
+
+
+ParRouteCongestion::ParRouteCongestion(COORD x_limit, COORD y_limit) :
+  _x_limit(x_limit),
+  _y_limit(y_limit),
+  _max_congestion(0.0) {
+  _congestion.assign((size_t)(x_limit * y_limit), 0.0);
+  _prefix.assign((size_t)((x_limit + 1) * (y_limit + 1)), 0.0);
+}
+
+void ParRouteCongestion::addRouting(RoutingGraph& graph) {
+  NODES::iterator n_iter = graph.node_begin();
+  for (; n_iter != graph.node_end(); ++n_iter) {
+    RoutingNode* node = *n_iter;
+
+    // pins are pseudo nodes, they are never shared
+    HW_Cell* cell = NULL;
+    if (node->isQubit())
+      cell = node->getQubit()->getCell();
+    else if (node->isInteraction())
+      cell = node->getInteraction()->getCell();
+    if (!cell)
+      continue;
+
+    double congestion = node->getHistoryCost();
+    if (node->isOverFlow())
+      congestion += (double)(node->getLoad() - node->getCapacity());
+    if (congestion <= 0.0)
+      continue;
+
+    HW_Loc loc = cell->getLoc();
+    QASSERT(loc.getLocX() < _x_limit && loc.getLocY() < _y_limit);
+    _congestion[gridIndex(loc.getLocX(), loc.getLocY())] += congestion;
+  }
+
+  buildPrefix();
+}
+
+double ParRouteCongestion::getWeight(const Box& box) const {
+  if (_max_congestion <= 0.0)
+    return 1.0;
+  double cells = (double)((box.xr() - box.xl() + 1) * (box.yb() - box.yt() + 1));
+  double congestion = getSum(box.xl(), box.yt(), box.xr(), box.yb()) / (cells * _max_congestion);
+  return 1.0 + route_congestion_weight * congestion;
+}
+
+void ParRouteCongestion::buildPrefix() {
+  size_t row = (size_t)_x_limit + 1;
+  _max_congestion = *std::max_element(_congestion.begin(), _congestion.end());
+  for (COORD y = 0; y < _y_limit; ++y) {
+    for (COORD x = 0; x < _x_limit; ++x) {
+      size_t corner = (size_t)(y + 1) * row + (size_t)(x + 1);
+      _prefix[corner] = _congestion[gridIndex(x, y)] +
+        _prefix[corner - 1] + _prefix[corner - row] - _prefix[corner - row - 1];
+    }
+  }
+}
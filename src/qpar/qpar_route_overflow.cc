@@ -0,0 +1,147 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+/*!
+ * \file qpar_route_overflow.cc
+ * \author Juexiao Su
+ * \date 09 Mar 2018
+ * \brief overused routing nodes and the targets that use them
+ */
+
+#include "qpar/qpar_route_overflow.hh"
+#include "qpar/qpar_route.hh"
+#include "qpar/qpar_routing_graph.hh"
+#include "qpar/qpar_netlist.hh"
+
+#include "utils/qlog.hh"
+
+#include <algorithm>
+
+
+ParRouteOverflow::ParRouteOverflow(RoutingGraph* graph, std::vector<ParWireTarget*>& targets) :
+  _overflow_num(targets.size(), 0),
+  _node_targets(graph->getNodeNum()),
+  _overflow_pos(graph->getNodeNum(), -1) {
+
+  for (size_t i = 0; i < targets.size(); ++i)
+    _target_index[targets[i]] = (unsigned)i;
+
+  // routes restored from an eco file are already on the graph
+  for (size_t i = 0; i < targets.size(); ++i) {
+    if (targets[i]->getDontRoute() || !targets[i]->getRoutePath()) continue;
+    addRoute(targets[i]);
+  }
+}
+
+void ParRouteOverflow::addRoute(ParWireTarget* target) {
+  unsigned index = getTargetIndex(target);
+  RoutePath* path = target->getRoutePath();
+  QASSERT(path && _overflow_num[index] == 0);
+
+  for (size_t i = 0; i < path->size(); ++i) {
+    RoutingNode* node = path->at(i);
+    _node_targets[node->getGraphIndex()].push_back(target);
+    if (isTracked(node->getGraphIndex()))
+      ++_overflow_num[index];
+  }
+
+  for (size_t i = 0; i < path->size(); ++i)
+    updateNode(path->at(i));
+}
+
+void ParRouteOverflow::ripupTarget(ParWireTarget* target) {
+  RoutePath* path = target->getRoutePath();
+  if (!path) return;
+
+  unsigned index = getTargetIndex(target);
+  for (size_t i = 0; i < path->size(); ++i) {
+    RoutingNode* node = path->at(i);
+    std::vector<ParWireTarget*>& node_targets = _node_targets[node->getGraphIndex()];
+    std::vector<ParWireTarget*>::iterator t_iter = std::find(node_targets.begin(), node_targets.end(), target);
+    QASSERT(t_iter != node_targets.end());
+    *t_iter = node_targets.back();
+    node_targets.pop_back();
+    if (isTracked(node->getGraphIndex()))
+      --_overflow_num[index];
+  }
+  QASSERT(_overflow_num[index] == 0);
+
+  target->ripupTarget();
+
+  for (size_t i = 0; i < path->size(); ++i)
+    updateNode(path->at(i));
+}
+
+void ParRouteOverflow::updateNode(RoutingNode* node) {
+  unsigned index = node->getGraphIndex();
+  bool overflow = node->isOverFlow();
+  if (overflow == isTracked(index)) return;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::vector<ParWireTarget*>& node_targets = _node_targets[index];
+  if (overflow) {
+    _overflow_pos[index] = (int)_overflow_nodes.size();
+    _overflow_nodes.push_back(node);
+    for (size_t i = 0; i < node_targets.size(); ++i)
+      ++_overflow_num[getTargetIndex(node_targets[i])];
+  } else {
+    RoutingNode* last = _overflow_nodes.back();
+    _overflow_nodes[_overflow_pos[index]] = last;
+    _overflow_pos[last->getGraphIndex()] = _overflow_pos[index];
+    _overflow_nodes.pop_back();
+    _overflow_pos[index] = -1;
+    for (size_t i = 0; i < node_targets.size(); ++i)
+      --_overflow_num[getTargetIndex(node_targets[i])];
+  }
+}
+
+bool ParRouteOverflow::sanityCheck(RoutingGraph* graph, std::vector<ParWireTarget*>& targets) const {
+  unsigned overflow = 0;
+  NODES::iterator n_iter = graph->node_begin();
+  for (; n_iter != graph->node_end(); ++n_iter) {
+    RoutingNode* node = *n_iter;
+    if (node->isOverFlow() != isTracked(node->getGraphIndex())) {
+      qlog.speak("Route", "Sanity Checking Overflow: node %u is not tracked", node->getGraphIndex());
+      return false;
+    }
+    if (node->isOverFlow())
+      ++overflow;
+  }
+  if (overflow != _overflow_nodes.size())
+    return false;
+
+  for (size_t i = 0; i < targets.size(); ++i) {
+    ParWireTarget* target = targets[i];
+    RoutePath* path = target->getRoutePath();
+    if (target->getDontRoute() || !path) continue;
+
+    unsigned target_overflow = 0;
+    for (size_t j = 0; j < path->size(); ++j) {
+      if (path->at(j)->isOverFlow())
+        ++target_overflow;
+    }
+    if (target_overflow != _overflow_num[getTargetIndex(target)]) {
+      qlog.speak("Route", "Sanity Checking Overflow: target %s uses %u overused nodes, %u are tracked",
+          target->getName().c_str(), target_overflow, _overflow_num[getTargetIndex(target)]);
+      return false;
+    }
+  }
+
+  return true;
+}
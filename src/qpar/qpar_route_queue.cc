@@ -0,0 +1,188 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+/*!
+ * \file qpar_route_queue.cc
+ * \author Juexiao Su
+ * \date 08 Mar 2018
+ * \brief priority queues of vertices used by the router
+ */
+
+#include "qpar/qpar_route_queue.hh"
+
+#include "utils/qlog.hh"
+
+#include <algorithm>
+#include <cmath>
+
+
+//! number of children of a heap slot
+static const size_t heap_arity = 4;
+
+
+ParRouteQueue* ParRouteQueue::create(ROUTE_QUEUE_TYPE type, unsigned vertex_num) {
+  switch (type) {
+    case ROUTE_QUEUE_BUCKET:
+      return new BucketRouteQueue();
+    case ROUTE_QUEUE_HEAP:
+      return new HeapRouteQueue(vertex_num);
+    default:
+      QASSERT(0);
+  }
+}
+
+const char* ParRouteQueue::getTypeName(ROUTE_QUEUE_TYPE type) {
+  switch (type) {
+    case ROUTE_QUEUE_BUCKET:
+      return "bucket";
+    case ROUTE_QUEUE_HEAP:
+      return "heap";
+    default:
+      QASSERT(0);
+  }
+}
+
+
+void BucketRouteQueue::push(double priority, double length, qvertex vertex) {
+  QASSERT(priority >= 0.0);
+  size_t bucket = (size_t)std::lround(priority);
+  if (bucket >= _buckets.size())
+    _buckets.resize(bucket * 2 + 1);
+
+  _buckets[bucket].push_back(std::make_pair(vertex, length));
+  std::push_heap(_buckets[bucket].begin(), _buckets[bucket].end(), _cmp);
+  if (bucket < _cursor || _size == 0)
+    _cursor = bucket;
+  if (bucket + 1 > _top)
+    _top = bucket + 1;
+  ++_size;
+}
+
+qvertex BucketRouteQueue::pop(double& priority, double& length) {
+  if (_size == 0)
+    qlog.speakError("Cannot pop an empty queue!");
+
+  while (_buckets[_cursor].empty())
+    ++_cursor;
+
+  std::vector<BucketElement>& bucket = _buckets[_cursor];
+  std::pop_heap(bucket.begin(), bucket.end(), _cmp);
+  BucketElement element = bucket.back();
+  bucket.pop_back();
+  --_size;
+
+  priority = (double)_cursor;
+  length = element.second;
+  return element.first;
+}
+
+double BucketRouteQueue::getTopPriority() {
+  QASSERT(_size > 0);
+  while (_buckets[_cursor].empty())
+    ++_cursor;
+  return (double)_cursor;
+}
+
+void BucketRouteQueue::clear() {
+  for (size_t i = _cursor; i < _top; ++i)
+    _buckets[i].clear();
+  _cursor = 0;
+  _top = 0;
+  _size = 0;
+}
+
+
+void HeapRouteQueue::push(double priority, double length, qvertex vertex) {
+  _length[vertex] = length;
+
+  int slot = _position[vertex];
+  if (slot < 0) {
+    _heap.push_back(std::make_pair(priority, vertex));
+    _position[vertex] = (int)_heap.size() - 1;
+    siftUp(_heap.size() - 1);
+    return;
+  }
+
+  // decrease key, the router only pushes a vertex again with a lower cost
+  bool decrease = priority <= _heap[slot].first;
+  _heap[slot].first = priority;
+  if (decrease)
+    siftUp((size_t)slot);
+  else
+    siftDown((size_t)slot);
+}
+
+qvertex HeapRouteQueue::pop(double& priority, double& length) {
+  if (_heap.empty())
+    qlog.speakError("Cannot pop an empty queue!");
+
+  qvertex top = _heap[0].second;
+  priority = _heap[0].first;
+  length = _length[top];
+  _position[top] = -1;
+
+  HeapElement last = _heap.back();
+  _heap.pop_back();
+  if (!_heap.empty()) {
+    setSlot(0, last);
+    siftDown(0);
+  }
+  return top;
+}
+
+void HeapRouteQueue::clear() {
+  for (size_t i = 0; i < _heap.size(); ++i)
+    _position[_heap[i].second] = -1;
+  _heap.clear();
+}
+
+void HeapRouteQueue::siftUp(size_t slot) {
+  HeapElement element = _heap[slot];
+  while (slot > 0) {
+    size_t parent = (slot - 1) / heap_arity;
+    if (!isBefore(element, _heap[parent]))
+      break;
+    setSlot(slot, _heap[parent]);
+    slot = parent;
+  }
+  setSlot(slot, element);
+}
+
+void HeapRouteQueue::siftDown(size_t slot) {
+  HeapElement element = _heap[slot];
+  size_t size = _heap.size();
+  while (true) {
+    size_t first = slot * heap_arity + 1;
+    if (first >= size)
+      break;
+
+    size_t best = first;
+    size_t last = std::min(first + heap_arity, size);
+    for (size_t child = first + 1; child < last; ++child) {
+      if (isBefore(_heap[child], _heap[best]))
+        best = child;
+    }
+
+    if (!isBefore(_heap[best], element))
+      break;
+    setSlot(slot, _heap[best]);
+    slot = best;
+  }
+  setSlot(slot, element);
+}
@@ -27,20 +27,24 @@
 
 bool ParRouter::route(RoutingNode* src, RoutingNode* tgt, double slack, std::unordered_set<RoutingNode*>& used, ParWireTarget* target) {
 
-  _from_edge.clear();
-  _source = _graph.get_i_vertex(src);
-  _target = _graph.get_i_vertex(tgt);
+  _source = (qvertex)src->getGraphIndex();
+  _target = (qvertex)tgt->getGraphIndex();
+  _meet = -1;
+  _expanded_num = 0;
 
   if (_source == _target) {
     qlog.speak("Router", "Find ParWireTarget with same source and target");
     return true;
   }
 
-  for (size_t i = 0; i < _visited_node.size(); ++i)
-    _visited_node[i] = std::numeric_limits<double>::infinity();
+  nextStamp();
 
-  QPriorityQueue* pqueue = new QPriorityQueue;
-  _visited_node[_source] = 0.0;
+  if (_bidirectional)
+    return routeBidirectional(slack, target);
+
+  ParRouteQueue* pqueue = _pqueue;
+  pqueue->clear();
+  setVisitCost(_source, 0.0);
 
   qvertex cur_vertex = _source;
   double real_cost = 0.0;
@@ -50,9 +54,9 @@ bool ParRouter::route(RoutingNode* src, RoutingNode* tgt, double slack, std::uno
   expandNeighbors(pqueue, cur_vertex, real_cost, slack, target);
 
   if (pqueue->empty()) {
-    qlog.speak("Router", "Cannot find route for %s:%s", target->getWire()->getName().c_str(),
-        target->getName().c_str());
-    delete pqueue;
+    if (!_use_window)
+      qlog.speak("Router", "Cannot find route for %s:%s", target->getWire()->getName().c_str(),
+          target->getName().c_str());
     return false;
   }
 
@@ -62,8 +66,10 @@ bool ParRouter::route(RoutingNode* src, RoutingNode* tgt, double slack, std::uno
 
     if (pqueue->empty() || cur_vertex == _target) {
       if (cur_vertex == _target) {
-        delete pqueue;
         return true;
+      } else if (_use_window) {
+        // the caller retries without window
+        return false;
       } else {
         qlog.speakError("Priority queue is empty, cannot find path");
       }
@@ -71,50 +77,239 @@ bool ParRouter::route(RoutingNode* src, RoutingNode* tgt, double slack, std::uno
 
   } while (true);
 
-  delete pqueue;
   return false;
 
 }
 
-void ParRouter::expandNeighbors(QPriorityQueue* pqueue, qvertex current_vertex, double real_length, double slack, ParWireTarget* target) {
+void ParRouter::nextStamp() {
+  ++_stamp;
+  if (_stamp == std::numeric_limits<unsigned>::max()) {
+    std::fill(_visit_stamp.begin(), _visit_stamp.end(), 0);
+    std::fill(_back_stamp.begin(), _back_stamp.end(), 0);
+    std::fill(_sink_stamp.begin(), _sink_stamp.end(), 0);
+    _stamp = 1;
+  }
+}
+
+void ParRouter::beginTree(RoutingNode* src) {
+  // the estimate toward one sink does not hold for the others
+  QASSERT(_hop_cost == 0.0);
+  if (_sink_stamp.empty())
+    _sink_stamp.resize(_graph.get_vertex_num(), 0);
+
+  _source = (qvertex)src->getGraphIndex();
+  _target = _source;
+  _meet = -1;
+  _expanded_num = 0;
+  nextStamp();
+
+  _pqueue->clear();
+  setVisitCost(_source, 0.0);
+  _pqueue->push(0.0, 0.0, _source);
+}
+
+int ParRouter::routeTree(const std::vector<RoutingNode*>& sinks, double slack, ParWireTarget* target) {
+
+  // a sink can be passed through by an earlier branch
+  for (size_t i = 0; i < sinks.size(); ++i) {
+    qvertex sink = (qvertex)sinks[i]->getGraphIndex();
+    if (getVisitCost(sink) == 0.0) {
+      _target = sink;
+      return (int)i;
+    }
+  }
+
+  for (size_t i = 0; i < sinks.size(); ++i)
+    _sink_stamp[sinks[i]->getGraphIndex()] = _stamp;
+
+  // the costs of vertices reached by earlier calls still hold, the nodes of a
+  // new branch cost the same after they are used by the wire
+  int found = -1;
+  while (!_pqueue->empty()) {
+    double priority = 0.0;
+    double real_length = 0.0;
+    qvertex cur_vertex = popBestVertex(_pqueue, priority, real_length);
+    if (priority > getVisitCost(cur_vertex)) continue;
+
+    if (_sink_stamp[cur_vertex] == _stamp) {
+      _target = cur_vertex;
+      addTreeBranch(cur_vertex);
+      for (size_t i = 0; i < sinks.size(); ++i) {
+        if ((qvertex)sinks[i]->getGraphIndex() == cur_vertex)
+          found = (int)i;
+      }
+      break;
+    }
+
+    expandNeighbors(_pqueue, cur_vertex, real_length, slack, target);
+  }
+
+  for (size_t i = 0; i < sinks.size(); ++i)
+    _sink_stamp[sinks[i]->getGraphIndex()] = 0;
+
+  if (found < 0 && !_use_window)
+    qlog.speakError("Priority queue is empty, cannot find path");
+
+  return found;
+}
+
+void ParRouter::addTreeBranch(qvertex vertex) {
+  // the from edges of a branch already point toward the source
+  while (getVisitCost(vertex) > 0.0) {
+    setVisitCost(vertex, 0.0);
+    _pqueue->push(0.0, 0.0, vertex);
+    vertex = _graph.get_other_vertex(_from_edge[vertex], vertex);
+  }
+}
+
+void ParRouter::expandNeighbors(ParRouteQueue* pqueue, qvertex current_vertex, double real_length, double slack, ParWireTarget* target) {
+
+  ++_expanded_num;
+
+  unsigned slot_end = _graph.adj_end(current_vertex);
+  for (unsigned slot = _graph.adj_begin(current_vertex); slot < slot_end; ++slot) {
 
-  std::pair<vertex2edge::edge_iter , vertex2edge::edge_iter> edge_iter_pair = _graph.get_edges(current_vertex);
-  vertex2edge::edge_iter e_iter = edge_iter_pair.first;
-  for (; e_iter != edge_iter_pair.second; ++e_iter) {
+    qedge cur_edge = _graph.get_adj_edge(slot);
+    qvertex target_vertex = _graph.get_adj_vertex(slot);
 
-    qedge cur_edge = *e_iter;
-    qvertex target_vertex = _graph.get_other_vertex(cur_edge, current_vertex);
+    if (!isInWindow(target_vertex)) continue;
 
-    RoutingNode* e_target_vertex = _graph.get_e_vertex(target_vertex);
-    if (!e_target_vertex->isEnabled())  continue;
+    const RoutingNodeState& state = _graph.get_state(target_vertex);
+    if (!state.enabled)  continue;
 
-    double cost = _cost.compute_cost(e_target_vertex, target, slack, real_length);
+    double cost = _cost.compute_cost(state, target, slack, real_length);
 
     double new_real_length = real_length + 1; //proceed one node
-    double new_cost = cost + _visited_node[current_vertex];
+    double new_cost = cost + getVisitCost(current_vertex);
 
-    if (_visited_node[target_vertex] <= new_cost) continue;
+    if (getVisitCost(target_vertex) <= new_cost) continue;
 
-    pqueue->push(new_cost, std::make_pair(new_real_length, target_vertex));
-    _visited_node[target_vertex] = new_cost;
+    pqueue->push(new_cost + estimateCost(target_vertex, _target), new_real_length, target_vertex);
+    setVisitCost(target_vertex, new_cost);
     _from_edge[target_vertex] = cur_edge;
   }
 
 }
 
-qvertex ParRouter::popBestVertex(QPriorityQueue* pqueue, double& current_cost, double& real_cost) {
-  qvertex best_v;
-  PElement pele = pqueue->pop();
-  current_cost = pele.first;
-  real_cost = pele.second.first;
-  best_v = pele.second.second;
-  return best_v;
+bool ParRouter::routeBidirectional(double slack, ParWireTarget* target) {
+
+  ParRouteQueue* fqueue = _pqueue;
+  ParRouteQueue* bqueue = _back_pqueue;
+  fqueue->clear();
+  bqueue->clear();
+
+  // a path is only complete when it can enter the target
+  if (_graph.get_state(_target).enabled) {
+    setVisitCost(_source, 0.0);
+    setBackCost(_target, 0.0);
+    fqueue->push(getPotential(_source), 0.0, _source);
+    bqueue->push(-getPotential(_target), 0.0, _target);
+  }
+  _meet_cost = std::numeric_limits<double>::infinity();
+
+  // the potentials of the two searches cancel out on a path, so the
+  // search stops once the two lowest priorities add up to the best path
+  while (!fqueue->empty() && !bqueue->empty()) {
+    double forward_top = fqueue->getTopPriority();
+    double backward_top = bqueue->getTopPriority();
+    if (forward_top + backward_top >= _meet_cost) break;
+
+    double priority = 0.0;
+    double real_length = 0.0;
+    if (forward_top <= backward_top) {
+      qvertex cur_vertex = popBestVertex(fqueue, priority, real_length);
+      // a stale copy left by a bucket queue
+      if (priority > getVisitCost(cur_vertex) + getPotential(cur_vertex)) continue;
+      expandForward(cur_vertex, real_length, slack, target);
+    } else {
+      qvertex cur_vertex = popBestVertex(bqueue, priority, real_length);
+      if (priority > getBackCost(cur_vertex) - getPotential(cur_vertex)) continue;
+      expandBackward(cur_vertex, real_length, slack, target);
+    }
+  }
+
+  if (_meet >= 0)
+    return true;
+
+  if (!_use_window)
+    qlog.speakError("Priority queue is empty, cannot find path");
+
+  // the caller retries without window
+  return false;
+}
+
+void ParRouter::expandForward(qvertex current_vertex, double real_length, double slack, ParWireTarget* target) {
+
+  ++_expanded_num;
+  double current_cost = getVisitCost(current_vertex);
+
+  unsigned slot_end = _graph.adj_end(current_vertex);
+  for (unsigned slot = _graph.adj_begin(current_vertex); slot < slot_end; ++slot) {
+
+    qvertex target_vertex = _graph.get_adj_vertex(slot);
+    if (!isInWindow(target_vertex)) continue;
+
+    const RoutingNodeState& state = _graph.get_state(target_vertex);
+    if (!state.enabled)  continue;
+
+    double new_cost = current_cost + _cost.compute_cost(state, target, slack, real_length);
+    if (getVisitCost(target_vertex) <= new_cost) continue;
+
+    _pqueue->push(new_cost + getPotential(target_vertex), real_length + 1, target_vertex);
+    setVisitCost(target_vertex, new_cost);
+    _from_edge[target_vertex] = _graph.get_adj_edge(slot);
+
+    double path_cost = new_cost + getBackCost(target_vertex);
+    if (path_cost < _meet_cost) {
+      _meet_cost = path_cost;
+      _meet = target_vertex;
+    }
+  }
+
+}
+
+void ParRouter::expandBackward(qvertex current_vertex, double real_length, double slack, ParWireTarget* target) {
+
+  // a path never leaves the source, it only ends there
+  if (current_vertex == _source) return;
+
+  ++_expanded_num;
+  const RoutingNodeState& current_state = _graph.get_state(current_vertex);
+  double new_cost = getBackCost(current_vertex) + _cost.compute_cost(current_state, target, slack, real_length);
+
+  unsigned slot_end = _graph.adj_end(current_vertex);
+  for (unsigned slot = _graph.adj_begin(current_vertex); slot < slot_end; ++slot) {
+
+    qvertex target_vertex = _graph.get_adj_vertex(slot);
+    if (target_vertex != _source) {
+      if (!isInWindow(target_vertex)) continue;
+      if (!_graph.get_state(target_vertex).enabled)  continue;
+    }
+
+    if (getBackCost(target_vertex) <= new_cost) continue;
+
+    _back_pqueue->push(new_cost - getPotential(target_vertex), real_length + 1, target_vertex);
+    setBackCost(target_vertex, new_cost);
+    _to_edge[target_vertex] = _graph.get_adj_edge(slot);
+
+    double path_cost = new_cost + getVisitCost(target_vertex);
+    if (path_cost < _meet_cost) {
+      _meet_cost = path_cost;
+      _meet = target_vertex;
+    }
+  }
+
+}
+
+qvertex ParRouter::popBestVertex(ParRouteQueue* pqueue, double& current_cost, double& real_cost) {
+  return pqueue->pop(current_cost, real_cost);
 }
 
 void ParRouter::buildRoutePath(std::list<RoutingNode*>& path, std::list<RoutingEdge*>& edges) {
   path.clear();
   edges.clear();
-  qvertex current_vertex = _target;
+  // a bidirectional search traces back from where the searches meet
+  qvertex current_vertex = _meet >= 0 ? _meet : _target;
   while (current_vertex != _source) {
     RoutingNode* node = _graph.get_e_vertex(current_vertex);
     path.push_front(node);
@@ -127,6 +322,16 @@ void ParRouter::buildRoutePath(std::list<RoutingNode*>& path, std::list<RoutingE
 
   RoutingNode* node = _graph.get_e_vertex(current_vertex);
   path.push_front(node);
+
+  if (_meet < 0) return;
+
+  current_vertex = _meet;
+  while (current_vertex != _target) {
+    qedge to_edge = _to_edge[current_vertex];
+    edges.push_back(_graph.get_e_edge(to_edge));
+    current_vertex = _graph.get_other_vertex(to_edge, current_vertex);
+    path.push_back(_graph.get_e_vertex(current_vertex));
+  }
 }
 
 
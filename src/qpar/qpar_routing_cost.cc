@@ -21,12 +21,15 @@
 #include "qpar/qpar_routing_graph.hh"
 
 
+//! cost of a node without history and congestion
+static const double nbr_base_delay = 1.0;
 
-double RoutingCostNBR::compute_cost(RoutingNode* node, ParWireTarget* tgt, double slack, double current_length) {
-  unsigned load = node->getLoad();
-  unsigned capacity = node->getCapacity();
 
-  bool used = node->getCurrentlyUsed();
+double RoutingCostNBR::compute_cost(const RoutingNodeState& node, ParWireTarget* tgt, double slack, double current_length) {
+  unsigned load = node.load;
+  unsigned capacity = node.capacity;
+
+  bool used = node.currently_used;
   unsigned try_add_load = 0;
   if (used) {
     try_add_load = load;
@@ -34,9 +37,9 @@ double RoutingCostNBR::compute_cost(RoutingNode* node, ParWireTarget* tgt, doubl
     try_add_load = load + 1;
   }
 
-  double base_delay = 1.0;
+  double base_delay = nbr_base_delay;
   double congestion_cost = getCongestionCost(try_add_load, capacity);
-  double history_cost = node->getHistoryCost();
+  double history_cost = node.history_cost;
 
   slack = std::min(slack, 0.95);
 
@@ -48,6 +51,11 @@ double RoutingCostNBR::compute_cost(RoutingNode* node, ParWireTarget* tgt, doubl
 
 }
 
+double RoutingCostNBR::getMinCost() const {
+  // history and congestion costs are never negative
+  return nbr_base_delay;
+}
+
 double RoutingCostNBR::getCongestionCost(unsigned load, unsigned capacity) {
 
   if (load <= capacity) return 0.0;
@@ -60,6 +68,6 @@ double RoutingCostNBR::getCongestionCost(unsigned load, unsigned capacity) {
 
 }
 
-double RoutingCostSimple::compute_cost(RoutingNode* node, ParWireTarget* tgt, double slack, double current_length) {
+double RoutingCostSimple::compute_cost(const RoutingNodeState& node, ParWireTarget* tgt, double slack, double current_length) {
   return 1.0;
 }
@@ -93,6 +93,14 @@ RoutingNode* RoutingGraph::getRoutingNode(ParElement* element, SYN::Pin* pin) co
   return r_cell->getRoutingNode(pin);
 }
 
+RoutingNode* RoutingGraph::getRoutingNode(COORD x, COORD y, COORD local) const {
+  ParGrid* grid = _par_target->getGrid(x, y);
+  if (!grid)
+    return NULL;
+  RoutingCell* r_cell = _cells.at(grid->getHWCell());
+  return r_cell->getRoutingNode(local);
+}
+
 
 void RoutingGraph::createRoutingGraph() {
   qlog.speak("Routing Graph", "build routing graph...");
@@ -143,7 +151,9 @@ void RoutingGraph::createRoutingGraph() {
     if (grid2->getCurrentElement())
       local2 = local2 % 4;
 
+    // inter-cell interaction is located at the cell of its from qubit
     RoutingNode* inter_node = new RoutingNode(interac);
+    inter_node->setRoutingCell(cell1);
     RoutingNode* rr_node1 = cell1->getRoutingNode(local1);
     RoutingNode* rr_node2 = cell2->getRoutingNode(local2);
     _nodes.insert(inter_node);
@@ -153,6 +163,14 @@ void RoutingGraph::createRoutingGraph() {
     _edges.insert(edge1);
     _edges.insert(edge2);
   }
+
+  // the node set does not change anymore, pack the node states
+  _node_states.resize(_nodes.size());
+  size_t state_index = 0;
+  NODES::iterator n_iter = _nodes.begin();
+  for (; n_iter != _nodes.end(); ++n_iter, ++state_index)
+    (*n_iter)->bindState(&_node_states[state_index], (unsigned)state_index);
+
   qlog.speak("Routing Graph", "routing graph created %lu nodes %lu edges",
       _nodes.size(),
       _edges.size());
@@ -174,13 +192,11 @@ RoutingNode::RoutingNode() :
   _qubit(NULL),
   _interaction(NULL),
   _pin(NULL),
+  _rr_cell(NULL),
   _isLogicalQubit(false),
   _isPass(false),
-  _load(0),
-  _history_cost(0.0),
-  _is_currently_used(false),
-  _isEnable(true),
-  _capacity(1)
+  _state(&_own_state),
+  _graph_index(0)
 {
   _node_index = _index_counter;
   ++_index_counter;
@@ -190,13 +206,11 @@ RoutingNode::RoutingNode(HW_Qubit* qubit, bool logical) :
   _qubit(qubit),
   _interaction(NULL),
   _pin(NULL),
+  _rr_cell(NULL),
   _isLogicalQubit(logical),
   _isPass(false),
-  _load(0),
-  _history_cost(0.0),
-  _is_currently_used(false),
-  _isEnable(true),
-  _capacity(1)
+  _state(&_own_state),
+  _graph_index(0)
 {
   _node_index = _index_counter;
   ++_index_counter;
@@ -206,13 +220,11 @@ RoutingNode::RoutingNode(HW_Interaction* iter) :
   _qubit(NULL),
   _interaction(iter),
   _pin(NULL),
+  _rr_cell(NULL),
   _isLogicalQubit(false),
   _isPass(false),
-  _load(0),
-  _history_cost(0.0),
-  _is_currently_used(false),
-  _isEnable(true),
-  _capacity(1)
+  _state(&_own_state),
+  _graph_index(0)
 {
   _node_index = _index_counter;
   ++_index_counter;
@@ -222,13 +234,11 @@ RoutingNode::RoutingNode(SYN::Pin* pin) :
   _qubit(NULL),
   _interaction(NULL),
   _pin(pin),
-  _history_cost(0.0),
-  _is_currently_used(false),
+  _rr_cell(NULL),
   _isLogicalQubit(false),
   _isPass(false),
-  _load(0),
-  _isEnable(true),
-  _capacity(1)
+  _state(&_own_state),
+  _graph_index(0)
 {
   _node_index = _index_counter;
   ++_index_counter;
@@ -306,6 +316,8 @@ RoutingCell::RoutingCell(ParGrid* grid, RoutingGraph* graph) :
   _graph(graph)
 {
   initCellRoutingGraph();
+  for (size_t i = 0; i < _nodes.size(); ++i)
+    _nodes[i]->setRoutingCell(this);
 }
 
 
@@ -24,6 +24,19 @@
 #include "qpar/qpar_target.hh"
 #include "qpar/qpar_routing_test.hh"
 #include "qpar/qpar_route.hh"
+#include "qpar/qpar_router.hh"
+#include "qpar/qpar_routing_cost.hh"
+#include "qpar/qpar_netlist.hh"
+
+#include <cmath>
+#include <list>
+#include <unordered_set>
+
+
+//! slack used to compare routes, high enough for history costs to matter
+static const double test_route_slack = 0.5;
+//! difference below which two path costs are equal
+static const double test_cost_tolerance = 1e-6;
 
 
 void RoutingTester::testRoutingGraph() {
@@ -51,3 +64,80 @@ void RoutingTester::testRoutingGraph() {
   }
   
 }
+
+void RoutingTester::testBidirectionalRoute() {
+  HW_Target_Dwave* hw_target = _par_system->_hw_target;
+  ParTarget* par_target = _par_system->_par_target;
+  RoutingGraph graph(hw_target, par_target);
+  FastRoutingGraph fast_g(&graph);
+
+  // uneven history costs so that the shortest path is not just the shortest hop count
+  RoutingNodeState* states = graph.getNodeStates();
+  for (unsigned i = 0; i < graph.getNodeNum(); ++i)
+    states[i].history_cost = (double)((i * 7919) % 13) * 0.25;
+
+  RoutingCostNBR cost;
+  unsigned single_expanded = 0;
+  unsigned bidir_expanded = 0;
+  compareBidirectionalRoute(graph, fast_g, cost, 0.0, single_expanded, bidir_expanded);
+  qlog.speak("Routing Test", "dijkstra expanded %u nodes, bidirectional dijkstra expanded %u nodes",
+      single_expanded, bidir_expanded);
+
+  single_expanded = 0;
+  bidir_expanded = 0;
+  compareBidirectionalRoute(graph, fast_g, cost, 1.0, single_expanded, bidir_expanded);
+  qlog.speak("Routing Test", "astar expanded %u nodes, bidirectional astar expanded %u nodes",
+      single_expanded, bidir_expanded);
+}
+
+void RoutingTester::compareBidirectionalRoute(RoutingGraph& graph, FastRoutingGraph& fast_g, RoutingCost& cost,
+    double astar_fac, unsigned& single_expanded, unsigned& bidir_expanded) {
+
+  ParRouter single_router(fast_g, cost, astar_fac);
+  ParRouter bidir_router(fast_g, cost, astar_fac, true);
+  std::unordered_set<RoutingNode*> used;
+
+  std::vector<ParWireTarget*>& targets = _par_system->_par_netlist->getTargets();
+  for (size_t i = 0; i < targets.size(); ++i) {
+    ParWireTarget* target = targets[i];
+    if (target->getDontRoute()) continue;
+
+    RoutingNode* src_node = graph.getRoutingNode(target->getSourceElement(), target->getSourcePin());
+    RoutingNode* tgt_node = graph.getRoutingNode(target->getTargetElement(), target->getTargetPin());
+    QASSERT(src_node && tgt_node);
+    if (src_node == tgt_node) continue;
+
+    double path_cost[2];
+    ParRouter* routers[2] = {&single_router, &bidir_router};
+    for (unsigned r = 0; r < 2; ++r) {
+      QASSERT(routers[r]->route(src_node, tgt_node, test_route_slack, used, target));
+
+      std::list<RoutingNode*> path;
+      std::list<RoutingEdge*> edges;
+      routers[r]->buildRoutePath(path, edges);
+      QASSERT(path.front() == src_node && path.back() == tgt_node);
+      QASSERT(edges.size() + 1 == path.size());
+
+      // the path has to be connected, the source itself costs nothing
+      path_cost[r] = 0.0;
+      std::list<RoutingNode*>::iterator n_iter = path.begin();
+      std::list<RoutingEdge*>::iterator e_iter = edges.begin();
+      for (; e_iter != edges.end(); ++e_iter) {
+        RoutingNode* node = *n_iter;
+        ++n_iter;
+        QASSERT((*e_iter)->getOtherNode(node) == *n_iter);
+        const RoutingNodeState& state = graph.getNodeStates()[(*n_iter)->getGraphIndex()];
+        path_cost[r] += cost.compute_cost(state, target, test_route_slack, 0.0);
+      }
+    }
+
+    single_expanded += single_router.getExpandedNum();
+    bidir_expanded += bidir_router.getExpandedNum();
+
+    if (std::fabs(path_cost[0] - path_cost[1]) > test_cost_tolerance) {
+      qlog.speakError("Bidirectional route of %s:%s costs %f, single route costs %f",
+          target->getWire()->getName().c_str(), target->getName().c_str(),
+          path_cost[1], path_cost[0]);
+    }
+  }
+}
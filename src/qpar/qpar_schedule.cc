@@ -0,0 +1,235 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+/*!
+ * \file qpar_schedule.cc
+ * \author Juexiao Su
+ * \date 05 Mar 2018
+ * \brief annealing schedules, cooling, move radius, moves per temperature and exit
+ */
+
+#include "qpar/qpar_schedule.hh"
+
+#include "utils/qlog.hh"
+
+#include <algorithm>
+#include <cmath>
+
+// success rate the move radius is tuned for
+static const float schedule_best_rate = 0.44f;
+
+// cooling of the default schedule by success rate
+static const float default_step_1 = 0.96f;
+static const float default_step_2 = 0.8f;
+static const float default_step_3 = 0.15f;
+static const float default_cool_speed1 = 0.2f;
+static const float default_cool_speed2 = 0.75f;
+static const float default_cool_speed3 = 0.85f;
+static const float default_cool_speed4 = 0.6f;
+// the default schedule stops at this fraction of the unit cost
+static const double default_exit_factor = 0.08;
+// the default schedule stops after this many temperatures
+static const int default_max_temperature = 106;
+
+// cooling of the VPR schedule by success rate
+static const float vpr_step_1 = 0.96f;
+static const float vpr_step_2 = 0.8f;
+static const float vpr_step_3 = 0.15f;
+static const float vpr_cool_speed1 = 0.5f;
+static const float vpr_cool_speed2 = 0.9f;
+static const float vpr_cool_speed3 = 0.95f;
+static const float vpr_cool_speed4 = 0.8f;
+// the VPR schedule stops at this fraction of the unit cost
+static const double vpr_exit_factor = 0.005;
+
+// quality factor lambda of the Lam-Delosme schedule, smaller cools slower
+static const double lam_quality = 0.7;
+// the Lam-Delosme cooling rate is kept in this range
+static const double lam_min_cool_speed = 0.5;
+static const double lam_max_cool_speed = 0.98;
+// the Lam-Delosme schedule stops at this fraction of the unit cost
+static const double lam_exit_factor = 0.01;
+
+// fixed cooling of the budget schedule
+static const float budget_cool_speed = 0.9f;
+// the budget schedule stops at this fraction of the unit cost
+static const double budget_exit_factor = 0.08;
+// moves per temperature of the budget schedule relative to the placer's choice
+static const double budget_min_scale = 0.01;
+static const double budget_max_scale = 100.0;
+// the first temperature of the budget schedule only measures the time per move
+static const double budget_probe_scale = 0.1;
+
+
+void ParSchedule::start(int move_limit) {
+  _move_limit = move_limit;
+  _temperature_num = 0;
+}
+
+float ParSchedule::updateRLimit(float r_limit, float r_max, float success_rate) const {
+  r_limit *= (1.0f - schedule_best_rate + success_rate);
+  r_limit = std::min(r_limit, r_max);
+  return std::max(r_limit, 1.0f);
+}
+
+ParSchedule* ParSchedule::create(SCHEDULE_TYPE type, double budget) {
+  switch (type) {
+    case SCHEDULE_DEFAULT:
+      return new DefaultSchedule;
+    case SCHEDULE_VPR:
+      return new VPRSchedule;
+    case SCHEDULE_LAM:
+      return new LamSchedule;
+    case SCHEDULE_BUDGET:
+      QASSERT(budget > 0.0);
+      return new BudgetSchedule(budget);
+    default:
+      QASSERT(0);
+  }
+}
+
+bool ParSchedule::getType(const std::string& name, SCHEDULE_TYPE& type) {
+  if (name == "default") {
+    type = SCHEDULE_DEFAULT;
+    return true;
+  } else if (name == "vpr") {
+    type = SCHEDULE_VPR;
+    return true;
+  } else if (name == "lam") {
+    type = SCHEDULE_LAM;
+    return true;
+  } else if (name == "budget") {
+    type = SCHEDULE_BUDGET;
+    return true;
+  }
+  return false;
+}
+
+const char* ParSchedule::getTypeName(SCHEDULE_TYPE type) {
+  switch (type) {
+    case SCHEDULE_DEFAULT:
+      return "default";
+    case SCHEDULE_VPR:
+      return "vpr";
+    case SCHEDULE_LAM:
+      return "lam";
+    case SCHEDULE_BUDGET:
+      return "budget";
+    default:
+      QASSERT(0);
+  }
+}
+
+
+float DefaultSchedule::updateT(float t, float r_limit, const AnnealStat& stat) {
+  ++_temperature_num;
+  float sr = stat.success_rate;
+  if (sr > default_step_1)
+    return t * default_cool_speed1;
+  else if (sr > default_step_2)
+    return t * default_cool_speed2;
+  else if (sr > default_step_3 || r_limit > 1.f)
+    return t * default_cool_speed3;
+  return t * default_cool_speed4;
+}
+
+bool DefaultSchedule::shouldExit(float t, float unit_cost) const {
+  return t < default_exit_factor * unit_cost || _temperature_num >= default_max_temperature;
+}
+
+
+float VPRSchedule::updateT(float t, float r_limit, const AnnealStat& stat) {
+  ++_temperature_num;
+  float sr = stat.success_rate;
+  if (sr > vpr_step_1)
+    return t * vpr_cool_speed1;
+  else if (sr > vpr_step_2)
+    return t * vpr_cool_speed2;
+  else if (sr > vpr_step_3)
+    return t * vpr_cool_speed3;
+  return t * vpr_cool_speed4;
+}
+
+bool VPRSchedule::shouldExit(float t, float unit_cost) const {
+  return t < vpr_exit_factor * unit_cost;
+}
+
+
+float LamSchedule::updateT(float t, float r_limit, const AnnealStat& stat) {
+  ++_temperature_num;
+  double rho = stat.success_rate;
+  double sigma = stat.cost_std;
+
+  // nothing was accepted, or every accepted move kept the cost
+  if (sigma <= 0.0 || t <= 0.0f)
+    return (float)(t * lam_min_cool_speed);
+
+  double s = 1.0 / t;
+  double s_sigma = s * sigma;
+  double delta_s = lam_quality / sigma / (s_sigma * s_sigma) *
+    4.0 * rho * (1.0 - rho) * (1.0 - rho) / ((2.0 - rho) * (2.0 - rho));
+  double cool_speed = s / (s + delta_s);
+  cool_speed = std::max(lam_min_cool_speed, std::min(cool_speed, lam_max_cool_speed));
+  return (float)(t * cool_speed);
+}
+
+bool LamSchedule::shouldExit(float t, float unit_cost) const {
+  return t < lam_exit_factor * unit_cost;
+}
+
+
+void BudgetSchedule::start(int move_limit) {
+  _base_move_limit = move_limit;
+  _move_limit = std::max(1, (int)(budget_probe_scale * move_limit));
+  _temperature_num = 0;
+  _start_time = std::chrono::steady_clock::now();
+  _total_move = 0.0;
+}
+
+double BudgetSchedule::getElapsed() const {
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - _start_time;
+  return elapsed.count();
+}
+
+float BudgetSchedule::updateT(float t, float r_limit, const AnnealStat& stat) {
+  ++_temperature_num;
+  // time per move includes the work done once per temperature
+  double elapsed = getElapsed();
+  _total_move += stat.move_num;
+  double move_time = elapsed / std::max(_total_move, 1.0);
+
+  float next_t = t * budget_cool_speed;
+
+  // temperatures left to the exit temperature at the fixed cooling rate
+  double exit_t = budget_exit_factor * stat.unit_cost;
+  double left = 1.0;
+  if (exit_t > 0.0 && next_t > exit_t)
+    left = std::ceil(std::log(exit_t / next_t) / std::log((double)budget_cool_speed));
+
+  double moves = (_budget - elapsed) / (left * std::max(move_time, 1e-9));
+  moves = std::max(moves, budget_min_scale * _base_move_limit);
+  moves = std::min(moves, budget_max_scale * _base_move_limit);
+  _move_limit = std::max(1, (int)moves);
+
+  return next_t;
+}
+
+bool BudgetSchedule::shouldExit(float t, float unit_cost) const {
+  return t < budget_exit_factor * unit_cost || getElapsed() >= _budget;
+}
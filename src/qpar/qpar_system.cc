@@ -29,9 +29,18 @@
 #include "qpar/qpar_target.hh"
 #include "qpar/qpar_routing_graph.hh"
 #include "qpar/qpar_place.hh"
+#include "qpar/qpar_tempering.hh"
+#include "qpar/qpar_multistart.hh"
 #include "qpar/qpar_route.hh"
+#include "qpar/qpar_route_congestion.hh"
+#include "qpar/qpar_eco.hh"
 #include "utils/qlog.hh"
 
+#include <chrono>
+
+// a placement refined after a failed routing is annealed from this fraction of its cost per wire
+static const float route_feedback_t = 0.3f;
+
 ParSystem* ParSystem::_system = NULL;
 
 ParSystem::~ParSystem() {
@@ -41,12 +50,14 @@ ParSystem::~ParSystem() {
   if (_par_netlist) delete _par_netlist;
   if (_par_target) delete _par_target;
   if (_rand_gen) delete _rand_gen;
+  if (_place_option) delete _place_option;
 
   _fast_routing_graph = NULL;
   _routing_graph = NULL;
   _par_netlist = NULL;
   _par_target = NULL;
   _rand_gen = NULL;
+  _place_option = NULL;
 }
 
 
@@ -71,13 +82,45 @@ void ParSystem::initHardware() {
   _par_target->initParTarget();
 }
 
-void ParSystem::doPlacement() {
+void ParSystem::doPlacement(const PlaceOption& option) {
 
   //check system status
   if (_status.hasTargetInit && _status.hasDesignInit) {
-    QPlace placer(_par_netlist, _par_target);
-    placer.run();
-    placer.dumpCurrentPlacement("final.place");
+    if (!option.eco_file.empty()) {
+      ParEco eco(_par_netlist, _par_target);
+      eco.fixPlacement(option.eco_file);
+    }
+
+    // replicas and starts are built from the synthesis netlist and do not know the current placement
+    bool keep_placement = !option.eco_file.empty() || option.warm_t > 0.0f;
+    if (option.replicas > 1 && keep_placement)
+      qlog.speak("Place", "Parallel tempering is skipped in eco placement or warm start");
+    if (option.starts > 1 && keep_placement)
+      qlog.speak("Place", "Multi-start is skipped in eco placement or warm start");
+
+    if (option.replicas > 1 && option.starts > 1)
+      qlog.speakError("Parallel tempering and multi-start placement cannot be used together");
+
+    if (_place_option)
+      delete _place_option;
+    _place_option = new PlaceOption(option);
+
+    if (option.warm_t > 0.0f && !_status.hasPlaced)
+      qlog.speakError("Warm start needs a placement, run read_placement or place first");
+
+    if (option.replicas > 1 && !keep_placement) {
+      ParTempering placer(_syn_netlist, _hw_target, _par_netlist, _par_target, option);
+      placer.run();
+      placer.dumpCurrentPlacement("final.place");
+    } else if (option.starts > 1 && !keep_placement) {
+      ParMultiStart placer(_syn_netlist, _hw_target, _par_netlist, _par_target, option);
+      placer.run();
+      placer.dumpCurrentPlacement("final.place");
+    } else {
+      QPlace placer(_par_netlist, _par_target, option);
+      placer.run();
+      placer.dumpCurrentPlacement("final.place");
+    }
     _status.hasPlaced = true;
   } else {
     qlog.speakError("Cannot run placement because target or design has not been initilized");
@@ -85,16 +128,128 @@ void ParSystem::doPlacement() {
 
 }
 
-void ParSystem::doRoute() {
-  if (_status.hasPlaced) {
-    _routing_graph = new RoutingGraph(_hw_target, _par_target);
-    _fast_routing_graph = new FastRoutingGraph(_routing_graph);
-    QRoute router(_par_netlist, _routing_graph, _fast_routing_graph);
-    router.run();
-    router.printAllRoute("final.route");
-  } else {
+void ParSystem::benchPlacement(const PlaceOption& option, int num_move, float temperature) {
+  if (!_status.hasTargetInit || !_status.hasDesignInit)
+    qlog.speakError("Cannot run placement because target or design has not been initilized");
+
+  QPlace placer(_par_netlist, _par_target, option);
+  placer.initialize();
+
+  std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+  unsigned success_num = placer.anneal(temperature, num_move);
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+
+  qlog.speak("Place", "%d moves at T %g in %.3f seconds, %.0f moves/s, %u accepted",
+      num_move, temperature, elapsed.count(), (double)num_move / elapsed.count(), success_num);
+
+  placer.finish();
+  _status.hasPlaced = true;
+}
+
+void ParSystem::readPlacement(const std::string& filename) {
+  if (!_status.hasTargetInit || !_status.hasDesignInit)
+    qlog.speakError("Cannot read placement because target or design has not been initilized");
+
+  PLACE_LOCS locations;
+  if (!QPlace::readPlacement(filename, locations))
+    qlog.speakError("QPAR: Cannot open %s to read", filename.c_str());
+
+  // release the current placement
+  ParGridContainer& grids = _par_target->getGrids();
+  for (size_t i = 0; i < grids.size(); ++i) {
+    grids[i]->setParElement(NULL);
+    grids[i]->save();
+  }
+
+  ELE_ITER ele_iter = _par_netlist->element_begin();
+  for (; ele_iter != _par_netlist->element_end(); ++ele_iter) {
+    ParElement* element = *ele_iter;
+    PLACE_LOCS::const_iterator loc_iter = locations.find(element->getName());
+    if (loc_iter == locations.end())
+      qlog.speakError("Element %s is not in %s", element->getName().c_str(), filename.c_str());
+
+    ParGrid* grid = _par_target->getGrid(loc_iter->second.first, loc_iter->second.second);
+    if (!grid || !grid->canBePlaced() || grid->getCurrentElement())
+      qlog.speakError("Element %s cannot be placed at (%ld, %ld)",
+          element->getName().c_str(), loc_iter->second.first, loc_iter->second.second);
+
+    element->setGrid(grid);
+    element->save();
+    grid->setParElement(element);
+    grid->save();
+    element->updatePlacement();
+  }
+
+  WIRE_ITER w_iter = _par_netlist->wire_begin();
+  for (; w_iter != _par_netlist->wire_end(); ++w_iter)
+    (*w_iter)->initializeBoundingBox();
+
+  qlog.speak("Place", "Read placement of %lu elements from %s",
+      _par_netlist->getElementNumber(), filename.c_str());
+  _status.hasPlaced = true;
+}
+
+void ParSystem::doRoute(const RouteOption& option) {
+  if (!_status.hasPlaced)
     qlog.speakError("Cannot run routing because netlist has not been placed");
+
+  ParRouteCongestion* congestion = NULL;
+  for (unsigned feedback = 0; !routeNetlist(option, feedback == 0); ++feedback) {
+    if (feedback == option.feedback)
+      qlog.speakError("Routing Failed");
+
+    // the congestion is kept on grids, the routing graph belongs to the old placement
+    if (!congestion)
+      congestion = new ParRouteCongestion(_par_target->getXLimit(), _par_target->getYLimit());
+    congestion->addRouting(*_routing_graph);
+    qlog.speak("Route", "Routing failed, refine placement with routing congestion %.0f (%u of %u)",
+        congestion->getTotalCongestion(), feedback + 1, option.feedback);
+
+    _par_netlist->clearRoutes();
+    delete _fast_routing_graph;
+    delete _routing_graph;
+    _fast_routing_graph = NULL;
+    _routing_graph = NULL;
+
+    refinePlacement(*congestion);
+  }
+
+  if (congestion)
+    delete congestion;
+  _status.hasRouted = true;
+}
+
+bool ParSystem::routeNetlist(const RouteOption& option, bool use_eco) {
+  QASSERT(_routing_graph == NULL && _fast_routing_graph == NULL);
+  _routing_graph = new RoutingGraph(_hw_target, _par_target);
+  _fast_routing_graph = new FastRoutingGraph(_routing_graph);
+  if (use_eco && !option.eco_file.empty()) {
+    ParEco eco(_par_netlist, _par_target);
+    eco.restoreRoutes(option.eco_file, _routing_graph);
   }
+
+  RouteOption route_option = option;
+  if (!use_eco)
+    route_option.eco_file.clear();
+  QRoute router(_par_netlist, _routing_graph, _fast_routing_graph, route_option);
+  if (!router.run())
+    return false;
+  router.printAllRoute("final.route");
+  return true;
+}
+
+void ParSystem::refinePlacement(const ParRouteCongestion& congestion) {
+  PlaceOption option = _place_option ? *_place_option : PlaceOption();
+  option.eco_file.clear();
+  option.replicas = 1;
+  option.starts = 1;
+  option.warm_t = 0.0f;
+  option.refine_t = route_feedback_t;
+
+  QPlace placer(_par_netlist, _par_target, option);
+  placer.setRouteCongestion(&congestion);
+  placer.run();
+  placer.dumpCurrentPlacement("final.place");
 }
 
 
@@ -47,8 +47,8 @@ HW_Loc ParGrid::getLoc() const {
   return _cell->getLoc();
 }
 
-void ParGridContainer::shuffle() {
-  std::mt19937 gen(0);
+void ParGridContainer::shuffle(unsigned seed) {
+  std::mt19937 gen(seed);
   std::shuffle(SUPER::begin(), SUPER::end(), gen);
 }
 
@@ -23,6 +23,8 @@
 #include "qpar/qpar_netlist.hh"
 #include "qpar/qpar_system.hh"
 #include "qpar/qpar_routing_test.hh"
+#include "qpar/qpar_place.hh"
+#include "qpar/qpar_route.hh"
 
 #include "syn/blif.h"
 #include "utils/qlog.hh"
@@ -90,7 +92,7 @@ int QCOMMAND_init_system::execute(int argc, const char** argv, std::string& resu
 }
 
 std::string QCOMMAND_place::help() const {
-  const std::string msg = "place";
+  const std::string msg = "place [-occupancy <prefix|fenwick>] [-threads <int>] [-seed <int>] [-replicas <int>] [-starts <int>] [-init <random|quadratic|multilevel>] [-eco <filename>] [-warm_t <double>] [-moves <uniform|adaptive>] [-cost <batch|scalar>] [-timing <double>] [-schedule <default|vpr|lam|budget>] [-budget <double>]";
   return msg;
 }
 
@@ -102,7 +104,233 @@ int QCOMMAND_place::execute(int argc, const char** argv, std::string& result, Cl
     return TCL_OK;
   }
 
-  ParSystem::getParSystem()->doPlacement();
+  PlaceOption option;
+
+  if (isOptionExist(argc, argv, "-occupancy")) {
+    std::string occupancy;
+    if (!getStringOption(argc, argv, "-occupancy", occupancy) ||
+        !ParOccupancy::getType(occupancy, option.occupancy)) {
+      printHelp();
+      return TCL_OK;
+    }
+  }
+
+  if (isOptionExist(argc, argv, "-threads")) {
+    int threads = 0;
+    if (!getIntOption(argc, argv, "-threads", threads) || threads < 1) {
+      printHelp();
+      return TCL_OK;
+    }
+    option.threads = (unsigned)threads;
+  }
+
+  if (isOptionExist(argc, argv, "-seed")) {
+    if (!getIntOption(argc, argv, "-seed", option.seed)) {
+      printHelp();
+      return TCL_OK;
+    }
+  }
+
+  if (isOptionExist(argc, argv, "-replicas")) {
+    int replicas = 0;
+    if (!getIntOption(argc, argv, "-replicas", replicas) || replicas < 1) {
+      printHelp();
+      return TCL_OK;
+    }
+    option.replicas = (unsigned)replicas;
+  }
+
+  if (isOptionExist(argc, argv, "-starts")) {
+    int starts = 0;
+    if (!getIntOption(argc, argv, "-starts", starts) || starts < 1) {
+      printHelp();
+      return TCL_OK;
+    }
+    option.starts = (unsigned)starts;
+  }
+
+  if (isOptionExist(argc, argv, "-init")) {
+    std::string init;
+    if (!getStringOption(argc, argv, "-init", init)) {
+      printHelp();
+      return TCL_OK;
+    }
+
+    if (init == "random") {
+      option.init = PlaceOption::INIT_RANDOM;
+    } else if (init == "quadratic") {
+      option.init = PlaceOption::INIT_QUADRATIC;
+    } else if (init == "multilevel") {
+      option.init = PlaceOption::INIT_MULTILEVEL;
+    } else {
+      printHelp();
+      return TCL_OK;
+    }
+  }
+
+  if (isOptionExist(argc, argv, "-eco")) {
+    if (!getStringOption(argc, argv, "-eco", option.eco_file)) {
+      printHelp();
+      return TCL_OK;
+    }
+  }
+
+  if (isOptionExist(argc, argv, "-warm_t")) {
+    double warm_t = 0.0;
+    if (!getDoubleOption(argc, argv, "-warm_t", warm_t) || warm_t <= 0.0) {
+      printHelp();
+      return TCL_OK;
+    }
+    option.warm_t = (float)warm_t;
+  }
+
+  if (isOptionExist(argc, argv, "-moves")) {
+    std::string moves;
+    if (!getStringOption(argc, argv, "-moves", moves)) {
+      printHelp();
+      return TCL_OK;
+    }
+
+    if (moves == "uniform") {
+      option.moves = PlaceOption::MOVES_UNIFORM;
+    } else if (moves == "adaptive") {
+      option.moves = PlaceOption::MOVES_ADAPTIVE;
+    } else {
+      printHelp();
+      return TCL_OK;
+    }
+  }
+
+  if (isOptionExist(argc, argv, "-cost")) {
+    std::string cost;
+    if (!getStringOption(argc, argv, "-cost", cost)) {
+      printHelp();
+      return TCL_OK;
+    }
+
+    if (cost == "batch") {
+      option.scalar_cost = false;
+    } else if (cost == "scalar") {
+      option.scalar_cost = true;
+    } else {
+      printHelp();
+      return TCL_OK;
+    }
+  }
+
+  if (isOptionExist(argc, argv, "-timing")) {
+    if (!getDoubleOption(argc, argv, "-timing", option.timing) || option.timing < 0.0) {
+      printHelp();
+      return TCL_OK;
+    }
+  }
+
+  if (isOptionExist(argc, argv, "-schedule")) {
+    std::string schedule;
+    if (!getStringOption(argc, argv, "-schedule", schedule) ||
+        !ParSchedule::getType(schedule, option.schedule)) {
+      printHelp();
+      return TCL_OK;
+    }
+  }
+
+  if (isOptionExist(argc, argv, "-budget")) {
+    if (!getDoubleOption(argc, argv, "-budget", option.budget) || option.budget <= 0.0) {
+      printHelp();
+      return TCL_OK;
+    }
+  }
+
+  if (option.schedule == ParSchedule::SCHEDULE_BUDGET && option.budget <= 0.0) {
+    qlog.speakError("Budget schedule needs -budget <seconds>");
+    return TCL_OK;
+  }
+
+  ParSystem::getParSystem()->doPlacement(option);
+
+  return TCL_OK;
+}
+
+std::string QCOMMAND_bench_place::help() const {
+  const std::string msg = "bench_place [-moves <int>] [-t <double>] [-seed <int>] [-cost <batch|scalar>]";
+  return msg;
+}
+
+int QCOMMAND_bench_place::execute(int argc, const char** argv, std::string& result, ClientData clientData) {
+  result = "OK";
+
+  if (!checkOptions(argc, argv)) {
+    printHelp();
+    return TCL_OK;
+  }
+
+  PlaceOption option;
+  int num_move = 1000000;
+  double temperature = 1.0;
+
+  if (isOptionExist(argc, argv, "-moves")) {
+    if (!getIntOption(argc, argv, "-moves", num_move) || num_move < 1) {
+      printHelp();
+      return TCL_OK;
+    }
+  }
+
+  if (isOptionExist(argc, argv, "-t")) {
+    if (!getDoubleOption(argc, argv, "-t", temperature) || temperature <= 0.0) {
+      printHelp();
+      return TCL_OK;
+    }
+  }
+
+  if (isOptionExist(argc, argv, "-seed")) {
+    if (!getIntOption(argc, argv, "-seed", option.seed)) {
+      printHelp();
+      return TCL_OK;
+    }
+  }
+
+  if (isOptionExist(argc, argv, "-cost")) {
+    std::string cost;
+    if (!getStringOption(argc, argv, "-cost", cost)) {
+      printHelp();
+      return TCL_OK;
+    }
+
+    if (cost == "batch") {
+      option.scalar_cost = false;
+    } else if (cost == "scalar") {
+      option.scalar_cost = true;
+    } else {
+      printHelp();
+      return TCL_OK;
+    }
+  }
+
+  if (!ParSystem::getParSystem())
+    qlog.speakError("QPAR: system is not initialized");
+
+  ParSystem::getParSystem()->benchPlacement(option, num_move, (float)temperature);
+
+  return TCL_OK;
+}
+
+std::string QCOMMAND_read_placement::help() const {
+  const std::string msg = "read_placement <filename>";
+  return msg;
+}
+
+int QCOMMAND_read_placement::execute(int argc, const char** argv, std::string& result, ClientData clientData) {
+  result = "OK";
+
+  if (!checkOptions(argc, argv) || argc != 2) {
+    printHelp();
+    return TCL_OK;
+  }
+
+  if (!ParSystem::getParSystem())
+    qlog.speakError("QPAR: system is not initialized");
+
+  ParSystem::getParSystem()->readPlacement(argv[1]);
 
   return TCL_OK;
 }
@@ -123,13 +351,14 @@ int QCOMMAND_check_routing_graph::execute(int argc, const char** argv, std::stri
 
   RoutingTester tester(ParSystem::getParSystem());
   tester.testRoutingGraph();
+  tester.testBidirectionalRoute();
 
   return TCL_OK;
 
 }
 
 std::string QCOMMAND_route::help() const {
-  const std::string msg = "route";
+  const std::string msg = "route [-eco <filename>] [-feedback <int>] [-threads <int>] [-astar_fac <double>] [-window <int>] [-bidir] [-steiner]";
   return msg;
 }
 
@@ -142,7 +371,68 @@ int QCOMMAND_route::execute(int argc, const char** argv, std::string& result, Cl
     return TCL_OK;
   }
 
-  ParSystem::getParSystem()->doRoute();
+  RouteOption option;
+
+  if (isOptionExist(argc, argv, "-eco")) {
+    if (!getStringOption(argc, argv, "-eco", option.eco_file)) {
+      printHelp();
+      return TCL_OK;
+    }
+  }
+
+  if (isOptionExist(argc, argv, "-feedback")) {
+    int feedback = 0;
+    if (!getIntOption(argc, argv, "-feedback", feedback) || feedback < 0) {
+      printHelp();
+      return TCL_OK;
+    }
+    option.feedback = (unsigned)feedback;
+  }
+
+  if (isOptionExist(argc, argv, "-threads")) {
+    int threads = 0;
+    if (!getIntOption(argc, argv, "-threads", threads) || threads < 1) {
+      printHelp();
+      return TCL_OK;
+    }
+    option.threads = (unsigned)threads;
+  }
+
+  if (isOptionExist(argc, argv, "-astar_fac")) {
+    if (!getDoubleOption(argc, argv, "-astar_fac", option.astar_fac) || option.astar_fac < 0.0) {
+      printHelp();
+      return TCL_OK;
+    }
+  }
+
+  if (isOptionExist(argc, argv, "-window")) {
+    if (!getIntOption(argc, argv, "-window", option.window) || option.window < 0) {
+      printHelp();
+      return TCL_OK;
+    }
+  }
+
+  // an overestimating search from both ends can meet on a path with a loop
+  if (isOptionExist(argc, argv, "-bidir")) {
+    if (option.astar_fac > 1.0) {
+      qlog.speak("Route", "-bidir needs -astar_fac no larger than 1");
+      printHelp();
+      return TCL_OK;
+    }
+    option.bidir = true;
+  }
+
+  // a tree is grown by dijkstra toward every sink at once
+  if (isOptionExist(argc, argv, "-steiner")) {
+    if (option.astar_fac > 0.0 || option.window >= 0 || option.bidir) {
+      qlog.speak("Route", "-steiner cannot be used with -astar_fac, -window or -bidir");
+      printHelp();
+      return TCL_OK;
+    }
+    option.steiner = true;
+  }
+
+  ParSystem::getParSystem()->doRoute(option);
 
   return TCL_OK;
 
@@ -0,0 +1,228 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+/*!
+ * \file qpar_tempering.cc
+ * \author Juexiao Su
+ * \date 13 Feb 2018
+ * \brief parallel tempering (replica exchange) placement
+ */
+
+#include "qpar/qpar_tempering.hh"
+#include "qpar/qpar_place.hh"
+#include "qpar/qpar_netlist.hh"
+#include "qpar/qpar_target.hh"
+#include "qpar/qpar_thread_pool.hh"
+
+#include "utils/qlog.hh"
+
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <cmath>
+#include <chrono>
+
+// number of sweeps, each replica tries about as many moves as the annealer
+static const int tempering_sweep_num = 120;
+
+// coldest temperature in unit of the initial cost per wire
+static const float tempering_cold_t = 0.02f;
+
+// ratio between neighbouring temperatures, the total cost is extensive so
+// neighbours have to be close for the exchanges to be accepted
+static const float tempering_ladder_ratio = 1.05f;
+
+// the ladder starts this many times hotter and settles during the first sweeps
+static const float tempering_warm_scale = 30.0f;
+static const int tempering_warm_sweep_num = 36;
+
+
+ParTempering::ParTempering(SYN::Model* model, HW_Target_Dwave* hw_target,
+    ParNetlist* netlist, ParTarget* target, const PlaceOption& option) :
+  _model(model),
+  _hw_target(hw_target),
+  _option(option),
+  _sweep_moves(0),
+  _scale(1.0f),
+  _thread_pool(NULL),
+  _random_gen(option.seed) {
+
+  QASSERT(_option.replicas > 1);
+  _netlists.push_back(netlist);
+  _targets.push_back(target);
+  for (unsigned i = 1; i < _option.replicas; ++i) {
+    ParTarget* replica_target = new ParTarget(_hw_target);
+    replica_target->initParTarget();
+    _targets.push_back(replica_target);
+    _netlists.push_back(new ParNetlist(_model));
+  }
+
+  // each replica anneals with a single thread and its own random sequence
+  for (unsigned i = 0; i < _option.replicas; ++i) {
+    PlaceOption replica_option = _option;
+    replica_option.threads = 1;
+    replica_option.replicas = 1;
+    replica_option.seed = _option.seed + (int)i;
+    _placers.push_back(new QPlace(_netlists[i], _targets[i], replica_option));
+  }
+}
+
+ParTempering::~ParTempering() {
+  for (size_t i = 0; i < _placers.size(); ++i)
+    delete _placers[i];
+  _placers.clear();
+
+  for (size_t i = 1; i < _netlists.size(); ++i)
+    delete _netlists[i];
+  _netlists.clear();
+
+  for (size_t i = 1; i < _targets.size(); ++i)
+    delete _targets[i];
+  _targets.clear();
+
+  if (_thread_pool)
+    delete _thread_pool;
+  _thread_pool = NULL;
+}
+
+void ParTempering::run() {
+  std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+  unsigned replica_num = _option.replicas;
+
+  // initialization logs, keep it on this thread
+  for (unsigned i = 0; i < replica_num; ++i)
+    _placers[i]->initialize();
+
+  _placers[0]->dumpCurrentPlacement("init.place");
+
+  float unit_cost = (float)_placers[0]->getTotalCost() / (float)_placers[0]->getWireNum();
+  float cold_t = tempering_cold_t * unit_cost;
+  float max_r = _placers[0]->getRLimit();
+  for (unsigned i = 0; i < replica_num; ++i) {
+    _temperatures.push_back(cold_t * std::pow(tempering_ladder_ratio, (float)i));
+    _radius.push_back(max_r);
+    _replica_at.push_back(i);
+    _success_num.push_back(0);
+  }
+
+  _sweep_moves = std::max(_placers[0]->getMoveLimit() / 4, 1);
+
+  unsigned thread_num = std::min(_option.threads > 1 ? _option.threads : replica_num, replica_num);
+  _thread_pool = new ParThreadPool(thread_num);
+  qlog.speak("Place", "Parallel tempering with %u replicas on %u threads, T from %.4g to %.4g",
+      replica_num, thread_num, _temperatures.front(), _temperatures.back());
+
+  std::stringstream print_sep;
+  print_sep << "+";
+  print_sep << std::setfill('-') << std::setw(10) << "+";
+  print_sep << std::setfill('-') << std::setw(10) << "+";
+  print_sep << std::setfill('-') << std::setw(10) << "+";
+  print_sep << std::setfill('-') << std::setw(10) << "+";
+  print_sep << std::setfill('-') << std::setw(10) << "+";
+  qlog.speak("Place", "%s", print_sep.str().c_str());
+
+  std::stringstream print_log;
+  print_log << "|";
+  print_log << std::setw(10) << "Sweep|";
+  print_log << std::setw(10) << "ColdCost|";
+  print_log << std::setw(10) << "BestCost|";
+  print_log << std::setw(10) << "ColdSuccR|";
+  print_log << std::setw(10) << "SwapR|";
+  qlog.speak("Place", "%s", print_log.str().c_str());
+  qlog.speak("Place", "%s", print_sep.str().c_str());
+
+  unsigned swap_num = 0;
+  unsigned swap_try = 0;
+  for (int sweep = 1; sweep <= tempering_sweep_num; ++sweep) {
+    if (sweep < tempering_warm_sweep_num)
+      _scale = std::pow(tempering_warm_scale, 1.0f - (float)sweep / (float)tempering_warm_sweep_num);
+    else
+      _scale = 1.0f;
+
+    _thread_pool->run(std::bind(&ParTempering::annealReplicas, this, std::placeholders::_1));
+
+    unsigned parity = (unsigned)(sweep % 2);
+    swap_num += exchangeReplicas(parity);
+    swap_try += (replica_num - parity) / 2;
+
+    if (sweep % 10 == 0 || sweep == tempering_sweep_num) {
+      double best_cost = _placers[0]->getTotalCost();
+      for (unsigned i = 1; i < replica_num; ++i)
+        best_cost = std::min(best_cost, _placers[i]->getTotalCost());
+
+      std::stringstream place_stat;
+      place_stat << "|";
+      place_stat << std::setw(9) << sweep << "|";
+      place_stat << std::setw(9) << std::setprecision(4) << _placers[_replica_at[0]]->getTotalCost();
+      place_stat << "|";
+      place_stat << std::setw(9) << std::setprecision(4) << best_cost;
+      place_stat << "|";
+      place_stat << std::setw(9) << std::setprecision(4) << (float)_success_num[0] / (float)_sweep_moves;
+      place_stat << "|";
+      place_stat << std::setw(9) << std::setprecision(4) << (swap_try ? (float)swap_num / (float)swap_try : 0.0f);
+      place_stat << "|";
+      qlog.speak("Place", "%s", place_stat.str().c_str());
+      swap_num = 0;
+      swap_try = 0;
+    }
+  }
+  qlog.speak("Place", "%s", print_sep.str().c_str());
+
+  unsigned best = 0;
+  for (unsigned i = 1; i < replica_num; ++i)
+    if (_placers[i]->getTotalCost() < _placers[best]->getTotalCost())
+      best = i;
+  qlog.speak("Place", "Replica %u has the best cost %.6f", best, _placers[best]->getTotalCost());
+
+  if (best != 0)
+    _placers[0]->copyPlacement(*_placers[best]);
+  _placers[0]->finish();
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+  qlog.speak("Place", "Placement finished in %.2f seconds", elapsed.count());
+}
+
+void ParTempering::annealReplicas(unsigned thread_id) {
+  unsigned thread_num = _thread_pool->getThreadNum();
+  for (unsigned t = thread_id; t < _temperatures.size(); t += thread_num) {
+    QPlace* placer = _placers[_replica_at[t]];
+    placer->setRLimit(_radius[t]);
+    _success_num[t] = placer->anneal(_scale * _temperatures[t], _sweep_moves);
+    _radius[t] = placer->getRLimit();
+  }
+}
+
+unsigned ParTempering::exchangeReplicas(unsigned parity) {
+  unsigned swap_num = 0;
+  for (unsigned t = parity; t + 1 < _temperatures.size(); t += 2) {
+    double cold_cost = _placers[_replica_at[t]]->getTotalCost();
+    double hot_cost = _placers[_replica_at[t + 1]]->getTotalCost();
+    double delta = (1.0 / _temperatures[t] - 1.0 / _temperatures[t + 1]) * (cold_cost - hot_cost) / _scale;
+    if (delta >= 0 || _random_gen.fRand(0.0, 1.0) < std::exp(delta)) {
+      std::swap(_replica_at[t], _replica_at[t + 1]);
+      ++swap_num;
+    }
+  }
+  return swap_num;
+}
+
+void ParTempering::dumpCurrentPlacement(std::string filename) const {
+  _placers[0]->dumpCurrentPlacement(filename);
+}
@@ -0,0 +1,91 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+/*!
+ * \file qpar_thread_pool.cc
+ * \author Juexiao Su
+ * \date 09 Feb 2018
+ * \brief a fixed set of worker threads that run the same job together
+ */
+
+#include "qpar/qpar_thread_pool.hh"
+
+#include "utils/qlog.hh"
+
+
+ParThreadPool::ParThreadPool(unsigned thread_num) :
+  _thread_num(thread_num),
+  _job(NULL),
+  _job_index(0),
+  _running(0),
+  _stop(false) {
+  QASSERT(_thread_num > 0);
+  for (unsigned i = 1; i < _thread_num; ++i)
+    _workers.push_back(std::thread(&ParThreadPool::workerLoop, this, i));
+}
+
+ParThreadPool::~ParThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _start_cond.notify_all();
+
+  for (size_t i = 0; i < _workers.size(); ++i)
+    _workers[i].join();
+}
+
+void ParThreadPool::run(const JOB& job) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    QASSERT(_running == 0);
+    _job = &job;
+    _running = _thread_num - 1;
+    ++_job_index;
+  }
+  _start_cond.notify_all();
+
+  job(0);
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (_running > 0)
+    _finish_cond.wait(lock);
+  _job = NULL;
+}
+
+void ParThreadPool::workerLoop(unsigned thread_id) {
+  unsigned done_index = 0;
+  while (true) {
+    const JOB* job = NULL;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      while (!_stop && _job_index == done_index)
+        _start_cond.wait(lock);
+      if (_stop) return;
+      done_index = _job_index;
+      job = _job;
+    }
+
+    (*job)(thread_id);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (--_running == 0)
+      _finish_cond.notify_one();
+  }
+}
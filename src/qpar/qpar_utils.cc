@@ -18,6 +18,7 @@
  ****************************************************************************/
 
 #include "qpar/qpar_utils.hh"
+#include "qpar/qpar_schedule.hh"
 
 #include <cmath>
 
@@ -45,21 +46,41 @@ float RandomGenerator::fRand(float min, float max) {
 }
 
 
+Annealer::Annealer(float init_t, float b_factor, float r_max, int seed) :
+  _initial_t(init_t),
+  _current_t(init_t),
+  _radius_max(r_max),
+  _radius_limit(r_max),
+  _boltzmann(b_factor) {
+    _rand = new RandomGenerator(seed);
+    _schedule = new DefaultSchedule;
+}
+
+Annealer::~Annealer() {
+  if (_rand) delete _rand;
+  _rand = NULL;
+
+  if (_schedule) delete _schedule;
+  _schedule = NULL;
+}
+
+void Annealer::setSchedule(ParSchedule* schedule) {
+  if (_schedule) delete _schedule;
+  _schedule = schedule;
+}
+
 void Annealer::updateT(float sr) {
-  if (sr > annealer_step_1)
-    _current_t *= annealer_cool_speed1;
-  else if (sr > annealer_step_2)
-    _current_t *= annealer_cool_speed2;
-  else if (sr > annealer_step_3 || _radius_limit > 1.f)
-    _current_t *= annealer_cool_speed3;
-  else
-    _current_t *= annealer_cool_speed4;
+  AnnealStat stat;
+  stat.success_rate = sr;
+  updateT(stat);
+}
+
+void Annealer::updateT(const AnnealStat& stat) {
+  _current_t = _schedule->updateT(_current_t, _radius_limit, stat);
 }
 
 void Annealer::updateMoveRadius(float sr) {
-  _radius_limit *= (1.0f - annealer_best_rate + sr);
-  _radius_limit = std::min(_radius_limit, _radius_max);
-  _radius_limit = std::max(_radius_limit, 1.0f);
+  _radius_limit = _schedule->updateRLimit(_radius_limit, _radius_max, sr);
 }
 
 
@@ -78,7 +99,7 @@ bool Annealer::shouldAccept(double delta_c) {
 }
 
 bool Annealer::shouldExit(float unit_cost) {
-  return (_current_t < 0.08 * unit_cost);
+  return _schedule->shouldExit(_current_t, unit_cost);
 }
 
 bool Box::isInBox(int x, int y) const {
@@ -0,0 +1,201 @@
+/****************************************************************************
+ * Copyright (C) 2017 by Juexiao Su                                         *
+ *                                                                          *
+ * This file is part of QSat.                                               *
+ *                                                                          *
+ *   QSat is free software: you can redistribute it and/or modify it        *
+ *   under the terms of the GNU Lesser General Public License as published  *
+ *   by the Free Software Foundation, either version 3 of the License, or   *
+ *   (at your option) any later version.                                    *
+ *                                                                          *
+ *   QSat is distributed in the hope that it will be useful,                *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU Lesser General Public License for more details.                    *
+ *                                                                          *
+ *   You should have received a copy of the GNU Lesser General Public       *
+ *   License along with QSat.  If not, see <http://www.gnu.org/licenses/>.  *
+ ****************************************************************************/
+
+/*!
+ * \file qpar_wire_index.cc
+ * \author Juexiao Su
+ * \date 02 Feb 2018
+ * \brief spatial index from chimera cell to the wires whose bounding box covers it
+ */
+
+#include "qpar/qpar_wire_index.hh"
+#include "qpar/qpar_place_db.hh"
+
+#include "utils/qlog.hh"
+
+#include <algorithm>
+
+
+ParWireIndex::ParWireIndex(ParPlaceDB* place_db, COORD x_limit, COORD y_limit, unsigned bucket_size) :
+  _place_db(place_db),
+  _bucket_size(std::max(bucket_size, 1u)) {
+  QASSERT(x_limit > 0 && y_limit > 0);
+  _bucket_num_x = (int)((x_limit + _bucket_size - 1) / _bucket_size);
+  _bucket_num_y = (int)((y_limit + _bucket_size - 1) / _bucket_size);
+  _buckets.resize((size_t)(_bucket_num_x * _bucket_num_y));
+  _entries.resize(_place_db->getWireNum());
+}
+
+unsigned ParWireIndex::getDefaultBucketSize(COORD x_limit, COORD y_limit) {
+  COORD max_limit = std::max(x_limit, y_limit);
+  return (unsigned)std::max((COORD)1, (max_limit + 15) / 16);
+}
+
+ParWireIndex::WireEntry& ParWireIndex::getEntry(unsigned wire) {
+  QASSERT(wire < _entries.size());
+  return _entries[wire];
+}
+
+void ParWireIndex::getBucketRange(unsigned wire, int& bxl, int& bxr, int& byt, int& byb) const {
+  const Box& bbox = _place_db->getBox(wire);
+  QASSERT(bbox.xl() >= 0 && bbox.yt() >= 0);
+  bxl = bbox.xl() / (int)_bucket_size;
+  bxr = std::min(bbox.xr() / (int)_bucket_size, _bucket_num_x - 1);
+  byt = bbox.yt() / (int)_bucket_size;
+  byb = std::min(bbox.yb() / (int)_bucket_size, _bucket_num_y - 1);
+}
+
+void ParWireIndex::removeFromBucket(int bx, int by, unsigned slot) {
+  std::vector<unsigned>& bucket = _buckets[bucketIndex(bx, by)];
+  QASSERT(slot < bucket.size());
+
+  unsigned last = bucket.back();
+  bucket[slot] = last;
+  bucket.pop_back();
+
+  if (slot < bucket.size()) {
+    WireEntry& last_entry = _entries[last];
+    last_entry.slots[last_entry.slotIndex(bx, by)] = slot;
+  }
+}
+
+void ParWireIndex::insertWire(unsigned wire) {
+  WireEntry& entry = getEntry(wire);
+  QASSERT(!entry.registered);
+
+  getBucketRange(wire, entry.bxl, entry.bxr, entry.byt, entry.byb);
+  entry.slots.clear();
+  for (int by = entry.byt; by <= entry.byb; ++by) {
+    for (int bx = entry.bxl; bx <= entry.bxr; ++bx) {
+      std::vector<unsigned>& bucket = _buckets[bucketIndex(bx, by)];
+      entry.slots.push_back((unsigned)bucket.size());
+      bucket.push_back(wire);
+    }
+  }
+  entry.registered = true;
+}
+
+void ParWireIndex::removeWire(unsigned wire) {
+  WireEntry& entry = getEntry(wire);
+  if (!entry.registered) return;
+
+  for (int by = entry.byt; by <= entry.byb; ++by)
+    for (int bx = entry.bxl; bx <= entry.bxr; ++bx)
+      removeFromBucket(bx, by, entry.slots[entry.slotIndex(bx, by)]);
+
+  entry.slots.clear();
+  entry.registered = false;
+}
+
+void ParWireIndex::updateWire(unsigned wire) {
+  WireEntry& entry = getEntry(wire);
+  if (!entry.registered) return;
+
+  int bxl, bxr, byt, byb;
+  getBucketRange(wire, bxl, bxr, byt, byb);
+
+  // most moves keep the bounding box in the same buckets
+  if (bxl == entry.bxl && bxr == entry.bxr && byt == entry.byt && byb == entry.byb)
+    return;
+
+  WireEntry new_entry;
+  new_entry.bxl = bxl;
+  new_entry.bxr = bxr;
+  new_entry.byt = byt;
+  new_entry.byb = byb;
+  new_entry.registered = true;
+
+  // 1) leave the buckets that are no longer covered
+  for (int by = entry.byt; by <= entry.byb; ++by)
+    for (int bx = entry.bxl; bx <= entry.bxr; ++bx)
+      if (!new_entry.covers(bx, by))
+        removeFromBucket(bx, by, entry.slots[entry.slotIndex(bx, by)]);
+
+  // 2) keep the slots of shared buckets, join the newly covered ones
+  for (int by = byt; by <= byb; ++by) {
+    for (int bx = bxl; bx <= bxr; ++bx) {
+      if (entry.covers(bx, by)) {
+        new_entry.slots.push_back(entry.slots[entry.slotIndex(bx, by)]);
+      } else {
+        std::vector<unsigned>& bucket = _buckets[bucketIndex(bx, by)];
+        new_entry.slots.push_back((unsigned)bucket.size());
+        bucket.push_back(wire);
+      }
+    }
+  }
+
+  entry = new_entry;
+}
+
+void ParWireIndex::collectWires(COORD x, COORD y, unsigned stamp, std::vector<unsigned>& wires) {
+  int bx = (int)x / (int)_bucket_size;
+  int by = (int)y / (int)_bucket_size;
+  QASSERT(bx < _bucket_num_x && by < _bucket_num_y);
+
+  const std::vector<unsigned>& bucket = _buckets[bucketIndex(bx, by)];
+  for (size_t i = 0; i < bucket.size(); ++i) {
+    unsigned wire = bucket[i];
+    if (_place_db->isInBox(wire, x, y) && _place_db->markMove(wire, stamp))
+      wires.push_back(wire);
+  }
+}
+
+void ParWireIndex::collectWires(COORD x, COORD y, std::vector<unsigned>& wires) const {
+  int bx = (int)x / (int)_bucket_size;
+  int by = (int)y / (int)_bucket_size;
+  QASSERT(bx < _bucket_num_x && by < _bucket_num_y);
+
+  const std::vector<unsigned>& bucket = _buckets[bucketIndex(bx, by)];
+  for (size_t i = 0; i < bucket.size(); ++i) {
+    unsigned wire = bucket[i];
+    if (_place_db->isInBox(wire, x, y))
+      wires.push_back(wire);
+  }
+}
+
+bool ParWireIndex::sanityCheck() const {
+  for (unsigned wire = 0; wire < _place_db->getWireNum(); ++wire) {
+    std::string name = _place_db->getWire(wire)->getName();
+    if (wire >= _entries.size() || !_entries[wire].registered) {
+      qlog.speak("Place", "Sanity Checking Net: %s is not in the wire index", name.c_str());
+      return false;
+    }
+
+    const WireEntry& entry = _entries[wire];
+    int bxl, bxr, byt, byb;
+    getBucketRange(wire, bxl, bxr, byt, byb);
+    if (bxl != entry.bxl || bxr != entry.bxr || byt != entry.byt || byb != entry.byb) {
+      qlog.speak("Place", "Sanity Checking Net: %s wire index is out of date", name.c_str());
+      return false;
+    }
+
+    for (int by = byt; by <= byb; ++by) {
+      for (int bx = bxl; bx <= bxr; ++bx) {
+        const std::vector<unsigned>& bucket = _buckets[bucketIndex(bx, by)];
+        unsigned slot = entry.slots[entry.slotIndex(bx, by)];
+        if (slot >= bucket.size() || bucket[slot] != wire) {
+          qlog.speak("Place", "Sanity Checking Net: %s has a wrong slot in wire index", name.c_str());
+          return false;
+        }
+      }
+    }
+  }
+
+  return true;
+}
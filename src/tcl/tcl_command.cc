@@ -142,6 +142,40 @@ bool QTclCommand::getIntOption(const int argc, const char** argv, const char* op
   return false;
 }
 
+bool QTclCommand::getDoubleOption(const int argc, const char** argv, const char* option_name, double& value) {
+  int i = getOptionIndex(argc, argv, option_name);
+  if (i > -1) {
+    if (i == (argc - 1)) {
+      qlog.speak("TCL", "A double value is expected after %s", option_name);
+      return false;
+    } else {
+      if (Tcl_GetDouble(NULL, argv[i+1], &value) == TCL_OK) {
+        return true;
+      } else {
+        qlog.speak("TCL", "A double value is expected after %s", option_name);
+        return false;
+      }
+    }
+  }
+  qlog.speak("TCL", "Invalid option name %s for %s command", option_name, _command_name.c_str());
+  return false;
+}
+
+bool QTclCommand::getStringOption(const int argc, const char** argv, const char* option_name, std::string& value) {
+  int i = getOptionIndex(argc, argv, option_name);
+  if (i > -1) {
+    if (i == (argc - 1)) {
+      qlog.speak("TCL", "A string value is expected after %s", option_name);
+      return false;
+    } else {
+      value = std::string(argv[i+1]);
+      return true;
+    }
+  }
+  qlog.speak("TCL", "Invalid option name %s for %s command", option_name, _command_name.c_str());
+  return false;
+}
+
 bool QTclCommand::isOptionExist(const int argc, const char** argv, const char* option_name) {
   if (getOptionIndex(argc, argv, option_name) > -1)
     return true;
@@ -54,9 +54,11 @@ void registerAllCommands() {
   //placement and routing related
   tcl_manager->registerCommand(new QCOMMAND_build_qpar_nl("build_qpar_nl", ""));
   tcl_manager->registerCommand(new QCOMMAND_init_system("init_system", ""));
-  tcl_manager->registerCommand(new QCOMMAND_place("place", ""));
+  tcl_manager->registerCommand(new QCOMMAND_place("place", "-occupancy <string> -threads <int> -seed <int> -replicas <int> -starts <int> -init <string> -eco <string> -warm_t <double> -moves <string> -cost <string> -timing <double> -schedule <string> -budget <double>"));
+  tcl_manager->registerCommand(new QCOMMAND_read_placement("read_placement", "<string>"));
+  tcl_manager->registerCommand(new QCOMMAND_bench_place("bench_place", "-moves <int> -t <double> -seed <int> -cost <string>"));
   tcl_manager->registerCommand(new QCOMMAND_check_routing_graph("check_routing_graph", ""));
-  tcl_manager->registerCommand(new QCOMMAND_route("route", ""));
+  tcl_manager->registerCommand(new QCOMMAND_route("route", "-eco <string> -feedback <int> -threads <int> -astar_fac <double> -window <int> -bidir -steiner"));
 
   //genrate config
   tcl_manager->registerCommand(new QCOMMAND_generate("generate", ""));
@@ -35,6 +35,7 @@ qLog qlog;  //!< global qLog class
 
 const unsigned BUFFER_SIZE = 4096;       //!< specify the max buffer size
 static char message_buffer[BUFFER_SIZE]; //!< message buffer
+static thread_local bool thread_quiet = false; //!< drop messages of this thread
 
 
 qLog::qLog() :
@@ -66,7 +67,7 @@ void qLog::setLogFile(const char* logFileName) {
 
 void qLog::speak(const char* step, const char* format, ...) {
 
-  if( _quiet)
+  if( _quiet || thread_quiet)
     return;
 
   va_list ap;
@@ -105,6 +106,9 @@ void qLog::speakWarning(const char* format, ...) {
  
 void qLog::speak(const char* format, ...) {
 
+  if (thread_quiet)
+    return;
+
   va_list ap;
   va_start(ap, format);
   vsnprintf(message_buffer, BUFFER_SIZE, format, ap);
@@ -124,6 +128,10 @@ void qLog::skipLine() {
   speak("============================================================================");
 }
 
+void qLog::setThreadQuiet(bool quiet) {
+  thread_quiet = quiet;
+}
+
 void qLog::openFile(const char* logFileName) {
 
   if (logFileName) {
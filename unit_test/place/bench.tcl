@@ -0,0 +1,27 @@
+#Author: Juexiao Su
+#Purpose: Measure moves per second of the placer
+
+puts "#########################################"
+puts "#        read blif netlist              #"
+puts "#########################################"
+set design $env(QSAT_HOME)/regression/blifs/alu2.blif
+read_blif $design
+gen_dwave_nl
+puts "\n"
+
+puts "#########################################"
+puts "#     initialize hardware target        #"
+puts "#########################################"
+init_target -row 50 -col 50 -local 8
+puts "\n"
+
+puts "#########################################"
+puts "#     initialize place and route        #"
+puts "#########################################"
+init_system 
+puts "\n"
+
+puts "#########################################"
+puts "#        benchmark placement moves      #"
+puts "#########################################"
+bench_place -moves 2000000 -t 1.0